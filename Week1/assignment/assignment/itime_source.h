@@ -1,6 +1,7 @@
 #ifndef LESSON_ITIMESOURCE_H
 #define LESSON_ITIMESOURCE_H
 
+#include <span>
 #include <string_view>
 
 namespace time_source
@@ -8,7 +9,8 @@ namespace time_source
     class itime_source 
     {
         public:
-            virtual std::string_view output_time() const = 0;
+            // formats the current time into buffer, the result views the written part of it
+            virtual std::string_view output_time(std::span<char> buffer) const = 0;
             virtual ~itime_source() = default;
     };
 }
@@ -16,8 +16,9 @@ namespace lib
 
     void logger::log(const std::string_view& msg) const 
     {
+        char buffer[16];
         *m_writer << '[';
-        *m_writer << timeSource->output_time();
+        *m_writer << timeSource->output_time(buffer);
         *m_writer << "]: " << msg << '\n';
     }
 
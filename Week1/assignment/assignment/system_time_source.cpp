@@ -3,12 +3,12 @@
 
 namespace time_source
 {
-    std::string_view system_time_source::output_time() const 
+    std::string_view system_time_source::output_time(std::span<char> buffer) const 
     {
         auto time_point = std::time(nullptr);
-        auto local_time = std::localtime(&time_point);
-        char buffer[16];
-        std::strftime(&buffer[0], sizeof(buffer),"%I:%M:%S", local_time);
-        return buffer;
+        std::tm local_time{};
+        localtime_r(&time_point, &local_time);
+        auto length = std::strftime(buffer.data(), buffer.size(), "%I:%M:%S", &local_time);
+        return {buffer.data(), length};
     }
 }
\ No newline at end of file
@@ -13,7 +13,7 @@ namespace time_source
     class system_time_source: public itime_source 
     {
         public:
-            std::string_view output_time() const override;
+            std::string_view output_time(std::span<char> buffer) const override;
         private:
             std::unique_ptr<lib::ilogger> m_logger;
     };
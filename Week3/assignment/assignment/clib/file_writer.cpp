@@ -22,6 +22,17 @@ void file_writer::write(const char* string) {
 void file_writer::write(char c) {
     write(c, m_file);
 }
+
+void file_writer::write(const char* data, std::size_t length) {
+    if (!m_file)
+        return;
+    std::fwrite(data, 1, length, m_file);
+}
+
+void file_writer::flush() {
+    if (m_file)
+        std::fflush(m_file);
+}
 void file_writer::write(const char* string, std::FILE* file) {
     if (!file)
         return;
@@ -5,6 +5,7 @@
 #ifndef LESSON_FILE_WRITER_H
 #define LESSON_FILE_WRITER_H
 
+#include <cstddef>
 #include <cstdio>
 #include "itext_writer.h"
 
@@ -17,6 +18,11 @@ public:
 
     virtual void write(const char* string) override;
 
+    // writes length bytes of data, which need not be NUL-terminated
+    void write(const char* data, std::size_t length);
+
+    void flush();
+
     virtual ~file_writer() override;
 
 
@@ -25,6 +25,7 @@ static const  char* FMT_TIME = "%y%m%d_%H%M%S.";
 #define LEN_TIME_PREFIX (14)
 #define SZ_FNAME (16)
 #define SZ_BUFFER (64)
+#define SZ_SUFFIX (LG_MAX_SUFFIX + 1)
 
 struct lg_logger {
     time_t interval_s;
@@ -35,6 +36,19 @@ struct lg_logger {
     time_t last_log;
     size_t count;
     char fname[SZ_FNAME];
+    char suffix[SZ_SUFFIX];
+
+    FILE* index;
+    size_t index_interval;
+    size_t offset;
+    size_t next_index_at;
+    char path[SZ_BUFFER];
+
+    lg_clock_fn clock;
+    void* clock_ctx;
+
+    lg_roll_fn on_roll;
+    void* roll_ctx;
 };
 
 enum {
@@ -43,14 +57,28 @@ enum {
 
 #define LG_COLLAPSE_ERROR(lgr) lgr = (lgr >= lgr_reserved)? lgr_error : lgr
 
-static lg_result_e _roll_file(lg_logger_t* log);
+static lg_result_e _roll_file(lg_logger_t* log, time_t now);
 static lg_result_e _open_next_file(lg_logger_t* log);
+static lg_result_e _close_files(lg_logger_t* log);
+static lg_result_e _write_index(lg_logger_t* log, time_t now);
+static time_t _now(const lg_logger_t* log);
+static void _report_closed(const lg_logger_t* log, size_t bytes);
 
 lg_result_e lg_create(lg_logger_t** log, time_t interval_s){
-    PRINT_ENTER();
+    return lg_create_shard(log, interval_s, NULL);
+}
+
+lg_result_e lg_create_shard(lg_logger_t** log, time_t interval_s, const char* suffix){
+    PRINT_ENTER("\n\tsuffix=%s", suffix? suffix : "");
 
     lg_result_e result = (*log)? lgr_invalid_argument : lgr_ok;
 
+    if (lgr_ok == result && suffix){
+        if (strlen(suffix) > LG_MAX_SUFFIX || strpbrk(suffix, "/.") || 0 == strcmp(suffix, "idx") || 0 == strcmp(suffix, "gz")){
+            result = lgr_invalid_argument;
+        }
+    }
+
     if (lgr_ok == result) {
         *log = malloc(sizeof(lg_logger_t));
         if (!*log) {
@@ -66,10 +94,24 @@ lg_result_e lg_create(lg_logger_t** log, time_t interval_s){
           .file = NULL,
           .last_log = time(NULL),
           .count = 0,
-          .fname = {0}
+          .fname = {0},
+          .suffix = {0},
+          .index = NULL,
+          .index_interval = LG_DEFAULT_INDEX_INTERVAL,
+          .offset = 0,
+          .next_index_at = 0,
+          .path = {0},
+          .clock = NULL,
+          .clock_ctx = NULL,
+          .on_roll = NULL,
+          .roll_ctx = NULL
         };
     }
 
+    if (lgr_ok == result && suffix){
+        strcpy(&(*log)->suffix[0], suffix);
+    }
+
     if (lgr_ok == result){
         struct tm* lt = localtime(&(*log)->last_log);
         // write the time prefix to the buffer is this is the first time
@@ -89,6 +131,9 @@ lg_result_e lg_create(lg_logger_t** log, time_t interval_s){
             if ((*log)->file){
                 fclose((*log)->file);
             }
+            if ((*log)->index){
+                fclose((*log)->index);
+            }
             free(*log);
             *log = NULL;
         }
@@ -113,20 +158,19 @@ lg_result_e lg_destroy(lg_logger_t** log){
     }
 
     if (lgr_ok == result) {
-        if (EOF == fflush((*log)->file)){
-            result = lgr_error;
-        }
-    }
-
-    if (lgr_ok == result) {
-        if (EOF == fclose((*log)->file)){
-            result = lgr_error;
-        }
+        size_t bytes = (*log)->offset;
+        result = _close_files(*log);
+        _report_closed(*log, bytes);
     }
 
     // unconditionally try to free the memory
     if (*log) {
-        (*log)->file = NULL;
+        if ((*log)->index){
+            fclose((*log)->index);
+        }
+        if ((*log)->file){
+            fclose((*log)->file);
+        }
         free(*log);
         *log = NULL;
     }
@@ -162,10 +206,54 @@ lg_result_e lg_set_append_newline(lg_logger_t* log, bool on_off){
 }
 
 
+lg_result_e lg_set_index_interval(lg_logger_t* log, size_t bytes){
+    PRINT_ENTER("\n\tbytes=%zu", bytes);
+
+    lg_result_e result = log? lgr_ok : lgr_error;
+
+    if (lgr_ok == result){
+        log->index_interval = bytes;
+        log->next_index_at = log->offset;
+    }
+    PRINT_EXIT();
+
+    return result;
+}
+
+lg_result_e lg_set_clock(lg_logger_t* log, lg_clock_fn clock, void* ctx){
+    PRINT_ENTER();
+
+    lg_result_e result = log? lgr_ok : lgr_error;
+
+    if (lgr_ok == result){
+        log->clock = clock;
+        log->clock_ctx = ctx;
+        log->last_log = _now(log);
+    }
+    PRINT_EXIT();
+
+    return result;
+}
+
+lg_result_e lg_set_roll_callback(lg_logger_t* log, lg_roll_fn on_roll, void* ctx){
+    PRINT_ENTER();
+
+    lg_result_e result = log? lgr_ok : lgr_error;
+
+    if (lgr_ok == result){
+        log->on_roll = on_roll;
+        log->roll_ctx = ctx;
+    }
+    PRINT_EXIT();
+
+    return result;
+}
+
 lg_result_e lg_log(lg_logger_t* log, const char* msg){
     PRINT_ENTER("\n\tmsg=%s", msg);
 
     lg_result_e result = log? lgr_ok : lgr_error;
+    time_t now = log? _now(log) : 0;
 
     if (lgr_ok == result){
         if (!log->file){
@@ -174,13 +262,21 @@ lg_result_e lg_log(lg_logger_t* log, const char* msg){
     }
 
     if (lgr_ok == result){
-        result = _roll_file(log);
+        result = _roll_file(log, now);
+    }
+
+    if (lgr_ok == result){
+        // a missing index entry only makes lookups slower, the record is written anyway
+        _write_index(log, now);
     }
 
     if (lgr_ok == result){
         if (EOF == fputs(msg, log->file)){
             result = lgr_error;
         }
+        else {
+            log->offset += strlen(msg);
+        }
     }
 
     if (lgr_ok == result){
@@ -188,6 +284,9 @@ lg_result_e lg_log(lg_logger_t* log, const char* msg){
             if (EOF == fputc('\n', log->file)) {
                 result = lgr_error;
             }
+            else {
+                ++log->offset;
+            }
         }
     }
 
@@ -200,6 +299,17 @@ lg_result_e lg_log(lg_logger_t* log, const char* msg){
 
     return result;
 }
+static time_t _now(const lg_logger_t* log){
+    return log->clock? log->clock(log->clock_ctx) : time(NULL);
+}
+
+static void _report_closed(const lg_logger_t* log, size_t bytes){
+    // path still holds the name of the closed file
+    if (log->on_roll){
+        log->on_roll(log->roll_ctx, &log->path[0], bytes);
+    }
+}
+
 static lg_result_e _open_next_file(lg_logger_t* log){
     PRINT_ENTER();
     lg_result_e result = log? lgr_ok : lgr_error;
@@ -208,12 +318,15 @@ static lg_result_e _open_next_file(lg_logger_t* log){
         result = log->file? lgr_error : lgr_ok;
     }
 
-    char buffer[SZ_BUFFER] = {0,};
+    char* buffer = &log->path[0];
 
     if (lgr_ok == result){
         size_t chars_written = LEN_TIME_PREFIX;
         strcpy(&buffer[0], &log->fname[0]);
         chars_written += sprintf(&buffer[LEN_TIME_PREFIX], "%zu", log->count);
+        if (log->suffix[0]){
+            chars_written += sprintf(&buffer[chars_written], ".%s", &log->suffix[0]);
+        }
         if (chars_written >= SZ_BUFFER){
             result = lgr_error;
         }
@@ -225,16 +338,82 @@ static lg_result_e _open_next_file(lg_logger_t* log){
             result = lgr_error;
         }
     }
+
+    if (lgr_ok == result){
+        // the first record of every file is indexed
+        log->offset = 0;
+        log->next_index_at = 0;
+    }
+    PRINT_EXIT();
+
+    return result;
+}
+
+static lg_result_e _close_files(lg_logger_t* log){
+    PRINT_ENTER();
+    lg_result_e result = (log && log->file)? lgr_ok : lgr_error;
+
+    // both streams are closed even when one of them fails (fclose flushes first and reports a failed flush),
+    // otherwise the logger would keep a stale file and could never open the next one
+    if (lgr_ok == result){
+        if (log->index){
+            if (EOF == fclose(log->index)){
+                result = lgr_error;
+            }
+            log->index = NULL;
+        }
+
+        if (EOF == fclose(log->file)){
+            result = lgr_error;
+        }
+        log->file = NULL;
+    }
+    PRINT_EXIT();
+
+    return result;
+}
+
+static lg_result_e _write_index(lg_logger_t* log, time_t now){
+    PRINT_ENTER("\n\toffset=%zu\n\tnext=%zu", log->offset, log->next_index_at);
+    lg_result_e result = lgr_ok;
+    _Bool due = log->index_interval && log->offset >= log->next_index_at;
+
+    if (due && !log->index){
+        char buffer[SZ_BUFFER + 4] = {0,};
+        sprintf(&buffer[0], "%s.idx", &log->path[0]);
+        log->index = fopen(&buffer[0], "w");
+        if (!log->index){
+            result = lgr_error;
+        }
+    }
+
+    if (due && lgr_ok == result){
+        lg_index_entry_t entry = {
+            .time = (int64_t)now,
+            .offset = (uint64_t)log->offset
+        };
+        if (1 != fwrite(&entry, sizeof(entry), 1, log->index)){
+            result = lgr_error;
+        }
+        else {
+            log->next_index_at = log->offset + log->index_interval;
+        }
+    }
+
+    if (lgr_error == result){
+        // the index of this file ends here instead of failing every record, the next file gets a new one
+        log->next_index_at = SIZE_MAX;
+    }
     PRINT_EXIT();
 
     return result;
 }
 
-static lg_result_e _roll_file(lg_logger_t* log){
+static lg_result_e _roll_file(lg_logger_t* log, time_t now){
     PRINT_ENTER("\n\tt0=%ld\n\tnow=%ld\n\tdiff=%ld\n\tinterval=%ld\n\tcount=%zu",
            log->last_log,
-           time(NULL),
-           time(NULL)-log->last_log,
+           now,
+           now-log->last_log,
            log->interval_s,
            log->count);
 
@@ -247,16 +426,17 @@ static lg_result_e _roll_file(lg_logger_t* log){
     }
 
     if (lgr_ok == result){
-        time_t now = time(NULL);
         if ( now >= log->last_log + log->interval_s ){
             ++log->count;
             log->last_log = now;
-            if(EOF == fflush(log->file) || EOF == fclose(log->file)){
-                result = lgr_error;
-            }
-            else {
-                log->file = NULL;
-                result = _open_next_file(log);
+            size_t bytes = log->offset;
+            result = _close_files(log);
+            // the closed file is on disk even if flushing it failed, and the next one is opened anyway,
+            // so one failed close does not stop the logger for good
+            _report_closed(log, bytes);
+            lg_result_e opened = _open_next_file(log);
+            if (lgr_ok == result){
+                result = opened;
             }
         }
     }
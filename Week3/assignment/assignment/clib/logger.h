@@ -7,6 +7,9 @@
 
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -22,6 +25,35 @@ extern "C" {
         lgr_reserved = 0x100
     } lg_result_e;
 
+    /**
+     * \struct lg_index_entry
+     * A record of the sidecar index ("<log file>.idx") written next to every rolled file.
+     * The first record of a file is always indexed, the following ones roughly every index interval bytes.
+     * Entries are stored in native byte order, ordered by offset.
+     */
+    typedef struct lg_index_entry {
+        int64_t time;     /**< time (seconds since the epoch) at which the record at offset was logged */
+        uint64_t offset;  /**< byte offset of the record in the log file */
+    } lg_index_entry_t;
+
+    /** Default distance in bytes between two entries of the sidecar index */
+#define LG_DEFAULT_INDEX_INTERVAL (64 * 1024)
+
+    /**
+     * Clock used by lg_logger for rolling and indexing, returns the current time in seconds since the epoch
+     * @param [in] ctx the context pointer given to lg_set_clock
+     */
+    typedef time_t (*lg_clock_fn)(void* ctx);
+
+    /**
+     * Called when lg_logger is done with a file: after rolling to the next one and in lg_destroy.
+     * Runs on the logging thread, so it should only take note of the file.
+     * @param [in] ctx the context pointer given to lg_set_roll_callback
+     * @param [in] path name of the closed file, its sidecar index (if any) is path + ".idx"
+     * @param [in] bytes size of the closed file
+     */
+    typedef void (*lg_roll_fn)(void* ctx, const char* path, size_t bytes);
+
     /**
      * \struct lg_logger
      * Structure with running_time information about the logger state.
@@ -37,6 +69,20 @@ extern "C" {
      */
     extern lg_result_e lg_create(lg_logger_t** log, time_t interval_s);
 
+    /**
+     * Creates and initializes a new lg_logger object that writes one shard of a log, its files are named
+     * yymmdd_HHMMSS.N.suffix, so several loggers started in the same second do not share files
+     * @param [in,out] log an address of a pointer to ::lg_logger_t, this pointer must be NULL
+     * @param [in] interval_s an interval of the log-rolling
+     * @param [in] suffix up to LG_MAX_SUFFIX characters without '/' and '.', other than "idx" and "gz" (taken by
+     *             the sidecar indexes and compressed files); NULL or "" creates a plain lg_logger
+     * @return One of the possible result codes #lg_result
+     */
+    extern lg_result_e lg_create_shard(lg_logger_t** log, time_t interval_s, const char* suffix);
+
+    /** The longest suffix accepted by lg_create_shard */
+#define LG_MAX_SUFFIX (15)
+
     /**
      * Destroys and cleans up a lg_logger object initialized with lg_create
      * @param [in,out] log an address of a pointer to initialized ::lg_logger_t
@@ -60,6 +106,32 @@ extern "C" {
      */
     extern lg_result_e lg_set_append_newline(lg_logger_t* log, bool on_off);
 
+    /**
+     * Sets the distance between the entries of the sidecar time index, takes effect from the next logged message
+     * @param [in] log a pointer to initialized ::lg_logger_t
+     * @param [in] bytes distance in bytes between two index entries, 0 disables the index
+     * @return One of the possible result codes #lg_result
+     */
+    extern lg_result_e lg_set_index_interval(lg_logger_t* log, size_t bytes);
+
+    /**
+     * Replaces time(NULL) as the clock of the logger, the roll interval restarts at the clock's current time
+     * @param [in] log a pointer to initialized ::lg_logger_t
+     * @param [in] clock the clock, NULL restores time(NULL)
+     * @param [in] ctx passed to every call of clock
+     * @return One of the possible result codes #lg_result
+     */
+    extern lg_result_e lg_set_clock(lg_logger_t* log, lg_clock_fn clock, void* ctx);
+
+    /**
+     * Sets the function told about every file the logger has closed for good
+     * @param [in] log a pointer to initialized ::lg_logger_t
+     * @param [in] on_roll the callback, NULL removes it
+     * @param [in] ctx passed to every call of on_roll
+     * @return One of the possible result codes #lg_result
+     */
+    extern lg_result_e lg_set_roll_callback(lg_logger_t* log, lg_roll_fn on_roll, void* ctx);
+
     /**
      * Logs a message
      * @param [in] log a pointer to initialized ::lg_logger_t
@@ -0,0 +1,106 @@
+#ifndef LESSON_ASYNC_WRITER_H
+#define LESSON_ASYNC_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "itext_writer.h"
+#include "shared_record.h"
+#include "metrics/stats.h"
+
+namespace writers {
+
+    /*
+     * Hands whole records to a consumer thread through a bounded queue, so the caller never waits for
+     * the inner writer. What happens when the queue is full is up to the overflow mode. In spill mode
+     * the records that do not fit are appended to an unlinked temporary file and replayed from it once
+     * the queue has been drained; while anything is spilled, new records are spilled behind it, so the
+     * inner writer sees the records in the order they were written. Memory stays bounded by max_queued_bytes
+     * plus one read chunk. Queued records are shared_records, so a record fanned out to several async
+     * sinks is queued once.
+     */
+    class async_writer : public io::itext_writer, public io::irecord_holder, public metrics::idrop_counter,
+                         public metrics::ispill_counter {
+    public:
+        enum class overflow { block, drop, spill };
+
+        struct options {
+            overflow on_full = overflow::spill;
+            std::size_t max_queued_bytes = 1024 * 1024;
+            // where the spill file is created, $TMPDIR or /tmp when empty
+            std::string spill_directory;
+            std::size_t replay_chunk_bytes = 64 * 1024;
+        };
+
+        explicit async_writer(std::unique_ptr<io::itext_writer> inner);
+
+        async_writer(std::unique_ptr<io::itext_writer> inner, options opts);
+
+        async_writer(const async_writer&) = delete;
+        async_writer& operator=(const async_writer&) = delete;
+
+        // writes out everything queued and spilled
+        virtual ~async_writer() override;
+
+        using io::itext_writer::operator<<;
+
+        virtual itext_writer& operator<<(std::string_view view) override;
+
+        virtual itext_writer& operator<<(const char* string) override;
+
+        virtual itext_writer& operator<<(char c) override;
+
+        virtual itext_writer& operator<<(int n) override;
+
+        virtual itext_writer& operator<<(io::flush_t) override;
+
+        // queues a reference to the record
+        virtual void write(const io::shared_record& record) override;
+
+        virtual std::uint64_t dropped_records() const noexcept override;
+        virtual metrics::spill_stats spilled() const noexcept override;
+
+    private:
+        void append(std::string_view token);
+        // expects m_mutex to be held
+        void enqueue(io::shared_record record, std::unique_lock<std::mutex>& lock);
+        bool spill(std::string_view record);
+        void consume();
+        void replay_spill(std::unique_lock<std::mutex>& lock);
+
+        std::unique_ptr<io::itext_writer> m_inner;
+        const options m_opts;
+        const metrics::idrop_counter* m_inner_drops;
+
+        std::mutex m_mutex;
+        std::condition_variable m_queued;
+        std::condition_variable m_space;
+        std::deque<io::shared_record> m_queue;
+        std::size_t m_queued_bytes = 0;
+        std::string m_pending;
+        bool m_flush_requested = false;
+        bool m_stop = false;
+
+        // the spill file, written at m_spill_end and replayed from m_spill_begin
+        int m_spill_fd = -1;
+        std::uint64_t m_spill_begin = 0;
+        std::uint64_t m_spill_end = 0;
+
+        std::atomic<std::uint64_t> m_dropped{0};
+        std::atomic<std::uint64_t> m_spilled_records{0};
+        std::atomic<std::uint64_t> m_spilled_bytes{0};
+        std::atomic<std::uint64_t> m_replayed_records{0};
+        std::atomic<std::uint64_t> m_replayed_bytes{0};
+
+        std::thread m_consumer;
+    };
+}
+
+#endif //LESSON_ASYNC_WRITER_H
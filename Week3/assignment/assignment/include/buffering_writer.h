@@ -0,0 +1,89 @@
+#ifndef LESSON_BUFFERING_WRITER_H
+#define LESSON_BUFFERING_WRITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "itext_writer.h"
+#include "metrics/stats.h"
+
+namespace writers {
+
+    /*
+     * Gathers the tokens written to it and hands them to the inner writer in large chunks of whole
+     * records. A chunk is passed on once it holds max_bytes or max_records records, or once its oldest
+     * record has waited max_delay; the deadline is kept by a background thread, so records are never
+     * held longer than that even when nothing else is logged. A chunk is taken out under the lock and
+     * written without it, so logging threads never wait for the inner writer of another thread's chunk.
+     */
+    class buffering_writer : public io::itext_writer, public metrics::idrop_counter {
+    public:
+        struct options {
+            std::size_t max_bytes = 64 * 1024;
+            std::size_t max_records = 256;
+            std::chrono::milliseconds max_delay{100};
+        };
+
+        explicit buffering_writer(std::unique_ptr<io::itext_writer> inner);
+
+        buffering_writer(std::unique_ptr<io::itext_writer> inner, options opts);
+
+        buffering_writer(const buffering_writer&) = delete;
+        buffering_writer& operator=(const buffering_writer&) = delete;
+
+        // passes on whatever is still buffered
+        virtual ~buffering_writer() override;
+
+        using io::itext_writer::operator<<;
+
+        virtual itext_writer& operator<<(std::string_view view) override;
+
+        virtual itext_writer& operator<<(const char* string) override;
+
+        virtual itext_writer& operator<<(char c) override;
+
+        virtual itext_writer& operator<<(int n) override;
+
+        virtual itext_writer& operator<<(io::flush_t) override;
+
+        virtual std::uint64_t dropped_records() const noexcept override;
+
+    private:
+        using clock_type = std::chrono::steady_clock;
+
+        void append(std::string_view token);
+        // expects lock to hold m_mutex, unlocks it while writing; complete_only keeps a trailing partial
+        // record buffered, flush flushes the inner writer after the chunk
+        void pass_on(std::unique_lock<std::mutex>& lock, bool complete_only, bool flush);
+        void keep_deadlines();
+
+        std::unique_ptr<io::itext_writer> m_inner;
+        const options m_opts;
+        const metrics::idrop_counter* m_inner_drops;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wakeup;
+        std::string m_buffer;
+        // the storage of the last chunk written, reused by the next one
+        std::string m_spare;
+        std::size_t m_records = 0;
+        // chunks are numbered when taken out and written in that order
+        std::uint64_t m_taken = 0;
+        clock_type::time_point m_deadline = clock_type::time_point::max();
+        bool m_stop = false;
+
+        std::mutex m_inner_mutex;
+        std::condition_variable m_turn;
+        std::uint64_t m_written = 0;
+
+        std::thread m_timer;
+    };
+}
+
+#endif //LESSON_BUFFERING_WRITER_H
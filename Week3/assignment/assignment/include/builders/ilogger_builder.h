@@ -8,22 +8,34 @@
 #include <string_view>
 #include <memory>
 #include <chrono>
+#include <cstddef>
 #include "ilogger.h"
+#include "global/clock_source.h"
+#include "async_writer.h"
 
 namespace io {
     class itext_writer;
 }
 
+namespace writers {
+    class retention_manager;
+}
+
 namespace builders {
 
     class ilogger_builder {
     public:
         enum class timestamp_type { none, current_time, running_time };
+        // stream goes through std::ofstream, fd writes the file descriptor directly (fd_dsync opens it with O_DSYNC),
+        // uring hands full buffers to io_uring (or a pwritev thread pool) and does not wait for the writes;
+        // all of them truncate an existing file
+        enum class file_output_type { stream, fd, fd_dsync, uring };
 
         virtual ilogger_builder& reset() = 0;
 
         virtual ilogger_builder& with_console_output() = 0;
         virtual ilogger_builder& with_file_output(std::string_view file_name) = 0;
+        virtual ilogger_builder& with_file_output(std::string_view file_name, file_output_type type) = 0;
         virtual std::unique_ptr<loggers::ilogger> get() = 0;
 
         virtual ~ilogger_builder() = default;
@@ -31,6 +43,23 @@ namespace builders {
         virtual ilogger_builder& with_writer(std::unique_ptr<io::itext_writer> writer) = 0;
         virtual ilogger_builder& with_timestamp(timestamp_type type) = 0;
         virtual ilogger_builder& with_rolling_log_with_interval(std::chrono::seconds interval) = 0;
+        virtual ilogger_builder& with_socket_output(std::string_view socket_path) = 0;
+        virtual ilogger_builder& with_shm_ring_output(std::string_view ring_name) = 0;
+        virtual ilogger_builder& with_stats(std::string_view logger_name) = 0;
+        virtual ilogger_builder& with_stats_report(std::chrono::seconds interval) = 0;
+        // debug and trace records are kept per thread and only logged ahead of an error
+        virtual ilogger_builder& with_backtrace(std::size_t records) = 0;
+        // sinks added after this call are written in chunks of up to max_bytes or max_records records,
+        // a record waits at most max_delay
+        virtual ilogger_builder& with_buffering(std::size_t max_bytes, std::size_t max_records,
+                                                std::chrono::milliseconds max_delay) = 0;
+        // sinks added after this call are written by a thread of their own through a bounded queue
+        virtual ilogger_builder& with_async(const writers::async_writer::options& queueing) = 0;
+        // the clock of the time stamps and rolling logs added after this call
+        virtual ilogger_builder& with_clock(global::clock_type type) = 0;
+        virtual ilogger_builder& with_clock(std::shared_ptr<const global::clock_source> clock) = 0;
+        // the files of rolling logs added after this call are kept within the budgets of retention
+        virtual ilogger_builder& with_retention(std::shared_ptr<writers::retention_manager> retention) = 0;
     };
 }
 
@@ -7,8 +7,11 @@
 
 #include <string_view>
 #include <memory>
+#include <optional>
+#include <string>
 #include "ilogger_builder.h"
 #include "multi_writer.h"
+#include "buffering_writer.h"
 
 namespace builders {
 
@@ -19,17 +22,38 @@ namespace builders {
         virtual ilogger_builder& reset() override;
         virtual ilogger_builder& with_console_output() override;
         virtual ilogger_builder& with_file_output(std::string_view file_name) override;
+        virtual ilogger_builder& with_file_output(std::string_view file_name, file_output_type type) override;
         virtual std::unique_ptr <loggers::ilogger> get() override;
         virtual ~logger_builder() override = default;
         
         virtual ilogger_builder& with_writer(std::unique_ptr<io::itext_writer> writer) override;
         virtual ilogger_builder& with_timestamp(timestamp_type type) override;
         virtual ilogger_builder& with_rolling_log_with_interval(std::chrono::seconds interval) override;
+        virtual ilogger_builder& with_socket_output(std::string_view socket_path) override;
+        virtual ilogger_builder& with_shm_ring_output(std::string_view ring_name) override;
+        virtual ilogger_builder& with_stats(std::string_view logger_name) override;
+        virtual ilogger_builder& with_stats_report(std::chrono::seconds interval) override;
+        virtual ilogger_builder& with_backtrace(std::size_t records) override;
+        virtual ilogger_builder& with_buffering(std::size_t max_bytes, std::size_t max_records,
+                                                std::chrono::milliseconds max_delay) override;
+        virtual ilogger_builder& with_async(const writers::async_writer::options& queueing) override;
+        virtual ilogger_builder& with_clock(global::clock_type type) override;
+        virtual ilogger_builder& with_clock(std::shared_ptr<const global::clock_source> clock) override;
+        virtual ilogger_builder& with_retention(std::shared_ptr<writers::retention_manager> retention) override;
 
     private:
+        // every sink goes through here, so the builder options apply to all of them
+        void add_sink(const std::string& name, std::unique_ptr<io::itext_writer> writer);
+
         writers::multi_writer* m_writer;
         std::unique_ptr<loggers::ilogger> m_logger;
         bool hasTimestamp = false;
+        std::optional<std::string> m_stats_name;
+        std::chrono::seconds m_stats_interval{0};
+        std::shared_ptr<const global::clock_source> m_clock;
+        std::shared_ptr<writers::retention_manager> m_retention;
+        std::optional<writers::buffering_writer::options> m_buffering;
+        std::optional<writers::async_writer::options> m_async;
     };
 
     logger_builder default_builder();
@@ -0,0 +1,107 @@
+#ifndef LESSON_CALL_SITE_H
+#define LESSON_CALL_SITE_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace loggers {
+
+    enum class level { trace, debug, info, warning, error, critical };
+
+    class call_site_registry;
+
+    /*
+     * Static description of one logging call site, created by LOG_AT. It lives in constant-initialized
+     * static storage, so checking whether the site is enabled costs one relaxed load and no guard.
+     * The site registers itself with call_site_registry the first time it logs.
+     */
+    class call_site {
+    public:
+        constexpr call_site(std::source_location location, level lvl, const char* format) noexcept :
+            m_file{location.file_name()}, m_line{location.line()}, m_function{location.function_name()},
+            m_level{lvl}, m_format{format}
+        {}
+
+        call_site(const call_site&) = delete;
+        call_site& operator=(const call_site&) = delete;
+
+        bool enabled() const noexcept { return m_enabled.load(std::memory_order_relaxed); }
+        void set_enabled(bool on_off) noexcept { m_enabled.store(on_off, std::memory_order_relaxed); }
+
+        // registers the site on its first use, false when the registry's rules disable it
+        bool admit() noexcept;
+
+        const char* file() const noexcept { return m_file; }
+        unsigned line() const noexcept { return m_line; }
+        const char* function() const noexcept { return m_function; }
+        level lvl() const noexcept { return m_level; }
+        // the message argument of LOG_AT as written in the source
+        const char* format() const noexcept { return m_format; }
+
+    private:
+        friend class call_site_registry;
+
+        const char* m_file;
+        unsigned m_line;
+        const char* m_function;
+        level m_level;
+        const char* m_format;
+        std::atomic<bool> m_enabled{true};
+        std::atomic<bool> m_registered{false};
+    };
+
+    // all call sites that have logged so far, and the rules that switch sites on and off
+    class call_site_registry {
+    public:
+        call_site_registry(const call_site_registry&) = delete;
+        call_site_registry& operator=(const call_site_registry&) = delete;
+
+        /*
+         * Enables or disables the sites in files ending with file_suffix (every file when empty),
+         * at line (every line when 0). The rule also applies to sites that register later.
+         * Returns the number of registered sites changed.
+         */
+        std::size_t set_enabled(std::string_view file_suffix, unsigned line, bool on_off);
+
+        std::vector<const call_site*> sites() const;
+
+        static call_site_registry& get_instance();
+
+    private:
+        friend class call_site;
+
+        struct rule {
+            std::string file_suffix;
+            unsigned line;
+            bool on_off;
+        };
+
+        call_site_registry() = default;
+
+        void add(call_site& site);
+        static bool matches(const rule& r, const call_site& site) noexcept;
+
+        mutable std::mutex m_mutex;
+        std::vector<call_site*> m_sites;
+        std::vector<rule> m_rules;
+    };
+}
+
+/*
+ * Logs msg through logger (an ilogger) at lvl unless the call site has been disabled.
+ * LOG_AT(*log, loggers::level::debug, "cache miss");
+ */
+#define LOG_AT(logger, lvl, msg) \
+    do { \
+        static constinit ::loggers::call_site lg_call_site_{::std::source_location::current(), (lvl), #msg}; \
+        if (lg_call_site_.enabled() && lg_call_site_.admit()) { \
+            (logger).log(lg_call_site_, (msg)); \
+        } \
+    } while (false)
+
+#endif //LESSON_CALL_SITE_H
@@ -0,0 +1,105 @@
+#ifndef LESSON_CIRCUIT_BREAKER_WRITER_H
+#define LESSON_CIRCUIT_BREAKER_WRITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "itext_writer.h"
+#include "metrics/stats.h"
+
+namespace writers {
+
+    /*
+     * Guards the caller against a slow sink. Every write is timed; after trip_after consecutive writes
+     * over the latency budget the sink is isolated at the next record boundary. An isolated sink either
+     * gets its records through a bounded side queue drained by its own thread, or has them dropped until
+     * a probe record written after probe_interval comes back within the budget.
+     */
+    class circuit_breaker_writer : public io::itext_writer, public metrics::idrop_counter {
+    public:
+        enum class overflow { queue, drop };
+        enum class state { closed, open, half_open };
+
+        struct policy {
+            std::chrono::microseconds latency_budget{1000};
+            std::size_t trip_after = 3;
+            overflow on_trip = overflow::queue;
+            std::size_t max_queued_bytes = 1024 * 1024;
+            std::chrono::milliseconds probe_interval{1000};
+        };
+
+        struct health {
+            state current;
+            std::uint64_t trips;
+            std::uint64_t dropped_records;
+            std::size_t queued_bytes;
+        };
+
+        circuit_breaker_writer(std::unique_ptr<io::itext_writer> inner, policy p);
+
+        circuit_breaker_writer(const circuit_breaker_writer&) = delete;
+        circuit_breaker_writer& operator=(const circuit_breaker_writer&) = delete;
+
+        // writes out whatever is still queued
+        virtual ~circuit_breaker_writer() override;
+
+        using io::itext_writer::operator<<;
+
+        virtual itext_writer& operator<<(std::string_view view) override;
+
+        virtual itext_writer& operator<<(const char* string) override;
+
+        virtual itext_writer& operator<<(char c) override;
+
+        virtual itext_writer& operator<<(int n) override;
+
+        virtual itext_writer& operator<<(io::flush_t) override;
+
+        health status() const;
+
+        virtual std::uint64_t dropped_records() const noexcept override;
+
+    private:
+        using clock_type = std::chrono::steady_clock;
+
+        void forward(std::string_view token);
+        std::chrono::nanoseconds timed_write(std::string_view token);
+        void trip(clock_type::time_point now);
+        void close();
+        void drain_queue();
+
+        std::unique_ptr<io::itext_writer> m_inner;
+        const policy m_policy;
+        const metrics::idrop_counter* m_inner_drops;
+
+        // serializes the writes of the caller and of the drain thread
+        std::mutex m_sink_mutex;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_queued;
+        state m_state = state::closed;
+        std::size_t m_slow_writes = 0;
+        bool m_trip_pending = false;
+        bool m_probe_slow = false;
+        bool m_at_record_start = true;
+        clock_type::time_point m_probe_at{};
+
+        std::string m_pending;
+        std::deque<std::string> m_queue;
+        std::size_t m_queued_bytes = 0;
+        std::uint64_t m_trips = 0;
+        std::uint64_t m_dropped = 0;
+        bool m_stop = false;
+
+        std::thread m_drain;
+    };
+}
+
+#endif //LESSON_CIRCUIT_BREAKER_WRITER_H
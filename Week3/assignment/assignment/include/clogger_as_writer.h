@@ -2,11 +2,15 @@
 #define LESSON_CLOGGER_AS_WRITER_H
 
 #include <chrono>
+#include <memory>
 #include <stdexcept>
+#include <string>
 #include <string_view>
 #include "ilogger.h"
 #include "../clib/logger.h"
 #include "itext_writer.h"
+#include "global/clock_source.h"
+#include "retention_manager.h"
 
 namespace io
 {
@@ -14,8 +18,15 @@ namespace io
     {
         public:
             clogger_as_writer(std::chrono::seconds roll_interval);
+            // rolls by clock instead of time(NULL)
+            clogger_as_writer(std::chrono::seconds roll_interval, std::shared_ptr<const global::clock_source> clock);
+            // every closed file is handed to retention
+            clogger_as_writer(std::chrono::seconds roll_interval, std::shared_ptr<const global::clock_source> clock,
+                              std::shared_ptr<writers::retention_manager> retention);
             ~clogger_as_writer();
 
+            using io::itext_writer::operator<<;
+
             itext_writer& operator<<(char c) override;
 
             itext_writer& operator<<(int n) override;
@@ -26,7 +37,12 @@ namespace io
             
             itext_writer& operator<<(const char*) override;
         private:
+            void append(std::string_view str);
+
             lg_logger_t* m_clogger = NULL; 
+            std::string m_record;
+            std::shared_ptr<const global::clock_source> m_clock;
+            std::shared_ptr<writers::retention_manager> m_retention;
     };
 
 }
@@ -13,6 +13,8 @@ public:
 
     console_writer() = default;
 
+    using io::itext_writer::operator<<;
+
     virtual itext_writer& operator<<(std::string_view view) override;
 
     virtual itext_writer& operator<<(const char* string) override;
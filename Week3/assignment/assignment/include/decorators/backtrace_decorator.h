@@ -0,0 +1,78 @@
+#ifndef LESSON_BACKTRACE_DECORATOR_H
+#define LESSON_BACKTRACE_DECORATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "decorator.h"
+
+namespace lib::decorators {
+
+    /*
+     * Holds debug and trace records back instead of logging them. Every thread keeps its last
+     * capacity records in a preallocated ring, copied in as raw bytes (longer ones are truncated to
+     * record_size). When a record at trigger level or above is logged, the thread's ring is logged
+     * first, oldest record first, so the error arrives with the context that led to it.
+     * A thread's rings go away when the thread exits, or when the decorator is destroyed.
+     */
+    class backtrace_decorator: public decorator {
+    public:
+        backtrace_decorator(std::unique_ptr<ilogger> inner, std::size_t capacity = 64, std::size_t record_size = 256,
+                            loggers::level trigger = loggers::level::error);
+
+        backtrace_decorator(const backtrace_decorator&) = delete;
+        backtrace_decorator& operator=(const backtrace_decorator&) = delete;
+
+        virtual ~backtrace_decorator() override;
+
+        using decorator::log;
+        virtual void log(loggers::level lvl, std::string_view msg) const override;
+        // held back records are built right away, unless nothing would ever write them
+        virtual void log(loggers::level lvl, loggers::message_builder build) const override;
+
+    private:
+        class ring {
+        public:
+            ring(std::size_t capacity, std::size_t record_size);
+
+            void push(loggers::level lvl, std::string_view msg) noexcept;
+
+            // logs the held records through logger and empties the ring
+            void replay(const decorator& logger);
+
+            // set when the decorator is destroyed, the owning thread drops the ring on its next lookup
+            std::atomic<bool> detached{false};
+
+        private:
+            struct entry {
+                loggers::level lvl;
+                std::uint32_t length;
+            };
+
+            std::size_t m_record_size;
+            std::vector<char> m_storage;
+            std::vector<entry> m_entries;
+            std::size_t m_next = 0;
+            std::size_t m_count = 0;
+        };
+
+        friend struct ring_holder;
+
+        ring& local_ring() const;
+
+        std::size_t m_capacity;
+        std::size_t m_record_size;
+        loggers::level m_trigger;
+        // tells the per-thread cache of one decorator from another's, ids are never reused
+        std::uint64_t m_id;
+
+        // the rings are owned by the ring_holder of their thread and freed when it exits
+        mutable std::mutex m_mutex;
+        mutable std::vector<std::weak_ptr<ring>> m_rings;
+    };
+}
+
+#endif //LESSON_BACKTRACE_DECORATOR_H
@@ -14,8 +14,18 @@ namespace lib::decorators {
 
         decorator(std::unique_ptr <ilogger> inner) : m_inner( std::move(inner) ) {}
 
-        virtual void log(std::string_view msg) const override {
-            m_inner->log(msg);
+        using ilogger::log;
+
+        virtual void log(loggers::level lvl, std::string_view msg) const override {
+            m_inner->log(lvl, msg);
+        }
+
+        virtual void log(loggers::level lvl, loggers::message_builder build) const override {
+            m_inner->log(lvl, build);
+        }
+
+        virtual bool will_log(loggers::level lvl) const override {
+            return m_inner->will_log(lvl);
         }
 
     private:
@@ -7,14 +7,19 @@
 
 #include <chrono>
 #include "decorator.h"
+#include "global/clock_source.h"
 
 namespace lib::decorators {
 
     class runningtime_decorator: public decorator {
     public:
-        using decorator::decorator;
-        virtual void log(std::string_view msg) const override;
+        runningtime_decorator(std::unique_ptr<ilogger> inner,
+                              std::shared_ptr<const global::clock_source> clock = global::default_clock());
+        using decorator::log;
+        virtual void log(loggers::level lvl, std::string_view msg) const override;
+        virtual void log(loggers::level lvl, loggers::message_builder build) const override;
     private:
+        std::shared_ptr<const global::clock_source> m_clock;
        // const inline static std::chrono::time_point<std::chrono::high_resolution_clock> s_start_time {std::chrono::high_resolution_clock::now()};
     };
 
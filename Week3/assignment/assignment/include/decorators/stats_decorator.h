@@ -0,0 +1,48 @@
+#ifndef LESSON_STATS_DECORATOR_H
+#define LESSON_STATS_DECORATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include "decorator.h"
+#include "metrics/stats.h"
+
+namespace lib::decorators {
+
+    // counts and times the records logged through the decorated logger, optionally logs a stats record every interval
+    class stats_decorator: public decorator {
+    public:
+        stats_decorator(std::unique_ptr<ilogger> inner, std::string name, const writers::multi_writer* sinks,
+                        std::chrono::seconds report_interval = std::chrono::seconds{0});
+
+        stats_decorator(const stats_decorator&) = delete;
+        stats_decorator& operator=(const stats_decorator&) = delete;
+
+        virtual ~stats_decorator() override;
+
+        using decorator::log;
+        virtual void log(loggers::level lvl, std::string_view msg) const override;
+        // counted and timed only when the message is built, a call filtered out further in is not a record
+        virtual void log(loggers::level lvl, loggers::message_builder build) const override;
+
+        metrics::logger_stats stats() const;
+
+    private:
+        void report_if_due(std::chrono::steady_clock::time_point now) const;
+
+        std::string m_name;
+        const writers::multi_writer* m_sinks;
+        std::chrono::steady_clock::duration m_report_interval;
+        mutable std::atomic<std::chrono::steady_clock::rep> m_next_report;
+
+        mutable metrics::sharded_counter m_records;
+        mutable metrics::sharded_counter m_bytes;
+        mutable metrics::sharded_counter m_errors;
+        mutable metrics::latency_histogram m_latency;
+
+        std::size_t m_registry_id;
+    };
+}
+
+#endif //LESSON_STATS_DECORATOR_H
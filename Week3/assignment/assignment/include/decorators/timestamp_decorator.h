@@ -8,13 +8,19 @@
 #include <string>
 #include <memory>
 #include "decorator.h"
+#include "global/clock_source.h"
 
 namespace lib::decorators {
 
 class timestamp_decorator: public decorator {
 public:
-    using decorator::decorator;
-    virtual void log(std::string_view msg) const override;
+    timestamp_decorator(std::unique_ptr<ilogger> inner,
+                        std::shared_ptr<const global::clock_source> clock = global::default_clock());
+    using decorator::log;
+    virtual void log(loggers::level lvl, std::string_view msg) const override;
+    virtual void log(loggers::level lvl, loggers::message_builder build) const override;
+private:
+    std::shared_ptr<const global::clock_source> m_clock;
 };
 }
 
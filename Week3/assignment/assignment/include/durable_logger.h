@@ -0,0 +1,29 @@
+#ifndef LESSON_DURABLE_LOGGER_H
+#define LESSON_DURABLE_LOGGER_H
+
+#include <string_view>
+#include "ilogger.h"
+#include "group_commit_writer.h"
+
+namespace lib {
+
+    // a logger for records that must not be lost, e.g. audit logs: log_durable can be waited for or
+    // co_awaited until the record is on disk, e.g. co_await logger.log_durable("user 42 deleted");
+    class durable_logger: public loggers::ilogger {
+    public:
+        explicit durable_logger(const char* fname, writers::group_commit_writer::options opts = {});
+
+        using loggers::ilogger::log;
+        // the record is committed with the others, but nobody waits for it
+        void log(loggers::level lvl, std::string_view msg) const override;
+
+        writers::group_commit_writer::commit_ack log_durable(std::string_view msg) const;
+
+        const writers::group_commit_writer& writer() const noexcept { return m_out; }
+
+    private:
+        mutable writers::group_commit_writer m_out;
+    };
+}
+
+#endif //LESSON_DURABLE_LOGGER_H
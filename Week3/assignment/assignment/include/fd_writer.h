@@ -0,0 +1,87 @@
+#ifndef LESSON_FD_WRITER_H
+#define LESSON_FD_WRITER_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <string_view>
+#include "itext_writer.h"
+
+namespace writers {
+
+    /*
+     * Writes to a raw file descriptor through a page-aligned buffer of its own, without the sentries,
+     * locale facets and virtual streambuf calls std::ostream makes per token. A token that does not fit
+     * the buffer anymore goes out together with it in one writev(2); flush writes out what is buffered.
+     */
+    class fd_writer : public io::itext_writer {
+    public:
+        struct options {
+            std::size_t buffer_size = 64 * 1024;
+            // O_APPEND, otherwise the file is truncated as stream_writer does
+            bool append = false;
+            // O_DSYNC, every write(2) returns once the data is on stable storage
+            bool dsync = false;
+            // tells the kernel that the written pages will not be read again, keeping large logs out of the page cache
+            bool drop_written_pages = false;
+        };
+
+        explicit fd_writer(const char* fname);
+
+        fd_writer(const char* fname, options opts);
+
+        fd_writer(const fd_writer&) = delete;
+        fd_writer& operator=(const fd_writer&) = delete;
+
+        // writes out what is still buffered
+        virtual ~fd_writer() override;
+
+        using io::itext_writer::operator<<;
+
+        virtual itext_writer& operator<<(std::string_view view) override;
+
+        virtual itext_writer& operator<<(const char* string) override;
+
+        virtual itext_writer& operator<<(char c) override;
+
+        virtual itext_writer& operator<<(int n) override;
+
+        // formatted straight into the buffer like int
+        virtual itext_writer& operator<<(long n) override;
+
+        virtual itext_writer& operator<<(unsigned long n) override;
+
+        virtual itext_writer& operator<<(long long n) override;
+
+        virtual itext_writer& operator<<(unsigned long long n) override;
+
+        virtual itext_writer& operator<<(double n) override;
+
+        virtual itext_writer& operator<<(io::flush_t) override;
+
+        int fd() const noexcept { return m_fd; }
+
+    private:
+        struct free_deleter {
+            void operator()(char* p) const noexcept { std::free(p); }
+        };
+
+        // enough for any 64-bit integer and the shortest form of any double
+        static constexpr std::size_t max_number_length = 32;
+
+        template <typename T>
+        itext_writer& format(T n);
+
+        void write_out(std::string_view tail);
+        void advise_written();
+
+        options m_opts;
+        int m_fd = -1;
+        std::unique_ptr<char, free_deleter> m_buffer;
+        std::size_t m_used = 0;
+        // bytes written since the last POSIX_FADV_DONTNEED
+        std::size_t m_unadvised = 0;
+    };
+}
+
+#endif //LESSON_FD_WRITER_H
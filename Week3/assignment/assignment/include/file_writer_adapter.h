@@ -17,6 +17,8 @@ namespace writers {
 
         virtual ~file_writer_adapter() override = default;
 
+        using io::itext_writer::operator<<;
+
         virtual io::itext_writer& operator<<(std::string_view view) override;
 
         virtual io::itext_writer& operator<<(const char* string) override;
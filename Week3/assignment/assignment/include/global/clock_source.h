@@ -0,0 +1,99 @@
+#ifndef LESSON_CLOCK_SOURCE_H
+#define LESSON_CLOCK_SOURCE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <thread>
+
+namespace global {
+
+    // where the loggers read the time from, implementations have to be callable from any thread
+    class clock_source {
+    public:
+        using wall_time = std::chrono::system_clock::time_point;
+        using steady_time = std::chrono::steady_clock::time_point;
+
+        virtual wall_time now() const noexcept = 0;
+        virtual steady_time steady_now() const noexcept = 0;
+        // where the running time starts on the steady time line, the start of the program unless overridden
+        virtual steady_time start() const noexcept;
+        virtual ~clock_source() = default;
+
+        // strftime of the current local time into buffer, the result is empty when it does not fit
+        std::string_view format(std::span<char> buffer, const char* format) const noexcept;
+        static std::string_view format(wall_time time, std::span<char> buffer, const char* format) noexcept;
+    };
+
+    enum class clock_type { precise, coarse, ticker };
+
+    // std::chrono clocks, one vDSO call with full resolution per read
+    class precise_clock : public clock_source {
+    public:
+        virtual wall_time now() const noexcept override;
+        virtual steady_time steady_now() const noexcept override;
+    };
+
+    // CLOCK_*_COARSE, cheaper than the precise clocks but only as fine as the kernel tick (1-4 ms)
+    class coarse_clock : public clock_source {
+    public:
+        virtual wall_time now() const noexcept override;
+        virtual steady_time steady_now() const noexcept override;
+    };
+
+    // a background thread publishes the time every period, reading it is a plain atomic load
+    class ticker_clock : public clock_source {
+    public:
+        explicit ticker_clock(std::chrono::microseconds period = std::chrono::milliseconds{1});
+
+        ticker_clock(const ticker_clock&) = delete;
+        ticker_clock& operator=(const ticker_clock&) = delete;
+
+        virtual ~ticker_clock() override = default;
+
+        virtual wall_time now() const noexcept override;
+        virtual steady_time steady_now() const noexcept override;
+
+    private:
+        void tick() noexcept;
+
+        std::atomic<wall_time::rep> m_wall;
+        std::atomic<steady_time::rep> m_steady;
+        std::jthread m_thread;
+    };
+
+    /*
+     * Time that only moves when told to: by advance() or by step on every read. Benchmarks and roll
+     * interval tests get reproducible time stamps and do not have to sleep. Both time lines start
+     * at start and move together; the running time starts at 0 with the clock.
+     */
+    class virtual_clock : public clock_source {
+    public:
+        explicit virtual_clock(wall_time start = wall_time{}, std::chrono::nanoseconds step = std::chrono::nanoseconds{0});
+
+        virtual wall_time now() const noexcept override;
+        virtual steady_time steady_now() const noexcept override;
+        virtual steady_time start() const noexcept override;
+
+        void advance(std::chrono::nanoseconds by) noexcept;
+        void set(wall_time time) noexcept;
+
+    private:
+        std::chrono::nanoseconds read() const noexcept;
+
+        const wall_time m_start;
+        const std::chrono::nanoseconds::rep m_step;
+        mutable std::atomic<std::chrono::nanoseconds::rep> m_elapsed{0};
+    };
+
+    // the ticker is shared: every caller gets the same one while any of them still holds it
+    std::shared_ptr<const clock_source> make_clock(clock_type type);
+
+    // used by everything that is not given a clock explicitly
+    std::shared_ptr<const clock_source> default_clock();
+}
+
+#endif //LESSON_CLOCK_SOURCE_H
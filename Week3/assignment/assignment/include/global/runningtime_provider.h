@@ -6,6 +6,7 @@
 #define LESSON_RUNNINGTIME_PROVIDER_H
 
 #include <chrono>
+#include "clock_source.h"
 
 namespace global {
     class runningtime_provider {
@@ -17,11 +18,15 @@ namespace global {
         runningtime_provider& operator=(const runningtime_provider&) = delete;
 
         time_point start_time() const noexcept;
+        clock_source::steady_time steady_start_time() const noexcept;
         duration running_time() const noexcept;
+        // running time as seen by clock, measured on its steady time line from its start()
+        duration running_time(const clock_source& clock) const noexcept;
 
         static const runningtime_provider& get_instance();
     private:
         time_point m_t0;
+        clock_source::steady_time m_steady_t0;
         runningtime_provider();
     };
 
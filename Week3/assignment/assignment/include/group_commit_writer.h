@@ -0,0 +1,119 @@
+#ifndef LESSON_GROUP_COMMIT_WRITER_H
+#define LESSON_GROUP_COMMIT_WRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "itext_writer.h"
+
+namespace writers {
+
+    /*
+     * Makes records durable in groups: the records of all threads are gathered into a batch, and a
+     * commit thread writes each batch with one write(2) and one fdatasync(2). While a batch is being
+     * synced the next one fills up, so the number of syncs follows the disk, not the number of records.
+     * write_durable returns a commit_ack that completes once the record's batch is on disk; it can be
+     * waited for or co_awaited. Awaiting coroutines are resumed on the commit thread.
+     */
+    class group_commit_writer : public io::itext_writer {
+    public:
+        struct options {
+            // how long a batch is kept open after its first record, 0 commits as soon as the disk is free
+            std::chrono::microseconds window{0};
+            // a batch that grows this large is committed before its window is over
+            std::size_t max_batch_bytes = 1024 * 1024;
+        };
+
+        // the writer has to outlive its acks
+        class commit_ack {
+        public:
+            bool ready() const noexcept;
+
+            // both throw std::runtime_error when the batch could not be written or synced; after a failed
+            // batch the file is no longer known to be complete, so the later batches fail as well
+            void wait() const;
+            void await_resume() const { wait(); }
+
+            bool await_ready() const noexcept { return ready(); }
+            bool await_suspend(std::coroutine_handle<> handle) const;
+
+        private:
+            friend class group_commit_writer;
+
+            commit_ack(const group_commit_writer* writer, std::uint64_t batch) : m_writer{writer}, m_batch{batch} {}
+
+            const group_commit_writer* m_writer;
+            std::uint64_t m_batch;
+        };
+
+        explicit group_commit_writer(const char* fname);
+
+        group_commit_writer(const char* fname, options opts);
+
+        group_commit_writer(const group_commit_writer&) = delete;
+        group_commit_writer& operator=(const group_commit_writer&) = delete;
+
+        // commits everything written so far
+        virtual ~group_commit_writer() override;
+
+        // record is one record without its newline
+        commit_ack write_durable(std::string_view record);
+
+        // records written as tokens join the open batch once they are complete, without an ack
+        using io::itext_writer::operator<<;
+
+        virtual itext_writer& operator<<(std::string_view view) override;
+
+        virtual itext_writer& operator<<(const char* string) override;
+
+        virtual itext_writer& operator<<(char c) override;
+
+        virtual itext_writer& operator<<(int n) override;
+
+        // waits until everything written so far is on disk
+        virtual itext_writer& operator<<(io::flush_t) override;
+
+        std::uint64_t batches() const noexcept;
+        std::uint64_t records() const noexcept;
+
+    private:
+        using clock_type = std::chrono::steady_clock;
+
+        void append_tokens(std::string_view tokens);
+        // expects m_mutex to be held, returns the batch the bytes went into
+        std::uint64_t append_records(std::string_view records, std::size_t count);
+        bool failed(std::uint64_t batch) const noexcept;
+        void commit_batches();
+        bool write_batch(const std::string& batch);
+
+        const options m_opts;
+        int m_fd = -1;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wakeup;
+        std::string m_open;
+        std::string m_partial;
+        std::size_t m_open_records = 0;
+        std::uint64_t m_open_batch = 1;
+        clock_type::time_point m_open_since{};
+        mutable std::vector<std::pair<std::uint64_t, std::coroutine_handle<>>> m_waiters;
+        bool m_stop = false;
+
+        // the last batch that is on disk and the first one that could not be synced
+        std::atomic<std::uint64_t> m_synced{0};
+        std::atomic<std::uint64_t> m_first_failed{UINT64_MAX};
+        std::atomic<std::uint64_t> m_records{0};
+
+        std::thread m_committer;
+    };
+}
+
+#endif //LESSON_GROUP_COMMIT_WRITER_H
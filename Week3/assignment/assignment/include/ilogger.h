@@ -5,12 +5,77 @@
 #ifndef LESSON_ILOGGER_H
 #define LESSON_ILOGGER_H
 
+#include <concepts>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "call_site.h"
+
 namespace loggers {
+
+    /*
+     * Refers to a callable that appends a message to the string it is given, e.g.
+     * [&](std::string& out) { out += "state "; out += to_json(state); }
+     * It does not own the callable, so it is only passed down the call that built it.
+     */
+    class message_builder {
+    public:
+        template <typename F>
+            requires (!std::same_as<std::remove_cvref_t<F>, message_builder> && std::invocable<F&, std::string&>)
+        message_builder(F& build) noexcept :
+            m_callable{const_cast<void*>(static_cast<const void*>(std::addressof(build)))},
+            m_call{[](void* callable, std::string& out) { (*static_cast<F*>(callable))(out); }}
+        {}
+
+        void operator()(std::string& out) const { m_call(m_callable, out); }
+
+    private:
+        void* m_callable;
+        void (*m_call)(void*, std::string&);
+    };
+
     class ilogger {
     public:
-        virtual void log(std::string_view msg) const = 0;
+        virtual void log(level lvl, std::string_view msg) const = 0;
+        // messages without a level are informational
+        void log(std::string_view msg) const { log(level::info, msg); }
+        // the logging of LOG_AT, at the level of its call site
+        void log(const call_site& site, std::string_view msg) const { log(site.lvl(), msg); }
+
+        /*
+         * Builds the message only when the record is going to be written, for messages that are
+         * expensive to put together. Decorators pass build on and add their parts around it.
+         */
+        virtual void log(level lvl, message_builder build) const;
+
+        template <typename F>
+            requires std::invocable<F&, std::string&>
+        void log(level lvl, F&& build) const { log(lvl, message_builder{build}); }
+
+        template <typename F>
+            requires std::invocable<F&, std::string&>
+        void log(const call_site& site, F&& build) const { log(site.lvl(), message_builder{build}); }
+
+        // false when a record logged at lvl now would be thrown away
+        virtual bool will_log(level) const { return true; }
+
         virtual ~ilogger() = default;
     };
+
+    inline void ilogger::log(level lvl, message_builder build) const {
+        if (!will_log(lvl)) {
+            return;
+        }
+        // taken out of the cache while in use, so a message that logs while being built gets a string of its own
+        thread_local std::string cache;
+        auto message = std::move(cache);
+        message.clear();
+        build(message);
+        log(lvl, std::string_view{message});
+        cache = std::move(message);
+    }
 }
 
 
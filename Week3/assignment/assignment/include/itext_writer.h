@@ -4,6 +4,7 @@
 
 #ifndef LESSON_IO_ITEXT_WRITER_H
 #define LESSON_IO_ITEXT_WRITER_H
+#include <cstdint>
 #include <string_view>
 
 namespace io {
@@ -16,14 +17,40 @@ namespace io {
     using flush_t = detail::_flush;
     inline flush_t flush;
 
+    // writes value in lower case hexadecimal digits, without a prefix
+    struct hex_t {
+        std::uint64_t value;
+    };
+
+    constexpr hex_t hex(std::uint64_t value) noexcept { return {value}; }
+
     struct itext_writer {
         virtual itext_writer& operator<<(std::string_view) = 0;
         virtual itext_writer& operator<<(const char*) = 0;
         virtual itext_writer& operator<<(char c) = 0;
         virtual itext_writer& operator<<(int n) = 0;
 
+        // formatted with std::to_chars into a local buffer and written as one string_view token
+        virtual itext_writer& operator<<(unsigned int n);
+        virtual itext_writer& operator<<(long n);
+        virtual itext_writer& operator<<(unsigned long n);
+        virtual itext_writer& operator<<(long long n);
+        virtual itext_writer& operator<<(unsigned long long n);
+        // the shortest text that reads back as the same value
+        virtual itext_writer& operator<<(float n);
+        virtual itext_writer& operator<<(double n);
+        // "true" or "false"
+        virtual itext_writer& operator<<(bool b);
+        virtual itext_writer& operator<<(hex_t n);
+        // 0x followed by the address in hexadecimal
+        virtual itext_writer& operator<<(const void* p);
+
         virtual itext_writer& operator<<(flush_t) = 0;
 
+        // false when every record written now would go nowhere, loggers then skip building lazy messages;
+        // it is asked without the locks that serialize the writes
+        virtual bool wants_records() const { return true; }
+
         virtual ~itext_writer() = default;
     };
 }
@@ -17,7 +17,12 @@ class logger: public loggers::ilogger {
         logger(std::unique_ptr<io::itext_writer> out);
         void set_writer(std::unique_ptr<io::itext_writer> out);
 
-        void log(std::string_view msg) const override;
+        using loggers::ilogger::log;
+        void log(loggers::level lvl, std::string_view msg) const override;
+        // builds the message straight into the record
+        void log(loggers::level lvl, loggers::message_builder build) const override;
+        // true while the writer wants records
+        bool will_log(loggers::level lvl) const override;
     private:
         std::unique_ptr<io::itext_writer> m_out;
     };
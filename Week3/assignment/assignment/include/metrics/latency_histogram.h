@@ -0,0 +1,63 @@
+#ifndef LESSON_LATENCY_HISTOGRAM_H
+#define LESSON_LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "sharded_counter.h"
+
+namespace metrics {
+
+    // merged copy of a latency_histogram, values are in nanoseconds
+    struct histogram_snapshot {
+        std::uint64_t count = 0;
+        std::uint64_t sum = 0;
+        std::vector<std::uint64_t> buckets;
+
+        // upper bound of the bucket holding the p-th percentile, p in [0, 100]
+        std::uint64_t percentile(double p) const noexcept;
+        std::uint64_t min() const noexcept;
+        std::uint64_t max() const noexcept;
+        std::uint64_t mean() const noexcept;
+
+        void merge(const histogram_snapshot& other);
+    };
+
+    /*
+     * HDR-style histogram: values below 64 are counted exactly, every following power of two is split
+     * into 32 equal buckets, so any recorded value is known within ~3%. Values up to ~18 minutes are
+     * kept apart, larger ones land in the last bucket. Recording is a relaxed increment on the calling
+     * thread's own shard (see per_thread).
+     */
+    class latency_histogram {
+    public:
+        static constexpr unsigned sub_bucket_bits = 6;
+        static constexpr unsigned max_value_bits = 40;
+        static constexpr std::size_t bucket_count = (max_value_bits - sub_bucket_bits + 2) << (sub_bucket_bits - 1);
+
+        void record(std::uint64_t nanoseconds) noexcept;
+
+        void record(std::chrono::nanoseconds latency) noexcept {
+            record(static_cast<std::uint64_t>(latency.count() < 0 ? 0 : latency.count()));
+        }
+
+        histogram_snapshot snapshot() const;
+
+        static std::size_t bucket_of(std::uint64_t value) noexcept;
+        static std::uint64_t upper_bound_of(std::size_t bucket) noexcept;
+        static std::uint64_t lower_bound_of(std::size_t bucket) noexcept;
+
+    private:
+        struct alignas(cache_line_size) shard {
+            std::array<std::atomic<std::uint64_t>, bucket_count> buckets{};
+            std::atomic<std::uint64_t> sum{0};
+        };
+
+        per_thread<shard> m_shards;
+    };
+}
+
+#endif //LESSON_LATENCY_HISTOGRAM_H
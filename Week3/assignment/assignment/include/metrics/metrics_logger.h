@@ -0,0 +1,114 @@
+#ifndef LESSON_METRICS_LOGGER_H
+#define LESSON_METRICS_LOGGER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "ilogger.h"
+#include "latency_histogram.h"
+#include "sharded_counter.h"
+
+namespace metrics {
+
+    /*
+     * Accumulates numeric observations per key instead of logging a line for each of them.
+     * Counters sum up what is added, gauges keep the latest value, histograms keep count, sum,
+     * min, max and the distribution of the observed values. Every live thread records into its own
+     * shard, a thread started later takes over the shard of an exited one; every interval the shards are merged and one summary record is logged through out,
+     * e.g. "metrics: requests{count=120} queue{gauge=7} latency_us{count=118 sum=... min=.. max=.. p50=.. p99=..}".
+     * Counters and histograms cover the interval, keys without observations in it are left out;
+     * a gauge is repeated with its latest value until it is set again.
+     */
+    class metrics_logger {
+    public:
+        // out has to outlive the metrics_logger
+        explicit metrics_logger(const loggers::ilogger& out, std::chrono::milliseconds interval = std::chrono::seconds{10},
+                                loggers::level lvl = loggers::level::info);
+
+        metrics_logger(const metrics_logger&) = delete;
+        metrics_logger& operator=(const metrics_logger&) = delete;
+
+        // logs what has been observed since the last summary
+        ~metrics_logger();
+
+        void count(std::string_view key, std::uint64_t n = 1);
+        void gauge(std::string_view key, std::int64_t value);
+        void observe(std::string_view key, std::uint64_t value);
+
+        void observe(std::string_view key, std::chrono::nanoseconds value) {
+            observe(key, static_cast<std::uint64_t>(value.count() < 0 ? 0 : value.count()));
+        }
+
+        // logs the summary now instead of at the end of the interval
+        void flush();
+
+    private:
+        struct string_hash {
+            using is_transparent = void;
+            std::size_t operator()(std::string_view key) const noexcept { return std::hash<std::string_view>{}(key); }
+        };
+
+        template<typename T>
+        using key_map = std::unordered_map<std::string, T, string_hash, std::equal_to<>>;
+
+        struct gauge_value {
+            std::int64_t value = 0;
+            std::chrono::steady_clock::rep stamp = 0;
+            bool set = false;
+        };
+
+        struct histogram_value {
+            std::uint64_t count = 0;
+            std::uint64_t sum = 0;
+            std::uint64_t min = 0;
+            std::uint64_t max = 0;
+            std::vector<std::uint64_t> buckets;
+
+            void add(std::uint64_t value);
+            // adds other to this and empties other, keeping its buckets allocated
+            void take(histogram_value& other);
+        };
+
+        // the observations of one thread since the last summary, the mutex is only contended while merging
+        // (and by the threads beyond per_thread::max_threads, which share one shard)
+        struct shard {
+            std::mutex mutex;
+            key_map<std::uint64_t> counters;
+            key_map<gauge_value> gauges;
+            key_map<histogram_value> histograms;
+        };
+
+        void emit();
+        void run();
+
+        const loggers::ilogger& m_out;
+        const std::chrono::milliseconds m_interval;
+        const loggers::level m_level;
+
+        per_thread<shard> m_shards;
+
+        // merged state, only touched by emit() under m_emit_mutex
+        std::mutex m_emit_mutex;
+        std::map<std::string, std::uint64_t, std::less<>> m_counters;
+        std::map<std::string, gauge_value, std::less<>> m_gauges;
+        std::map<std::string, histogram_value, std::less<>> m_histograms;
+        std::string m_record;
+
+        std::mutex m_timer_mutex;
+        std::condition_variable m_wakeup;
+        bool m_stop = false;
+        std::thread m_timer;
+    };
+}
+
+#endif //LESSON_METRICS_LOGGER_H
@@ -0,0 +1,147 @@
+#ifndef LESSON_SHARDED_COUNTER_H
+#define LESSON_SHARDED_COUNTER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+namespace metrics {
+
+    inline constexpr std::size_t cache_line_size = 64;
+
+    /*
+     * Index of the calling thread among the threads alive right now: no two live threads share an
+     * index, and the index of an exited thread goes to the next thread that asks for one.
+     */
+    std::size_t thread_slot() noexcept;
+
+    /*
+     * One Shard per live thread, allocated on the thread's first use. A thread only ever writes its own
+     * shard; readers visit all of them. A thread that takes over the slot of an exited one continues on
+     * its shard, so nothing counted is lost. Threads beyond max_threads share one overflow shard.
+     */
+    template <typename Shard>
+    class per_thread {
+    public:
+        static constexpr std::size_t chunk_size = 64;
+        static constexpr std::size_t max_threads = chunk_size * chunk_size;
+
+        per_thread() = default;
+
+        per_thread(const per_thread&) = delete;
+        per_thread& operator=(const per_thread&) = delete;
+
+        ~per_thread() {
+            for (auto& chunk_slot : m_chunks) {
+                auto chunk = chunk_slot.load(std::memory_order_relaxed);
+                if (!chunk) {
+                    continue;
+                }
+                for (auto& shard : *chunk) {
+                    delete shard.load(std::memory_order_relaxed);
+                }
+                delete chunk;
+            }
+        }
+
+        Shard& local() noexcept {
+            auto slot = thread_slot();
+            if (slot >= max_threads) {
+                return m_overflow;
+            }
+
+            auto chunk = m_chunks[slot / chunk_size].load(std::memory_order_acquire);
+            if (chunk) {
+                if (auto shard = (*chunk)[slot % chunk_size].load(std::memory_order_relaxed)) {
+                    return *shard;
+                }
+            }
+            return allocate(slot);
+        }
+
+        template <typename Visit>
+        void for_each(Visit&& visit) const {
+            visit_all(*this, visit);
+        }
+
+        // for readers that take what the shards hold, the Shard has to guard itself against its thread
+        template <typename Visit>
+        void for_each(Visit&& visit) {
+            visit_all(*this, visit);
+        }
+
+    private:
+        using chunk = std::array<std::atomic<Shard*>, chunk_size>;
+
+        template <typename Self, typename Visit>
+        static void visit_all(Self& self, Visit& visit) {
+            using shard_ref = std::conditional_t<std::is_const_v<Self>, const Shard&, Shard&>;
+            for (const auto& chunk_slot : self.m_chunks) {
+                auto chunk = chunk_slot.load(std::memory_order_acquire);
+                if (!chunk) {
+                    continue;
+                }
+                for (const auto& shard_slot : *chunk) {
+                    if (auto shard = shard_slot.load(std::memory_order_acquire)) {
+                        visit(static_cast<shard_ref>(*shard));
+                    }
+                }
+            }
+            visit(static_cast<shard_ref>(self.m_overflow));
+        }
+
+        Shard& allocate(std::size_t slot) noexcept {
+            auto& chunk_slot = m_chunks[slot / chunk_size];
+            auto current = chunk_slot.load(std::memory_order_acquire);
+            if (!current) {
+                auto fresh = new (std::nothrow) chunk{};
+                if (!fresh) {
+                    return m_overflow;
+                }
+                // another thread of the same chunk may have been first
+                if (chunk_slot.compare_exchange_strong(current, fresh, std::memory_order_acq_rel)) {
+                    current = fresh;
+                } else {
+                    delete fresh;
+                }
+            }
+
+            // only the owner of the slot ever stores its shard
+            auto shard = new (std::nothrow) Shard{};
+            if (!shard) {
+                return m_overflow;
+            }
+            (*current)[slot % chunk_size].store(shard, std::memory_order_release);
+            return *shard;
+        }
+
+        std::array<std::atomic<chunk*>, chunk_size> m_chunks{};
+        Shard m_overflow{};
+    };
+
+    // a counter that threads update without sharing cache lines, reading it sums the shards
+    class sharded_counter {
+    public:
+        void add(std::uint64_t n = 1) noexcept {
+            m_shards.local().value.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        std::uint64_t value() const noexcept {
+            std::uint64_t sum = 0;
+            m_shards.for_each([&](const shard& s) { sum += s.value.load(std::memory_order_relaxed); });
+            return sum;
+        }
+
+    private:
+        struct alignas(cache_line_size) shard {
+            std::atomic<std::uint64_t> value{0};
+        };
+
+        per_thread<shard> m_shards;
+    };
+}
+
+#endif //LESSON_SHARDED_COUNTER_H
@@ -0,0 +1,103 @@
+#ifndef LESSON_STATS_H
+#define LESSON_STATS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "latency_histogram.h"
+#include "sharded_counter.h"
+
+namespace metrics {
+
+    // records moved to disk by a sink that spills its overflow, and read back from there
+    struct spill_stats {
+        std::uint64_t spilled_records = 0;
+        std::uint64_t spilled_bytes = 0;
+        std::uint64_t replayed_records = 0;
+        std::uint64_t replayed_bytes = 0;
+    };
+
+    struct sink_stats {
+        std::string name;
+        std::uint64_t records = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t flushes = 0;
+        std::uint64_t drops = 0;
+        std::uint64_t errors = 0;
+        histogram_snapshot write_latency;
+        spill_stats spill;
+    };
+
+    struct logger_stats {
+        std::string name;
+        std::uint64_t records = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t drops = 0;
+        std::uint64_t errors = 0;
+        histogram_snapshot log_latency;
+        std::vector<sink_stats> sinks;
+    };
+
+    // implemented by sinks that may drop records on their own (e.g. when a collector does not keep up)
+    class idrop_counter {
+    public:
+        virtual std::uint64_t dropped_records() const noexcept = 0;
+        virtual ~idrop_counter() = default;
+    };
+
+    // implemented by sinks that spill the records they cannot keep up with to disk
+    class ispill_counter {
+    public:
+        virtual spill_stats spilled() const noexcept = 0;
+        virtual ~ispill_counter() = default;
+    };
+
+    class sink_metrics {
+    public:
+        void record_write(std::size_t bytes, bool ends_record, std::chrono::nanoseconds latency) noexcept;
+        void record_flush(std::chrono::nanoseconds latency) noexcept;
+        void record_error() noexcept;
+
+        sink_stats snapshot(std::string name, std::uint64_t drops) const;
+
+    private:
+        sharded_counter m_records;
+        sharded_counter m_bytes;
+        sharded_counter m_flushes;
+        sharded_counter m_errors;
+        latency_histogram m_write_latency;
+    };
+
+    // one line summary of a snapshot, used for the periodic stats records
+    std::string format(const logger_stats& stats);
+
+    // all loggers built with stats enabled, the snapshots can be taken from any thread
+    class registry {
+    public:
+        using provider = std::function<logger_stats()>;
+
+        registry(const registry&) = delete;
+        registry& operator=(const registry&) = delete;
+
+        std::size_t add(provider source);
+        void remove(std::size_t id);
+
+        std::vector<logger_stats> snapshot() const;
+
+        static registry& get_instance();
+
+    private:
+        registry() = default;
+
+        mutable std::mutex m_mutex;
+        std::vector<std::pair<std::size_t, provider>> m_providers;
+        std::size_t m_next_id = 0;
+    };
+}
+
+#endif //LESSON_STATS_H
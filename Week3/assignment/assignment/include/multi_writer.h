@@ -6,20 +6,51 @@
 #define LESSON_MULTI_WRITER_H
 
 #include "itext_writer.h"
-#include <unordered_map>
+#include "circuit_breaker_writer.h"
+#include "async_writer.h"
+#include "metrics/stats.h"
+#include "shared_record.h"
+#include <optional>
+#include <atomic>
 #include <string_view>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace writers {
+    /*
+     * Writes every token to all of its sinks. The set of sinks is an immutable snapshot that writing
+     * threads read without locks; add_writer and remove_writer publish a new snapshot, so sinks can be
+     * changed while other threads keep logging. A removed sink is destroyed once no thread writes to it.
+     * A whole record is copied at most once: sinks that keep records (io::irecord_holder, e.g. async
+     * sinks) all get a reference to the same shared_record, the others write the caller's bytes.
+     */
     class multi_writer : public io::itext_writer {
     public:
         multi_writer();
 
+        multi_writer(const multi_writer&) = delete;
+        multi_writer& operator=(const multi_writer&) = delete;
+
         void add_writer(const std::string& name, std::unique_ptr<io::itext_writer> writer);
+        // the sink is isolated from the caller and the other sinks once it goes over the latency budget
+        void add_writer(const std::string& name, std::unique_ptr<io::itext_writer> writer,
+                        const circuit_breaker_writer::policy& isolation);
+        // the sink is written by its own thread through a bounded queue, overflow is handled as configured
+        void add_writer(const std::string& name, std::unique_ptr<io::itext_writer> writer,
+                        const async_writer::options& queueing);
         void remove_writer(const std::string& name);
 
-        virtual ~multi_writer() override = default;
+        // from now on measures records, bytes, flushes, errors and write latency of every sink
+        void enable_metrics();
+        std::vector<metrics::sink_stats> stats() const;
+        // breaker state of a sink added with an isolation policy
+        std::optional<circuit_breaker_writer::health> health(const std::string& name) const;
+
+        virtual ~multi_writer() override;
+
+        using io::itext_writer::operator<<;
 
         virtual itext_writer& operator<<(std::string_view view) override;
 
@@ -31,8 +62,43 @@ namespace writers {
 
         virtual itext_writer& operator<<(io::flush_t flush) override;
 
+        // true when at least one sink wants records
+        virtual bool wants_records() const override;
+
     private:
-        std::unordered_map<std::string, std::unique_ptr<io::itext_writer>> m_writers;
+        struct sink {
+            std::string name;
+            std::unique_ptr<io::itext_writer> writer;
+            // the writer itself, when it counts the records it drops
+            const metrics::idrop_counter* drops;
+            const circuit_breaker_writer* breaker;
+            const metrics::ispill_counter* spill;
+            // the writer itself, when it keeps records after the write
+            io::irecord_holder* holder;
+            // set once by enable_metrics, owned by metrics_storage
+            std::atomic<metrics::sink_metrics*> metrics{nullptr};
+            std::unique_ptr<metrics::sink_metrics> metrics_storage;
+            // sinks are not thread safe, the tokens of different threads are written one at a time
+            std::mutex mutex;
+        };
+
+        // snapshots are never modified once published
+        using sink_set = std::vector<std::shared_ptr<sink>>;
+
+        template <typename T>
+        void write_all(const T& value, std::size_t bytes, bool ends_record);
+        // calls write(sink) for every sink, under its mutex and timed when metrics are enabled
+        template <typename Write>
+        void for_each_sink(std::size_t bytes, bool ends_record, Write&& write);
+        void write_record(std::string_view record);
+
+        void add_sink(std::shared_ptr<sink> s);
+        // expects m_update_mutex to be held
+        void publish(const sink_set* next);
+
+        std::atomic<const sink_set*> m_sinks;
+        std::mutex m_update_mutex;
+        bool m_metrics;
     };
 }
 
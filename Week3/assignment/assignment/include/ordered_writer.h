@@ -0,0 +1,133 @@
+#ifndef LESSON_ORDERED_WRITER_H
+#define LESSON_ORDERED_WRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "itext_writer.h"
+#include "metrics/sharded_counter.h"
+
+namespace writers {
+
+    /*
+     * Lets every thread write into a ring of its own and still produces one file in true time order.
+     * Each record is stamped with steady_clock when it is complete; a merge thread takes the records
+     * from the rings every merge_interval and writes them to the inner writer with a k-way heap merge.
+     * A record is only written once no thread can produce an older one anymore: every thread publishes
+     * the stamp of the record it is about to add on its own cache line, and the merge stops below the
+     * oldest of them. A thread that is stalled in the middle of a record (e.g. preempted) holds the
+     * merge back for at most reorder_window; a record that arrives later than that is written at once
+     * and counted as late. When a ring is full its thread waits for the merge thread. Records longer
+     * than half a ring are truncated and counted. The ring of a thread that exits is written out and
+     * released by the merge thread, an unfinished record of it is finished first.
+     */
+    class ordered_writer : public io::itext_writer {
+    public:
+        struct options {
+            // per thread, rounded up to a power of two
+            std::size_t ring_bytes = 256 * 1024;
+            std::chrono::milliseconds merge_interval{1};
+            std::chrono::milliseconds reorder_window{50};
+            // every record starts with its stamp, 16 hexadecimal digits of nanoseconds, and a space
+            bool stamp_prefix = false;
+        };
+
+        explicit ordered_writer(std::unique_ptr<io::itext_writer> inner);
+
+        ordered_writer(std::unique_ptr<io::itext_writer> inner, options opts);
+
+        ordered_writer(const ordered_writer&) = delete;
+        ordered_writer& operator=(const ordered_writer&) = delete;
+
+        // merges and writes out everything, the writing threads have to be done
+        virtual ~ordered_writer() override;
+
+        using io::itext_writer::operator<<;
+
+        virtual itext_writer& operator<<(std::string_view view) override;
+
+        virtual itext_writer& operator<<(const char* string) override;
+
+        virtual itext_writer& operator<<(char c) override;
+
+        virtual itext_writer& operator<<(int n) override;
+
+        // the inner writer is flushed after the next merge
+        virtual itext_writer& operator<<(io::flush_t) override;
+
+        // records that arrived after younger ones had been written
+        std::uint64_t late_records() const noexcept;
+        // times a thread found its ring full
+        std::uint64_t full_waits() const noexcept;
+        // records cut to half the ring
+        std::uint64_t truncated_records() const noexcept;
+
+    private:
+        static constexpr std::uint64_t idle = UINT64_MAX;
+        static constexpr std::uint64_t busy = 0;
+
+        // written by one thread, read by the merge thread
+        struct producer {
+            // idle, busy (taking its stamp) or the stamp of the record being added
+            alignas(metrics::cache_line_size) std::atomic<std::uint64_t> pending{idle};
+            std::atomic<std::uint64_t> sequence{0};
+
+            alignas(metrics::cache_line_size) std::atomic<std::size_t> head{0};
+            std::size_t cached_tail = 0;
+            std::string partial;
+
+            alignas(metrics::cache_line_size) std::atomic<std::size_t> tail{0};
+            // what the merge thread saw last, to tell a stalled thread from a busy one
+            std::uint64_t seen_pending = idle;
+            std::uint64_t seen_sequence = 0;
+            std::uint64_t seen_since = 0;
+
+            std::unique_ptr<char[]> storage;
+
+            // set when the thread exits, the merge thread then owns the producer side as well
+            std::atomic<bool> orphaned{false};
+            // set when the writer is destroyed, the thread drops the producer on its next lookup
+            std::atomic<bool> detached{false};
+        };
+
+        friend struct producer_holder;
+
+        producer& local_producer();
+        void append(std::string_view tokens);
+        void push(producer& p, std::string_view record);
+        void merge_loop(std::stop_token stop);
+        // writes the records up to watermark in stamp order, everything when final
+        void merge(bool final);
+
+        const options m_opts;
+        const std::size_t m_mask;
+        // tells the per-thread cache of one ordered_writer from another's, ids are never reused
+        const std::uint64_t m_id;
+
+        // shared with the producer_holder of each thread
+        std::mutex m_producers_mutex;
+        std::vector<std::shared_ptr<producer>> m_producers;
+
+        // only touched by the merge thread
+        std::unique_ptr<io::itext_writer> m_inner;
+        std::vector<producer*> m_merging;
+        std::string m_out;
+        std::uint64_t m_last_written = 0;
+
+        std::atomic<bool> m_flush_requested{false};
+        std::atomic<std::uint64_t> m_late{0};
+        std::atomic<std::uint64_t> m_truncated{0};
+        metrics::sharded_counter m_full_waits;
+
+        std::jthread m_merger;
+    };
+}
+
+#endif //LESSON_ORDERED_WRITER_H
@@ -0,0 +1,89 @@
+#ifndef LESSON_EPOCH_H
+#define LESSON_EPOCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "metrics/sharded_counter.h"
+
+namespace rcu {
+
+    /*
+     * Epoch based reclamation for read-mostly data. Readers enter a guard, load the shared pointer
+     * and use the object without taking locks. Writers publish a new object, retire the old one and
+     * it is freed once every thread that could still see it has left its guard.
+     */
+    class epoch_domain {
+    public:
+        using deleter_t = void (*)(void*);
+
+        epoch_domain(const epoch_domain&) = delete;
+        epoch_domain& operator=(const epoch_domain&) = delete;
+
+        ~epoch_domain();
+
+        // guards nest, only the outermost one is announced
+        void enter() noexcept;
+        void leave() noexcept;
+
+        // object must no longer be reachable from any shared pointer
+        void retire(void* object, deleter_t deleter);
+
+        template <typename T>
+        void retire(const T* object) {
+            retire(const_cast<T*>(object), [](void* p) { delete static_cast<T*>(p); });
+        }
+
+        // frees everything retired so far, waiting for readers when needed; never call it inside a guard
+        void synchronize();
+
+        static epoch_domain& get_instance();
+
+    private:
+        struct alignas(metrics::cache_line_size) thread_record {
+            // epoch seen when the outermost guard was entered, 0 outside of guards
+            std::atomic<std::uint64_t> epoch{0};
+            std::atomic<bool> in_use{false};
+            unsigned nesting = 0;
+            thread_record* next = nullptr;
+        };
+
+        struct retired {
+            void* object;
+            deleter_t deleter;
+            std::uint64_t epoch;
+        };
+
+        friend struct record_holder;
+
+        epoch_domain() = default;
+
+        thread_record& local_record();
+        thread_record* acquire_record();
+
+        // both expect m_mutex to be held
+        bool try_advance();
+        std::vector<retired> collect();
+
+        static void run(const std::vector<retired>& ready);
+
+        std::atomic<std::uint64_t> m_epoch{1};
+        std::atomic<thread_record*> m_records{nullptr};
+
+        std::mutex m_mutex;
+        std::vector<retired> m_retired;
+    };
+
+    class guard {
+    public:
+        guard() noexcept { epoch_domain::get_instance().enter(); }
+        ~guard() { epoch_domain::get_instance().leave(); }
+
+        guard(const guard&) = delete;
+        guard& operator=(const guard&) = delete;
+    };
+}
+
+#endif //LESSON_EPOCH_H
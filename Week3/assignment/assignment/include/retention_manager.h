@@ -0,0 +1,116 @@
+#ifndef LESSON_RETENTION_MANAGER_H
+#define LESSON_RETENTION_MANAGER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "global/clock_source.h"
+#include "../clib/logger.h"
+
+namespace writers {
+
+    /*
+     * Keeps the files rolled by lg_logger within a budget of bytes, files and age. The manager learns
+     * about every closed file from the loggers it is attached to and keeps the list in memory, oldest
+     * first; the directory is only listed once, in the constructor, to adopt the files of earlier runs.
+     * The newest file of every logger is left out, it may still be written; adopted files are stamped
+     * with their age on the manager's clock.
+     * A background thread compresses the rolled files (gzip, when enabled) and deletes the oldest ones
+     * until the budgets are met; the logging threads only queue the name of a closed file.
+     * A file counts with its sidecar index, which goes away with it.
+     */
+    class retention_manager {
+    public:
+        struct policy {
+            // 0 leaves a budget out
+            std::uint64_t max_bytes = 0;
+            std::size_t max_files = 0;
+            std::chrono::seconds max_age{0};
+            // rolled files are replaced by file.gz, except for the newest keep_uncompressed ones
+            bool compress = false;
+            std::size_t keep_uncompressed = 0;
+            // how often the age budget is checked when no file is rolled
+            std::chrono::milliseconds check_interval{1000};
+        };
+
+        struct totals {
+            std::size_t files = 0;
+            std::uint64_t bytes = 0;
+            std::uint64_t removed = 0;
+            std::uint64_t compressed = 0;
+        };
+
+        // throws std::runtime_error when compression is asked for but the library was built without zlib
+        explicit retention_manager(policy p, std::string directory = ".",
+                                   std::shared_ptr<const global::clock_source> clock = global::default_clock());
+
+        retention_manager(const retention_manager&) = delete;
+        retention_manager& operator=(const retention_manager&) = delete;
+
+        // applies the budgets to the files closed so far
+        ~retention_manager();
+
+        // the manager has to outlive the logger, lg_destroy reports the last file
+        void attach(lg_logger_t* log);
+
+        // a closed file that was not written by an attached logger
+        void add_file(std::string path, std::uint64_t bytes);
+
+        // waits until the files added so far have been dealt with
+        void sync();
+
+        totals stats() const;
+
+    private:
+        struct tracked_file {
+            std::string path;
+            // including the sidecar index
+            std::uint64_t bytes;
+            global::clock_source::wall_time closed;
+            // neither compressed nor failed to compress yet
+            bool compressible;
+        };
+
+        struct closed_file {
+            std::string path;
+            std::uint64_t bytes;
+            global::clock_source::wall_time closed;
+        };
+
+        static void on_roll(void* ctx, const char* path, std::size_t bytes);
+
+        void adopt_existing();
+        void run();
+        // expects m_mutex to be held, unlocks it around the file operations
+        void apply(std::unique_lock<std::mutex>& lock);
+        // false when the file stays as it is
+        bool compress(tracked_file& file);
+        void remove(const tracked_file& file);
+
+        const policy m_policy;
+        const std::string m_directory;
+        const std::shared_ptr<const global::clock_source> m_clock;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wakeup;
+        std::condition_variable m_idle;
+        std::vector<closed_file> m_queue;
+        // only touched by the background thread, m_totals is published under m_mutex
+        std::deque<tracked_file> m_files;
+        totals m_totals;
+        std::uint64_t m_queued = 0;
+        std::uint64_t m_applied = 0;
+        bool m_stop = false;
+
+        std::thread m_worker;
+    };
+}
+
+#endif //LESSON_RETENTION_MANAGER_H
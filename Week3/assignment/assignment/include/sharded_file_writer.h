@@ -0,0 +1,96 @@
+#ifndef LESSON_SHARDED_FILE_WRITER_H
+#define LESSON_SHARDED_FILE_WRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "itext_writer.h"
+#include "global/clock_source.h"
+#include "metrics/sharded_counter.h"
+#include "retention_manager.h"
+#include "../clib/logger.h"
+
+namespace writers {
+
+    /*
+     * Every thread writes to rolling files of its own, nothing is shared between the threads once a
+     * thread has its shard. The shards are lg_loggers with the suffix "t<shard number>"
+     * (yymmdd_HHMMSS.N.t3) and every record starts with its wall clock time, 16 hexadecimal digits of
+     * nanoseconds since the epoch, and a space, so logmerge can combine the shards into one ordered file.
+     * The shard of a thread is closed when the thread exits, finishing its unfinished record; a later
+     * thread gets a shard with a new number.
+     * Give it straight to a lib::logger, a multi_writer in front would serialize the threads again. The
+     * logger_builder puts every sink behind its multi_writer, so the logger has to be built by hand.
+     */
+    class sharded_file_writer : public io::itext_writer {
+    public:
+        // the files closed by all shards are handed to retention, when given
+        explicit sharded_file_writer(std::chrono::seconds roll_interval,
+                                     std::shared_ptr<const global::clock_source> clock = global::default_clock(),
+                                     std::shared_ptr<retention_manager> retention = nullptr);
+
+        sharded_file_writer(const sharded_file_writer&) = delete;
+        sharded_file_writer& operator=(const sharded_file_writer&) = delete;
+
+        // closes the shards of the threads still running, they have to be done writing
+        virtual ~sharded_file_writer() override;
+
+        using io::itext_writer::operator<<;
+
+        virtual itext_writer& operator<<(std::string_view view) override;
+
+        virtual itext_writer& operator<<(const char* string) override;
+
+        virtual itext_writer& operator<<(char c) override;
+
+        virtual itext_writer& operator<<(int n) override;
+
+        virtual itext_writer& operator<<(io::flush_t) override;
+
+        // the shards still open
+        std::size_t shards() const;
+
+    private:
+        struct alignas(metrics::cache_line_size) shard {
+            lg_logger_t* log = nullptr;
+            std::string partial;
+            std::string record;
+
+            sharded_file_writer* owner = nullptr;
+            // taken by whoever closes the shard, its thread on exit or the writer's destructor
+            std::mutex close_mutex;
+            // set when the shard is closed, the writer then drops it
+            std::atomic<bool> closed{false};
+            // set when the writer is destroyed, the thread drops the shard on its next lookup
+            std::atomic<bool> detached{false};
+        };
+
+        friend struct shard_holder;
+
+        shard& local_shard();
+        void append(std::string_view tokens);
+        void write_record(shard& s, std::string_view record);
+        // finishes the unfinished record and closes the logger, expects close_mutex of s to be held
+        void close(shard& s) noexcept;
+
+        const std::chrono::seconds m_roll_interval;
+        const std::shared_ptr<const global::clock_source> m_clock;
+        const std::shared_ptr<retention_manager> m_retention;
+        // tells the per-thread cache of one writer from another's, ids are never reused
+        const std::uint64_t m_id;
+
+        // shared with the shard_holder of each thread
+        mutable std::mutex m_mutex;
+        std::vector<std::shared_ptr<shard>> m_shards;
+        // numbers are not reused, a new shard never writes to the files of a closed one
+        std::uint64_t m_next_shard = 0;
+    };
+}
+
+#endif //LESSON_SHARDED_FILE_WRITER_H
@@ -0,0 +1,132 @@
+#ifndef LESSON_SHARED_RECORD_H
+#define LESSON_SHARED_RECORD_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace io {
+
+    class record_pool;
+
+    /*
+     * A reference to an immutable record in a buffer of record_pool. Copies share the buffer, which goes
+     * back to the pool when the last reference is gone, on whichever thread that happens.
+     */
+    class shared_record {
+    public:
+        shared_record() noexcept = default;
+        shared_record(const shared_record& other) noexcept;
+        shared_record(shared_record&& other) noexcept;
+        shared_record& operator=(const shared_record& other) noexcept;
+        shared_record& operator=(shared_record&& other) noexcept;
+        ~shared_record();
+
+        std::string_view view() const noexcept;
+        std::size_t size() const noexcept;
+
+        explicit operator bool() const noexcept { return m_buffer != nullptr; }
+
+    private:
+        friend class record_pool;
+
+        // followed by the bytes of the record
+        struct header {
+            std::atomic<std::uint32_t> refs;
+            std::uint32_t size_class;
+            std::size_t size;
+
+            char* bytes() noexcept { return reinterpret_cast<char*>(this + 1); }
+        };
+
+        explicit shared_record(header* buffer) noexcept : m_buffer{buffer} {}
+
+        void release() noexcept;
+
+        header* m_buffer = nullptr;
+    };
+
+    /*
+     * Buffers for shared records in a few size classes. Released buffers are kept for reuse up to a
+     * budget per class, records longer than the largest class get a buffer of their own.
+     * Every thread keeps a few buffers of each class for itself and trades them with the shared free
+     * lists in batches, so the mutex of a class is taken once per batch instead of once per record.
+     */
+    class record_pool {
+    public:
+        struct totals {
+            std::uint64_t records = 0;
+            std::uint64_t bytes = 0;
+            // taken from a free list instead of allocated
+            std::uint64_t reused = 0;
+        };
+
+        record_pool(const record_pool&) = delete;
+        record_pool& operator=(const record_pool&) = delete;
+
+        ~record_pool();
+
+        // copies bytes into a buffer, the only copy the record's references will ever make
+        shared_record make(std::string_view bytes);
+
+        totals stats() const;
+
+        // has to be used before anything that may hold records in static storage, so it outlives them
+        static record_pool& get_instance();
+
+    private:
+        friend class shared_record;
+
+        static constexpr std::array<std::size_t, 4> CLASS_SIZES{128, 512, 2048, 8192};
+        // bytes kept on the free list of each class
+        static constexpr std::size_t FREE_BUDGET = 512 * 1024;
+        // bytes a thread keeps of each class, half of them move to or from the free list at once
+        static constexpr std::size_t LOCAL_BUDGET = 32 * 1024;
+
+        struct size_class {
+            std::mutex mutex;
+            std::vector<shared_record::header*> free;
+        };
+
+        // the buffers of one thread, handed back to the free lists when the thread exits
+        struct thread_cache {
+            std::array<std::vector<shared_record::header*>, CLASS_SIZES.size()> free;
+
+            ~thread_cache();
+        };
+
+        record_pool() = default;
+
+        static thread_cache* local_cache() noexcept;
+        static void destroy(shared_record::header* buffer) noexcept;
+        static constexpr std::size_t local_capacity(std::size_t index) noexcept { return LOCAL_BUDGET / CLASS_SIZES[index]; }
+
+        void release(shared_record::header* buffer) noexcept;
+        // puts buffers on the free list of their class, those beyond its budget are deleted
+        void give_back(std::size_t index, shared_record::header* const* buffers, std::size_t count) noexcept;
+
+        std::array<size_class, CLASS_SIZES.size()> m_classes;
+
+        std::atomic<std::uint64_t> m_records{0};
+        std::atomic<std::uint64_t> m_bytes{0};
+        std::atomic<std::uint64_t> m_reused{0};
+    };
+
+    /*
+     * Implemented by writers that keep records after the write has returned (e.g. in a queue). They get
+     * whole records as shared_record and keep a reference instead of a copy; multi_writer hands the same
+     * record to all of its sinks that implement this.
+     */
+    struct irecord_holder {
+        // writes the record (ending with a newline), the same as writing record.view()
+        virtual void write(const shared_record& record) = 0;
+
+        virtual ~irecord_holder() = default;
+    };
+}
+
+#endif //LESSON_SHARED_RECORD_H
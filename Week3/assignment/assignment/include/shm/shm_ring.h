@@ -0,0 +1,95 @@
+#ifndef LESSON_SHM_RING_H
+#define LESSON_SHM_RING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace shm {
+
+    /*
+     * A bounded multi-producer / single-consumer ring of fixed-size slots living in a POSIX
+     * shared-memory segment. Producers reserve a slot with a CAS on the tail, then claim and publish it
+     * with CASes on the slot's sequence number, so the push path never enters the kernel.
+     * The consumer (logd --shm) takes back the slots of producers that died or stalled before
+     * publishing; a producer that comes back late finds its slot taken and drops its record.
+     */
+    class ring {
+    public:
+        struct counters {
+            std::uint64_t dropped;
+            std::uint64_t truncated;
+            std::uint64_t abandoned;
+        };
+
+        static constexpr std::size_t default_capacity = 4096;
+        static constexpr std::size_t default_slot_size = 256;
+
+        // opens the segment or creates it when it does not exist yet; capacity is rounded up to a power of two
+        ring(std::string_view name, std::size_t capacity = default_capacity, std::size_t slot_size = default_slot_size);
+
+        ring(const ring&) = delete;
+        ring& operator=(const ring&) = delete;
+
+        ~ring();
+
+        // producer side, lock-free and syscall-free; false when the ring is full
+        bool try_push(std::string_view record) noexcept;
+
+        // consumer side, calls on_record(std::string_view) for every published record in order
+        template <typename F>
+        std::size_t drain(F&& on_record, std::chrono::milliseconds stall_timeout = std::chrono::milliseconds{1000});
+
+        std::size_t capacity() const noexcept;
+        std::size_t max_record_size() const noexcept;
+        counters stats() const noexcept;
+
+        // removes the name of the segment, mapped rings stay valid
+        static void unlink(std::string_view name);
+
+    private:
+        struct header;
+        struct slot;
+
+        slot& at(std::uint64_t pos) const noexcept;
+        char* payload(slot& s) const noexcept;
+        bool try_pop(std::string_view& record, std::uint64_t& pos) noexcept;
+        void release(std::uint64_t pos) noexcept;
+        bool is_abandoned(std::uint64_t pos, std::chrono::milliseconds stall_timeout);
+        // false when the producer published or claimed the slot in the meantime
+        bool reclaim(std::uint64_t pos) noexcept;
+
+        std::string m_name;
+        header* m_header = nullptr;
+        std::size_t m_mapped_size = 0;
+
+        // consumer bookkeeping for a slot that is reserved but not published yet
+        std::uint64_t m_stalled_pos = ~std::uint64_t{0};
+        std::chrono::steady_clock::time_point m_stalled_since{};
+    };
+
+    template <typename F>
+    std::size_t ring::drain(F&& on_record, std::chrono::milliseconds stall_timeout) {
+        std::size_t drained = 0;
+        std::string_view record;
+        std::uint64_t pos;
+
+        while (true) {
+            if (try_pop(record, pos)) {
+                on_record(record);
+                release(pos);
+                ++drained;
+            } else if (is_abandoned(pos, stall_timeout)) {
+                reclaim(pos);
+            } else {
+                break;
+            }
+        }
+        return drained;
+    }
+}
+
+#endif //LESSON_SHM_RING_H
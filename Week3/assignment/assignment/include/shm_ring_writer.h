@@ -0,0 +1,47 @@
+#ifndef LESSON_SHM_RING_WRITER_H
+#define LESSON_SHM_RING_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "itext_writer.h"
+#include "metrics/stats.h"
+#include "shm/shm_ring.h"
+
+namespace writers {
+
+    // pushes every newline-terminated record into a shared-memory ring drained by logd --shm
+    class shm_ring_writer : public io::itext_writer, public metrics::idrop_counter {
+    public:
+        shm_ring_writer(std::string_view ring_name);
+
+        shm_ring_writer(std::string_view ring_name, std::size_t capacity, std::size_t slot_size);
+
+        using io::itext_writer::operator<<;
+
+        virtual itext_writer& operator<<(std::string_view view) override;
+
+        virtual itext_writer& operator<<(const char* string) override;
+
+        virtual itext_writer& operator<<(char c) override;
+
+        virtual itext_writer& operator<<(int n) override;
+
+        virtual itext_writer& operator<<(io::flush_t) override;
+
+        shm::ring::counters stats() const noexcept;
+
+        // records dropped by all producers of the ring
+        virtual std::uint64_t dropped_records() const noexcept override;
+
+    private:
+        void append(std::string_view data);
+        void push_record();
+
+        shm::ring m_ring;
+        std::string m_record;
+    };
+}
+
+#endif //LESSON_SHM_RING_WRITER_H
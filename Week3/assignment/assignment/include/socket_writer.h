@@ -0,0 +1,90 @@
+#ifndef LESSON_SOCKET_WRITER_H
+#define LESSON_SOCKET_WRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "itext_writer.h"
+#include "metrics/stats.h"
+#include "../clib/logger.h"
+
+namespace writers {
+
+    /*
+     * Sends newline-terminated records to a local collector (logd) over a UNIX domain socket.
+     * Records are batched and only complete records are ever put on the wire, so the collector
+     * can merge the streams of many processes without interleaving partial lines.
+     * While the collector is unreachable the records go to local rolling files (lg_logger) instead.
+     */
+    class socket_writer : public io::itext_writer, public metrics::idrop_counter {
+    public:
+        enum class socket_type { stream, datagram };
+
+        // what to do when the collector does not keep up and max_pending_bytes is exceeded
+        enum class backpressure { block, drop, fallback };
+
+        struct options {
+            socket_type type = socket_type::stream;
+            backpressure on_full = backpressure::block;
+            std::size_t batch_bytes = 16 * 1024;
+            std::size_t max_pending_bytes = 1024 * 1024;
+            std::chrono::milliseconds block_timeout{100};
+            std::chrono::milliseconds reconnect_interval{1000};
+            std::chrono::seconds fallback_roll_interval{3600};
+        };
+
+        socket_writer(std::string_view path);
+
+        socket_writer(std::string_view path, options opts);
+
+        socket_writer(const socket_writer&) = delete;
+        socket_writer& operator=(const socket_writer&) = delete;
+
+        virtual ~socket_writer() override;
+
+        using io::itext_writer::operator<<;
+
+        virtual itext_writer& operator<<(std::string_view view) override;
+
+        virtual itext_writer& operator<<(const char* string) override;
+
+        virtual itext_writer& operator<<(char c) override;
+
+        virtual itext_writer& operator<<(int n) override;
+
+        virtual itext_writer& operator<<(io::flush_t) override;
+
+        bool connected() const noexcept;
+        virtual std::uint64_t dropped_records() const noexcept override;
+        std::uint64_t fallback_records() const noexcept;
+
+    private:
+        void append(std::string_view data);
+        void send_complete_records();
+        // sends the rest of the record a partial send stopped in, on the same connection, for at most
+        // block_timeout; then the connection is closed and the tail dropped. Returns the offset behind that record
+        std::size_t finish_record(std::string_view records, std::size_t sent);
+        bool try_connect();
+        void disconnect();
+        // returns the number of bytes accepted by the socket or -1 when the collector is gone
+        long send_some(std::string_view data);
+        bool wait_writable();
+        void write_fallback(std::string_view records);
+        void drop(std::string_view records);
+
+        std::string m_path;
+        options m_opts;
+        int m_fd = -1;
+        std::chrono::steady_clock::time_point m_next_connect{};
+
+        std::string m_buffer;
+        lg_logger_t* m_fallback = nullptr;
+        std::atomic<std::uint64_t> m_dropped{0};
+        std::atomic<std::uint64_t> m_fallback_records{0};
+    };
+}
+
+#endif //LESSON_SOCKET_WRITER_H
@@ -18,6 +18,8 @@ namespace writers {
 
         stream_writer(std::unique_ptr<std::ostream> out);
 
+        using io::itext_writer::operator<<;
+
         virtual itext_writer& operator<<(std::string_view view) override;
 
         virtual itext_writer& operator<<(const char* string) override;
@@ -0,0 +1,123 @@
+#ifndef LESSON_TRACE_SPAN_H
+#define LESSON_TRACE_SPAN_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "itext_writer.h"
+#include "metrics/sharded_counter.h"
+
+namespace tracing {
+
+    namespace detail {
+        // read on every span, so it is a plain constant-initialized atomic and not behind a singleton
+        inline constinit std::atomic<bool> enabled{false};
+    }
+
+    inline bool enabled() noexcept {
+        return detail::enabled.load(std::memory_order_relaxed);
+    }
+
+    struct event {
+        // names and categories are not copied, they have to live as long as the program (string literals)
+        const char* name;
+        const char* category;
+        std::int64_t steady_ns;
+        char phase;
+    };
+
+    /*
+     * Collects the begin and end events of trace_spans. Every thread records into its own ring without
+     * locks; a collector thread drains the rings every interval and streams the events to the sink as
+     * Chrome trace-event JSON (chrome://tracing, Perfetto). A span only begins when its ring has room for
+     * its end event as well, so when a ring fills up whole spans are dropped and begin/end always pair up.
+     */
+    class tracer {
+    public:
+        tracer(const tracer&) = delete;
+        tracer& operator=(const tracer&) = delete;
+
+        ~tracer();
+
+        void start(std::unique_ptr<io::itext_writer> sink, std::chrono::milliseconds interval = std::chrono::milliseconds{100});
+        // writes out the remaining events and closes the JSON array
+        void stop();
+
+        // false when the event was dropped
+        bool record(const char* name, const char* category, char phase) noexcept;
+
+        std::uint64_t dropped_events() const noexcept;
+
+        static tracer& get_instance();
+
+    private:
+        static constexpr std::size_t ring_capacity = 8192;
+
+        // single producer (the owning thread), single consumer (the collector)
+        struct ring {
+            alignas(metrics::cache_line_size) std::atomic<std::size_t> head{0};
+            alignas(metrics::cache_line_size) std::atomic<std::size_t> tail{0};
+            std::atomic<bool> orphaned{false};
+            int tid;
+            // spans begun and not yet ended, their end events have a slot reserved
+            std::size_t open = 0;
+            event events[ring_capacity];
+        };
+
+        friend struct ring_holder;
+
+        tracer() = default;
+
+        ring* local_ring() noexcept;
+        void collect();
+        void write_events(const ring& r, std::size_t from, std::size_t to);
+
+        std::mutex m_mutex;
+        std::vector<std::shared_ptr<ring>> m_rings;
+
+        // only the collector touches the sink and the output buffer
+        std::mutex m_sink_mutex;
+        std::unique_ptr<io::itext_writer> m_sink;
+        std::string m_out;
+        bool m_first_event = true;
+        int m_pid = 0;
+
+        metrics::sharded_counter m_dropped;
+        std::jthread m_collector;
+    };
+
+    // a span of the calling thread, cheap enough to leave in the code: a disabled span costs one branch
+    class trace_span {
+    public:
+        explicit trace_span(const char* name, const char* category = "app") noexcept :
+            m_name{enabled() && tracer::get_instance().record(name, category, 'B') ? name : nullptr},
+            m_category{category}
+        {}
+
+        ~trace_span() {
+            if (m_name) {
+                tracer::get_instance().record(m_name, m_category, 'E');
+            }
+        }
+
+        trace_span(const trace_span&) = delete;
+        trace_span& operator=(const trace_span&) = delete;
+
+    private:
+        const char* m_name;
+        const char* m_category;
+    };
+}
+
+#define TRACE_SPAN_CONCAT_(a, b) a##b
+#define TRACE_SPAN_NAME_(line) TRACE_SPAN_CONCAT_(trace_span_, line)
+// traces the rest of the enclosing scope
+#define TRACE_SPAN(...) ::tracing::trace_span TRACE_SPAN_NAME_(__LINE__){__VA_ARGS__}
+
+#endif //LESSON_TRACE_SPAN_H
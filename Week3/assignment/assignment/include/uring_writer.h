@@ -0,0 +1,103 @@
+#ifndef LESSON_URING_WRITER_H
+#define LESSON_URING_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "itext_writer.h"
+
+namespace writers {
+
+    /*
+     * Writes to a file without blocking the logging thread in write(2). Records are gathered in one of
+     * several page-aligned buffers; a full buffer is handed to the kernel through io_uring and the next
+     * one is filled while the others are being written. The buffers are registered with the ring, so the
+     * kernel does not have to map them for every write. Where io_uring is not available (old kernel,
+     * seccomp, kernel.io_uring_disabled) a few threads write the buffers with pwritev(2) instead.
+     * The writer keeps the file offset itself, so it has to be the only one writing to the file.
+     */
+    class uring_writer : public io::itext_writer {
+    public:
+        struct options {
+            std::size_t buffer_size = 256 * 1024;
+            // all but the one being filled can be in flight at once
+            unsigned buffers = 8;
+            // continue at the end of the file, otherwise the file is truncated as stream_writer does
+            bool append = false;
+            // threads writing the buffers when io_uring is not available
+            unsigned fallback_threads = 2;
+            // skips io_uring, e.g. to measure the fallback
+            bool force_fallback = false;
+        };
+
+        // writes buffers handed to it and reports the ones that are done, see uring_writer.cpp
+        class engine;
+
+        explicit uring_writer(const char* fname);
+
+        uring_writer(const char* fname, options opts);
+
+        uring_writer(const uring_writer&) = delete;
+        uring_writer& operator=(const uring_writer&) = delete;
+
+        // writes out what is still buffered and waits for all writes
+        virtual ~uring_writer() override;
+
+        using io::itext_writer::operator<<;
+
+        virtual itext_writer& operator<<(std::string_view view) override;
+
+        virtual itext_writer& operator<<(const char* string) override;
+
+        virtual itext_writer& operator<<(char c) override;
+
+        virtual itext_writer& operator<<(int n) override;
+
+        // formatted straight into the buffer like int
+        virtual itext_writer& operator<<(long n) override;
+
+        virtual itext_writer& operator<<(unsigned long n) override;
+
+        virtual itext_writer& operator<<(long long n) override;
+
+        virtual itext_writer& operator<<(unsigned long long n) override;
+
+        virtual itext_writer& operator<<(double n) override;
+
+        // returns once everything written so far is in the file (not necessarily on disk)
+        virtual itext_writer& operator<<(io::flush_t) override;
+
+        bool uses_io_uring() const noexcept;
+
+    private:
+        struct free_deleter {
+            void operator()(char* p) const noexcept { std::free(p); }
+        };
+
+        char* current() const noexcept { return m_buffers.get() + m_current * m_opts.buffer_size; }
+        // enough for any 64-bit integer and the shortest form of any double
+        static constexpr std::size_t max_number_length = 32;
+
+        template <typename T>
+        itext_writer& format(T n);
+
+        // takes a free buffer, waiting when all others are in flight, and hands the current one to the engine;
+        // throws when a write failed, or drops the current buffer and throws when the engine cannot wait
+        void submit_current();
+
+        options m_opts;
+        int m_fd = -1;
+        std::unique_ptr<char, free_deleter> m_buffers;
+        std::unique_ptr<engine> m_engine;
+
+        std::vector<unsigned> m_free;
+        unsigned m_current = 0;
+        std::size_t m_used = 0;
+        std::uint64_t m_offset = 0;
+    };
+}
+
+#endif //LESSON_URING_WRITER_H
@@ -12,6 +12,7 @@
 #include "decorators/runningtime_decorator.h"
 #include "clib/logger.h"
 #include "builders/logger_builder.h"
+#include "global/clock_source.h"
 
 #include <iostream>
 #include <memory>
@@ -20,14 +21,20 @@
 #include <cstdbool>
 
 void demo_lg_logger(){
+    // the files roll on virtual time, so the demo does not have to sleep
+    global::virtual_clock clock{std::chrono::system_clock::now()};
+
     lg_logger_t* logger{nullptr};
     lg_create(&logger, 3);
     lg_set_debug_output(logger, true);
+    lg_set_clock(logger, [](void* ctx) {
+        return std::chrono::system_clock::to_time_t(static_cast<global::virtual_clock*>(ctx)->now());
+    }, &clock);
 
     lg_log(logger, "Hello world");
-    std::this_thread::sleep_for(std::chrono::seconds{6});
+    clock.advance(std::chrono::seconds{6});
     lg_log(logger, "Once more...");
-    std::this_thread::sleep_for(std::chrono::seconds{6});
+    clock.advance(std::chrono::seconds{6});
     lg_log(logger, "And once more...");
 
     lg_destroy(&logger);
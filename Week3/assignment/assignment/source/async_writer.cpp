@@ -0,0 +1,296 @@
+#include "async_writer.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+    int open_spill_file(const std::string& configured) {
+        std::string directory = configured;
+        if (directory.empty()) {
+            auto tmpdir = std::getenv("TMPDIR");
+            directory = (tmpdir && *tmpdir) ? tmpdir : "/tmp";
+        }
+
+#ifdef O_TMPFILE
+        int fd = ::open(directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+        if (fd >= 0) {
+            return fd;
+        }
+#endif
+        // file systems without O_TMPFILE: create a named file and unlink it right away
+        std::string path = directory + "/logspill.XXXXXX";
+        int fd_named = ::mkstemp(path.data());
+        if (fd_named >= 0) {
+            ::unlink(path.c_str());
+            ::fcntl(fd_named, F_SETFD, FD_CLOEXEC);
+        }
+        return fd_named;
+    }
+
+    bool write_fully(int fd, std::string_view data, std::uint64_t offset) {
+        while (!data.empty()) {
+            auto written = ::pwrite(fd, data.data(), data.size(), static_cast<off_t>(offset));
+            if (written < 0) {
+                return false;
+            }
+            data.remove_prefix(static_cast<std::size_t>(written));
+            offset += static_cast<std::uint64_t>(written);
+        }
+        return true;
+    }
+}
+
+writers::async_writer::async_writer(std::unique_ptr<io::itext_writer> inner) :
+    async_writer(std::move(inner), options{})
+{}
+
+writers::async_writer::async_writer(std::unique_ptr<io::itext_writer> inner, options opts) :
+    m_inner{std::move(inner)},
+    m_opts{std::move(opts)},
+    m_inner_drops{dynamic_cast<const metrics::idrop_counter*>(m_inner.get())}
+{
+    // the pool has to outlive the queue, including the queues of static writers
+    io::record_pool::get_instance();
+    m_consumer = std::thread{&async_writer::consume, this};
+}
+
+writers::async_writer::~async_writer() {
+    {
+        std::unique_lock lock{m_mutex};
+        if (!m_pending.empty()) {
+            // ended like every other record, so a spilled backlog still ends on a newline
+            m_pending += '\n';
+            enqueue(io::record_pool::get_instance().make(m_pending), lock);
+            m_pending.clear();
+        }
+        m_stop = true;
+    }
+    m_queued.notify_one();
+    m_space.notify_all();
+    m_consumer.join();
+
+    if (m_spill_fd >= 0) {
+        ::close(m_spill_fd);
+    }
+}
+
+io::itext_writer& writers::async_writer::operator<<(std::string_view view) {
+    append(view);
+    return *this;
+}
+
+io::itext_writer& writers::async_writer::operator<<(const char* string) {
+    append(string);
+    return *this;
+}
+
+io::itext_writer& writers::async_writer::operator<<(char c) {
+    append({&c, 1});
+    return *this;
+}
+
+io::itext_writer& writers::async_writer::operator<<(int n) {
+    char temp[12];
+    auto result = std::to_chars(temp, temp + sizeof(temp), n);
+    append({temp, static_cast<std::size_t>(result.ptr - temp)});
+    return *this;
+}
+
+io::itext_writer& writers::async_writer::operator<<(io::flush_t) {
+    // the inner writer is flushed by the consumer once it has written everything before the flush
+    {
+        std::lock_guard lock{m_mutex};
+        m_flush_requested = true;
+    }
+    m_queued.notify_one();
+    return *this;
+}
+
+std::uint64_t writers::async_writer::dropped_records() const noexcept {
+    return m_dropped.load(std::memory_order_relaxed) + (m_inner_drops ? m_inner_drops->dropped_records() : 0);
+}
+
+metrics::spill_stats writers::async_writer::spilled() const noexcept {
+    return {
+        m_spilled_records.load(std::memory_order_relaxed),
+        m_spilled_bytes.load(std::memory_order_relaxed),
+        m_replayed_records.load(std::memory_order_relaxed),
+        m_replayed_bytes.load(std::memory_order_relaxed)
+    };
+}
+
+void writers::async_writer::append(std::string_view token) {
+    std::unique_lock lock{m_mutex};
+
+    // only whole records are queued, so spilling and dropping never tear a record
+    std::size_t newline;
+    while ((newline = token.find('\n')) != std::string_view::npos) {
+        auto& pool = io::record_pool::get_instance();
+        if (m_pending.empty()) {
+            enqueue(pool.make(token.substr(0, newline + 1)), lock);
+        } else {
+            m_pending.append(token.substr(0, newline + 1));
+            enqueue(pool.make(m_pending), lock);
+            m_pending.clear();
+        }
+        token.remove_prefix(newline + 1);
+    }
+    m_pending.append(token);
+}
+
+void writers::async_writer::write(const io::shared_record& record) {
+    auto view = record.view();
+    std::unique_lock lock{m_mutex};
+    // a record that continues tokens written before, or holds several records, is queued record by record
+    if (!m_pending.empty() || view.empty() || view.find('\n') != view.size() - 1) {
+        lock.unlock();
+        append(view);
+        return;
+    }
+    enqueue(record, lock);
+}
+
+void writers::async_writer::enqueue(io::shared_record record, std::unique_lock<std::mutex>& lock) {
+    auto fits = [&] { return m_queue.empty() || m_queued_bytes + record.size() <= m_opts.max_queued_bytes; };
+
+    // anything spilled has to be replayed before newer records may overtake it through the queue
+    bool backlog = m_spill_end > m_spill_begin;
+    if (!backlog && !fits()) {
+        switch (m_opts.on_full) {
+            case overflow::block:
+                m_space.wait(lock, [&] { return m_stop || fits(); });
+                break;
+            case overflow::drop:
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            case overflow::spill:
+                backlog = true;
+                break;
+        }
+    }
+
+    if (backlog) {
+        if (!spill(record.view())) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_queued.notify_one();
+        return;
+    }
+
+    m_queued_bytes += record.size();
+    m_queue.push_back(std::move(record));
+    m_queued.notify_one();
+}
+
+bool writers::async_writer::spill(std::string_view record) {
+    if (m_spill_fd < 0) {
+        m_spill_fd = open_spill_file(m_opts.spill_directory);
+        if (m_spill_fd < 0) {
+            return false;
+        }
+    }
+    if (!write_fully(m_spill_fd, record, m_spill_end)) {
+        return false;
+    }
+
+    m_spill_end += record.size();
+    m_spilled_records.fetch_add(1, std::memory_order_relaxed);
+    m_spilled_bytes.fetch_add(record.size(), std::memory_order_relaxed);
+    return true;
+}
+
+void writers::async_writer::consume() {
+    std::unique_lock lock{m_mutex};
+    for (;;) {
+        m_queued.wait(lock, [this] {
+            return m_stop || m_flush_requested || !m_queue.empty() || m_spill_end > m_spill_begin;
+        });
+
+        // the queue only ever holds records older than the spilled ones
+        if (!m_queue.empty()) {
+            auto batch = std::exchange(m_queue, {});
+            m_queued_bytes = 0;
+            lock.unlock();
+            m_space.notify_all();
+            for (const auto& record : batch) {
+                *m_inner << record.view();
+            }
+            lock.lock();
+            continue;
+        }
+
+        if (m_spill_end > m_spill_begin) {
+            replay_spill(lock);
+            continue;
+        }
+
+        if (m_flush_requested) {
+            m_flush_requested = false;
+            lock.unlock();
+            *m_inner << io::flush;
+            lock.lock();
+            continue;
+        }
+
+        if (m_stop) {
+            lock.unlock();
+            *m_inner << io::flush;
+            return;
+        }
+    }
+}
+
+void writers::async_writer::replay_spill(std::unique_lock<std::mutex>& lock) {
+    auto begin = m_spill_begin;
+    auto end = m_spill_end;
+    lock.unlock();
+
+    // producers only append behind end, so [begin, end) can be read without the lock
+    std::string chunk;
+    auto length = std::min<std::uint64_t>(end - begin, std::max<std::size_t>(m_opts.replay_chunk_bytes, 1));
+    std::size_t consumed = 0;
+    for (;;) {
+        chunk.resize(static_cast<std::size_t>(length));
+        auto read = ::pread(m_spill_fd, chunk.data(), chunk.size(), static_cast<off_t>(begin));
+        if (read <= 0) {
+            // the backlog cannot be read back, it is given up as dropped
+            consumed = static_cast<std::size_t>(end - begin);
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            chunk.clear();
+            break;
+        }
+        chunk.resize(static_cast<std::size_t>(read));
+
+        auto last_newline = chunk.rfind('\n');
+        if (last_newline != std::string::npos) {
+            consumed = last_newline + 1;
+            chunk.resize(consumed);
+            break;
+        }
+        if (static_cast<std::uint64_t>(read) == end - begin) {
+            // the whole backlog without a newline, there is nothing more to wait for
+            consumed = chunk.size();
+            break;
+        }
+        // a single record longer than the chunk
+        length = std::min<std::uint64_t>(end - begin, length * 2);
+    }
+
+    if (!chunk.empty()) {
+        *m_inner << std::string_view{chunk};
+        m_replayed_records.fetch_add(static_cast<std::uint64_t>(std::count(chunk.cbegin(), chunk.cend(), '\n')),
+                                     std::memory_order_relaxed);
+        m_replayed_bytes.fetch_add(chunk.size(), std::memory_order_relaxed);
+    }
+
+    lock.lock();
+    m_spill_begin += consumed;
+    if (m_spill_begin == m_spill_end) {
+        // caught up: the file starts over and new records go through the queue again
+        m_spill_begin = m_spill_end = 0;
+        [[maybe_unused]] auto ignored = ::ftruncate(m_spill_fd, 0);
+    }
+}
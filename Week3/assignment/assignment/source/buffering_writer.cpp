@@ -0,0 +1,138 @@
+#include "buffering_writer.h"
+#include <charconv>
+#include <exception>
+#include <utility>
+
+writers::buffering_writer::buffering_writer(std::unique_ptr<io::itext_writer> inner) :
+    buffering_writer(std::move(inner), options{})
+{}
+
+writers::buffering_writer::buffering_writer(std::unique_ptr<io::itext_writer> inner, options opts) :
+    m_inner{std::move(inner)},
+    m_opts{opts},
+    m_inner_drops{dynamic_cast<const metrics::idrop_counter*>(m_inner.get())}
+{
+    m_buffer.reserve(m_opts.max_bytes + m_opts.max_bytes / 4);
+    m_spare.reserve(m_buffer.capacity());
+    m_timer = std::thread{&buffering_writer::keep_deadlines, this};
+}
+
+writers::buffering_writer::~buffering_writer() {
+    {
+        std::lock_guard lock{m_mutex};
+        m_stop = true;
+    }
+    m_wakeup.notify_one();
+    m_timer.join();
+
+    std::unique_lock lock{m_mutex};
+    pass_on(lock, false, true);
+}
+
+io::itext_writer& writers::buffering_writer::operator<<(std::string_view view) {
+    append(view);
+    return *this;
+}
+
+io::itext_writer& writers::buffering_writer::operator<<(const char* string) {
+    append(string);
+    return *this;
+}
+
+io::itext_writer& writers::buffering_writer::operator<<(char c) {
+    append({&c, 1});
+    return *this;
+}
+
+io::itext_writer& writers::buffering_writer::operator<<(int n) {
+    char temp[12];
+    auto result = std::to_chars(temp, temp + sizeof(temp), n);
+    append({temp, static_cast<std::size_t>(result.ptr - temp)});
+    return *this;
+}
+
+io::itext_writer& writers::buffering_writer::operator<<(io::flush_t) {
+    std::unique_lock lock{m_mutex};
+    pass_on(lock, false, true);
+    return *this;
+}
+
+std::uint64_t writers::buffering_writer::dropped_records() const noexcept {
+    return m_inner_drops ? m_inner_drops->dropped_records() : 0;
+}
+
+void writers::buffering_writer::append(std::string_view token) {
+    std::unique_lock lock{m_mutex};
+    m_buffer.append(token);
+
+    if (!token.empty() && token.back() == '\n') {
+        if (m_records++ == 0) {
+            m_deadline = clock_type::now() + m_opts.max_delay;
+            m_wakeup.notify_one();
+        }
+    }
+
+    if (m_records >= m_opts.max_records || m_buffer.size() >= m_opts.max_bytes) {
+        // a single partial record larger than the buffer goes out as it is
+        pass_on(lock, m_records > 0, false);
+    }
+}
+
+void writers::buffering_writer::pass_on(std::unique_lock<std::mutex>& lock, bool complete_only, bool flush) {
+    auto length = m_buffer.size();
+    if (complete_only) {
+        length = m_buffer.rfind('\n') + 1;
+    }
+    if (!length && !flush) {
+        return;
+    }
+
+    // the chunk keeps the buffer's storage, the buffer continues in the spare one with what is left
+    auto chunk = std::exchange(m_buffer, std::move(m_spare));
+    m_buffer.clear();
+    m_buffer.append(chunk, length);
+    chunk.resize(length);
+    m_records = 0;
+    m_deadline = clock_type::time_point::max();
+    auto ticket = m_taken++;
+    lock.unlock();
+
+    std::exception_ptr failed;
+    {
+        std::unique_lock inner{m_inner_mutex};
+        m_turn.wait(inner, [&] { return m_written == ticket; });
+        try {
+            if (!chunk.empty()) {
+                *m_inner << std::string_view{chunk};
+            }
+            if (flush) {
+                *m_inner << io::flush;
+            }
+        } catch (...) {
+            // the chunks behind this one still get their turn
+            failed = std::current_exception();
+        }
+        ++m_written;
+    }
+    m_turn.notify_all();
+
+    lock.lock();
+    if (failed) {
+        std::rethrow_exception(failed);
+    }
+    if (chunk.capacity() > m_spare.capacity()) {
+        chunk.clear();
+        m_spare = std::move(chunk);
+    }
+}
+
+void writers::buffering_writer::keep_deadlines() {
+    std::unique_lock lock{m_mutex};
+    while (!m_stop) {
+        if (m_deadline == clock_type::time_point::max()) {
+            m_wakeup.wait(lock);
+        } else if (m_wakeup.wait_until(lock, m_deadline) == std::cv_status::timeout && clock_type::now() >= m_deadline) {
+            pass_on(lock, true, true);
+        }
+    }
+}
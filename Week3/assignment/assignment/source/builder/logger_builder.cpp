@@ -8,8 +8,15 @@
 #include "decorators/decorator.h"
 #include "decorators/runningtime_decorator.h"
 #include "decorators/timestamp_decorator.h"
+#include "decorators/stats_decorator.h"
+#include "decorators/backtrace_decorator.h"
 #include "global/runningtime_provider.h"
 #include "clogger_as_writer.h"
+#include "socket_writer.h"
+#include "shm_ring_writer.h"
+#include "buffering_writer.h"
+#include "fd_writer.h"
+#include "uring_writer.h"
 #include <memory>
 
 builders::logger_builder::logger_builder():
@@ -24,24 +31,58 @@ builders::ilogger_builder& builders::logger_builder::reset() {
     m_writer = multi_writer.get();
 
     m_logger = std::make_unique<lib::logger>( std::move(multi_writer) );
+    m_stats_name.reset();
+    m_stats_interval = std::chrono::seconds{0};
+    m_clock = global::default_clock();
+    m_buffering.reset();
+    m_async.reset();
+    m_retention.reset();
     return *this;
 }
 
 builders::ilogger_builder& builders::logger_builder::with_console_output() {
     if (m_writer){
-        m_writer->add_writer("console", std::make_unique<writers::console_writer>() );
+        add_sink("console", std::make_unique<writers::console_writer>() );
     }
     return *this;
 }
 
 builders::ilogger_builder& builders::logger_builder::with_file_output(std::string_view file_name) {
     if (m_writer){
-        m_writer->add_writer(std::string{file_name}, std::make_unique<writers::stream_writer>(file_name.data()) );
+        add_sink(std::string{file_name}, std::make_unique<writers::stream_writer>(file_name.data()) );
+    }
+    return *this;
+}
+
+builders::ilogger_builder& builders::logger_builder::with_file_output(std::string_view file_name, file_output_type type) {
+    if (!m_writer) {
+        return *this;
+    }
+
+    std::string name{file_name};
+    switch (type) {
+        case file_output_type::fd:
+            add_sink(name, std::make_unique<writers::fd_writer>(name.c_str()));
+            break;
+        case file_output_type::fd_dsync:
+            add_sink(name, std::make_unique<writers::fd_writer>(name.c_str(), writers::fd_writer::options{.dsync = true}));
+            break;
+        case file_output_type::uring:
+            add_sink(name, std::make_unique<writers::uring_writer>(name.c_str()));
+            break;
+        case file_output_type::stream:
+        default:
+            add_sink(name, std::make_unique<writers::stream_writer>(name.c_str()));
+            break;
     }
     return *this;
 }
 
 std::unique_ptr<loggers::ilogger> builders::logger_builder::get() {
+    // the stats decorator is the outermost one, so it times the whole logging call
+    if (m_logger && m_stats_name) {
+        m_logger = std::make_unique<lib::decorators::stats_decorator>(std::move(m_logger), *m_stats_name, m_writer, m_stats_interval);
+    }
     m_writer = nullptr;
     return std::move(m_logger);
 }
@@ -56,7 +97,7 @@ builders::ilogger_builder& builders::logger_builder::with_writer(std::unique_ptr
     auto running_time = global::runningtime_provider::get_instance().running_time();
     auto seconds = std::chrono::duration_cast<std::chrono::seconds>(running_time).count();
 
-    m_writer->add_writer(std::to_string(seconds), std::move(writer));
+    add_sink(std::to_string(seconds), std::move(writer));
 
     return *this;
 }
@@ -71,11 +112,11 @@ builders::ilogger_builder& builders::logger_builder::with_timestamp(timestamp_ty
     switch (type)
     {
         case timestamp_type::current_time:
-            m_logger = std::make_unique<lib::decorators::timestamp_decorator>(std::move(m_logger));
+            m_logger = std::make_unique<lib::decorators::timestamp_decorator>(std::move(m_logger), m_clock);
             hasTimestamp = true;
             break;
         case timestamp_type::running_time:
-            m_logger = std::make_unique<lib::decorators::runningtime_decorator>(std::move(m_logger));
+            m_logger = std::make_unique<lib::decorators::runningtime_decorator>(std::move(m_logger), m_clock);
             hasTimestamp = true;
             break;
         case timestamp_type::none:
@@ -88,8 +129,109 @@ builders::ilogger_builder& builders::logger_builder::with_timestamp(timestamp_ty
 
 builders::ilogger_builder& builders::logger_builder::with_rolling_log_with_interval(std::chrono::seconds interval) 
 {
-    auto writer = std::make_unique<io::clogger_as_writer>(interval);
-    m_writer->add_writer(std::to_string(interval.count()), std::move(writer));
+    auto writer = std::make_unique<io::clogger_as_writer>(interval, m_clock, m_retention);
+    add_sink(std::to_string(interval.count()), std::move(writer));
+
+    return *this;
+}
+
+builders::ilogger_builder& builders::logger_builder::with_socket_output(std::string_view socket_path)
+{
+    if (m_writer)
+    {
+        add_sink(std::string{socket_path}, std::make_unique<writers::socket_writer>(socket_path));
+    }
+
+    return *this;
+}
+
+builders::ilogger_builder& builders::logger_builder::with_shm_ring_output(std::string_view ring_name)
+{
+    if (m_writer)
+    {
+        add_sink(std::string{ring_name}, std::make_unique<writers::shm_ring_writer>(ring_name));
+    }
+
+    return *this;
+}
+
+builders::ilogger_builder& builders::logger_builder::with_stats(std::string_view logger_name)
+{
+    if (m_writer)
+    {
+        m_writer->enable_metrics();
+        m_stats_name = std::string{logger_name};
+    }
+
+    return *this;
+}
+
+builders::ilogger_builder& builders::logger_builder::with_stats_report(std::chrono::seconds interval)
+{
+    m_stats_interval = interval;
+
+    return *this;
+}
+
+builders::ilogger_builder& builders::logger_builder::with_clock(global::clock_type type)
+{
+    m_clock = global::make_clock(type);
+
+    return *this;
+}
+
+builders::ilogger_builder& builders::logger_builder::with_clock(std::shared_ptr<const global::clock_source> clock)
+{
+    if (clock)
+    {
+        m_clock = std::move(clock);
+    }
+
+    return *this;
+}
+
+builders::ilogger_builder& builders::logger_builder::with_async(const writers::async_writer::options& queueing)
+{
+    m_async = queueing;
+
+    return *this;
+}
+
+builders::ilogger_builder& builders::logger_builder::with_retention(std::shared_ptr<writers::retention_manager> retention)
+{
+    m_retention = std::move(retention);
+
+    return *this;
+}
+
+builders::ilogger_builder& builders::logger_builder::with_backtrace(std::size_t records)
+{
+    if (m_logger)
+    {
+        m_logger = std::make_unique<lib::decorators::backtrace_decorator>(std::move(m_logger), records);
+    }
+
+    return *this;
+}
+
+builders::ilogger_builder& builders::logger_builder::with_buffering(std::size_t max_bytes, std::size_t max_records,
+                                                                    std::chrono::milliseconds max_delay)
+{
+    m_buffering = writers::buffering_writer::options{max_bytes, max_records, max_delay};
 
     return *this;
+}
+
+void builders::logger_builder::add_sink(const std::string& name, std::unique_ptr<io::itext_writer> writer)
+{
+    if (m_buffering)
+    {
+        writer = std::make_unique<writers::buffering_writer>(std::move(writer), *m_buffering);
+    }
+    if (m_async)
+    {
+        m_writer->add_writer(name, std::move(writer), *m_async);
+        return;
+    }
+    m_writer->add_writer(name, std::move(writer));
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "call_site.h"
+#include <algorithm>
+
+bool loggers::call_site::admit() noexcept {
+    if (!m_registered.load(std::memory_order_acquire)) {
+        // registering only allocates once per site, a failure leaves the site enabled and unregistered
+        try {
+            call_site_registry::get_instance().add(*this);
+        } catch (...) {
+            return true;
+        }
+    }
+    return enabled();
+}
+
+std::size_t loggers::call_site_registry::set_enabled(std::string_view file_suffix, unsigned line, bool on_off) {
+    std::lock_guard lock{m_mutex};
+    rule r{std::string{file_suffix}, line, on_off};
+
+    std::size_t changed = 0;
+    for (auto site : m_sites) {
+        if (matches(r, *site)) {
+            site->set_enabled(on_off);
+            ++changed;
+        }
+    }
+
+    // a newer rule for the same sites replaces the older one
+    std::erase_if(m_rules, [&](const rule& old) { return old.file_suffix == r.file_suffix && old.line == r.line; });
+    m_rules.push_back(std::move(r));
+    return changed;
+}
+
+std::vector<const loggers::call_site*> loggers::call_site_registry::sites() const {
+    std::lock_guard lock{m_mutex};
+    return {m_sites.cbegin(), m_sites.cend()};
+}
+
+loggers::call_site_registry& loggers::call_site_registry::get_instance() {
+    static call_site_registry obj{};
+    return obj;
+}
+
+void loggers::call_site_registry::add(call_site& site) {
+    std::lock_guard lock{m_mutex};
+    if (site.m_registered.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    m_sites.push_back(&site);
+    for (const auto& r : m_rules) {
+        if (matches(r, site)) {
+            site.set_enabled(r.on_off);
+        }
+    }
+    site.m_registered.store(true, std::memory_order_release);
+}
+
+bool loggers::call_site_registry::matches(const rule& r, const call_site& site) noexcept {
+    std::string_view file{site.file()};
+    bool file_matches = file.size() >= r.file_suffix.size()
+                        && file.compare(file.size() - r.file_suffix.size(), r.file_suffix.size(), r.file_suffix) == 0;
+    return file_matches && (r.line == 0 || r.line == site.line());
+}
@@ -0,0 +1,191 @@
+#include "circuit_breaker_writer.h"
+#include <charconv>
+#include <utility>
+
+writers::circuit_breaker_writer::circuit_breaker_writer(std::unique_ptr<io::itext_writer> inner, policy p) :
+    m_inner{std::move(inner)},
+    m_policy{p},
+    m_inner_drops{dynamic_cast<const metrics::idrop_counter*>(m_inner.get())}
+{
+    if (m_policy.on_trip == overflow::queue) {
+        m_drain = std::thread{&circuit_breaker_writer::drain_queue, this};
+    }
+}
+
+writers::circuit_breaker_writer::~circuit_breaker_writer() {
+    if (m_drain.joinable()) {
+        {
+            std::lock_guard lock{m_mutex};
+            m_stop = true;
+        }
+        m_queued.notify_one();
+        m_drain.join();
+    }
+}
+
+io::itext_writer& writers::circuit_breaker_writer::operator<<(std::string_view view) {
+    forward(view);
+    return *this;
+}
+
+io::itext_writer& writers::circuit_breaker_writer::operator<<(const char* string) {
+    forward(string);
+    return *this;
+}
+
+io::itext_writer& writers::circuit_breaker_writer::operator<<(char c) {
+    forward({&c, 1});
+    return *this;
+}
+
+io::itext_writer& writers::circuit_breaker_writer::operator<<(int n) {
+    char temp[12];
+    auto result = std::to_chars(temp, temp + sizeof(temp), n);
+    forward({temp, static_cast<std::size_t>(result.ptr - temp)});
+    return *this;
+}
+
+io::itext_writer& writers::circuit_breaker_writer::operator<<(io::flush_t flush) {
+    {
+        // an isolated sink is flushed by the drain thread, a dropping one has nothing to flush
+        std::lock_guard lock{m_mutex};
+        if (m_state == state::open) {
+            return *this;
+        }
+    }
+    std::lock_guard sink_lock{m_sink_mutex};
+    *m_inner << flush;
+    return *this;
+}
+
+writers::circuit_breaker_writer::health writers::circuit_breaker_writer::status() const {
+    std::lock_guard lock{m_mutex};
+    return {m_state, m_trips, m_dropped, m_queued_bytes};
+}
+
+std::uint64_t writers::circuit_breaker_writer::dropped_records() const noexcept {
+    std::uint64_t dropped;
+    {
+        std::lock_guard lock{m_mutex};
+        dropped = m_dropped;
+    }
+    return dropped + (m_inner_drops ? m_inner_drops->dropped_records() : 0);
+}
+
+void writers::circuit_breaker_writer::forward(std::string_view token) {
+    bool ends_record = !token.empty() && token.back() == '\n';
+
+    std::unique_lock lock{m_mutex};
+    bool starts_record = std::exchange(m_at_record_start, ends_record);
+
+    if (m_state == state::open) {
+        if (m_policy.on_trip == overflow::queue) {
+            // whole records are queued or dropped, so the sink never sees a torn record
+            m_pending.append(token);
+            if (ends_record) {
+                if (m_queued_bytes + m_pending.size() <= m_policy.max_queued_bytes) {
+                    m_queued_bytes += m_pending.size();
+                    m_queue.push_back(std::move(m_pending));
+                    m_queued.notify_one();
+                } else {
+                    ++m_dropped;
+                }
+                m_pending.clear();
+            }
+            return;
+        }
+
+        if (!starts_record || clock_type::now() < m_probe_at) {
+            if (ends_record) {
+                ++m_dropped;
+            }
+            return;
+        }
+        // the next record probes whether the sink has recovered
+        m_state = state::half_open;
+        m_probe_slow = false;
+    }
+
+    lock.unlock();
+    auto latency = timed_write(token);
+    lock.lock();
+
+    bool slow = latency > m_policy.latency_budget;
+    if (m_state == state::half_open) {
+        m_probe_slow = m_probe_slow || slow;
+        if (ends_record) {
+            if (m_probe_slow) {
+                m_state = state::open;
+                m_probe_at = clock_type::now() + m_policy.probe_interval;
+            } else {
+                close();
+            }
+        }
+        return;
+    }
+
+    m_slow_writes = slow ? m_slow_writes + 1 : 0;
+    if (m_slow_writes >= m_policy.trip_after) {
+        m_trip_pending = true;
+    }
+    // the rest of a record goes the same way as its beginning
+    if (m_trip_pending && ends_record) {
+        trip(clock_type::now());
+    }
+}
+
+std::chrono::nanoseconds writers::circuit_breaker_writer::timed_write(std::string_view token) {
+    std::lock_guard sink_lock{m_sink_mutex};
+    auto t0 = clock_type::now();
+    *m_inner << token;
+    return clock_type::now() - t0;
+}
+
+void writers::circuit_breaker_writer::trip(clock_type::time_point now) {
+    m_state = state::open;
+    m_trip_pending = false;
+    m_slow_writes = 0;
+    m_probe_at = now + m_policy.probe_interval;
+    ++m_trips;
+}
+
+void writers::circuit_breaker_writer::close() {
+    m_state = state::closed;
+    m_slow_writes = 0;
+    m_trip_pending = false;
+}
+
+void writers::circuit_breaker_writer::drain_queue() {
+    std::unique_lock lock{m_mutex};
+    for (;;) {
+        m_queued.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+        if (m_queue.empty()) {
+            return;
+        }
+
+        auto batch = std::exchange(m_queue, {});
+        lock.unlock();
+
+        // the queued records double as the recovery probe
+        bool slow = false;
+        std::size_t written = 0;
+        {
+            std::lock_guard sink_lock{m_sink_mutex};
+            for (const auto& record : batch) {
+                auto t0 = clock_type::now();
+                *m_inner << std::string_view{record};
+                slow = slow || clock_type::now() - t0 > m_policy.latency_budget;
+                written += record.size();
+            }
+            *m_inner << io::flush;
+        }
+
+        lock.lock();
+        m_queued_bytes -= written;
+        // only switch back between records, with nothing left behind in the queue
+        if (!slow && m_state == state::open && m_queue.empty() && m_pending.empty()
+            && clock_type::now() >= m_probe_at) {
+            close();
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include "clogger_as_writer.h"
+#include <charconv>
 
 io::clogger_as_writer::clogger_as_writer(std::chrono::seconds roll_interval)
 {
@@ -11,30 +12,54 @@ io::clogger_as_writer::clogger_as_writer(std::chrono::seconds roll_interval)
     }
 }
 
+io::clogger_as_writer::clogger_as_writer(std::chrono::seconds roll_interval, std::shared_ptr<const global::clock_source> clock) :
+    clogger_as_writer(roll_interval)
+{
+    m_clock = std::move(clock);
+    if (m_clock)
+    {
+        lg_set_clock(m_clogger, [](void* ctx) {
+            return std::chrono::system_clock::to_time_t(static_cast<const global::clock_source*>(ctx)->now());
+        }, const_cast<global::clock_source*>(m_clock.get()));
+    }
+}
+
+io::clogger_as_writer::clogger_as_writer(std::chrono::seconds roll_interval, std::shared_ptr<const global::clock_source> clock,
+                                         std::shared_ptr<writers::retention_manager> retention) :
+    clogger_as_writer(roll_interval, std::move(clock))
+{
+    m_retention = std::move(retention);
+    if (m_retention)
+    {
+        m_retention->attach(m_clogger);
+    }
+}
+
 io::clogger_as_writer::~clogger_as_writer()
 {
     if (m_clogger) 
     {
+        if (!m_record.empty())
+        {
+            lg_log(m_clogger, m_record.c_str());
+        }
         [[maybe_unused]] lg_result_e result = lg_destroy(&m_clogger);
     }
 }
 
 io::itext_writer& io::clogger_as_writer::operator<<(char c)
 {
-    char temp[2];
-
-    printf(temp, "%c", c);
-    lg_log(m_clogger, temp);
+    append({&c, 1});
 
     return *this;
 }
 
 io::itext_writer& io::clogger_as_writer::operator<<(int n)
 {
-    char temp[11];
+    char temp[12];
 
-    printf(temp, "%d", n);
-    lg_log(m_clogger, temp);
+    auto [end, ec] = std::to_chars(temp, temp + sizeof(temp), n);
+    append({temp, static_cast<std::size_t>(end - temp)});
 
     return *this;
 }
@@ -46,19 +71,34 @@ io::itext_writer& io::clogger_as_writer::operator<<(io::flush_t)
 
 io::itext_writer& io::clogger_as_writer::operator<<(std::string_view str)
 {
-    lg_result_e result = lg_log(m_clogger, str.data());
-
-    if (result != lgr_ok) 
-    {
-        throw std::runtime_error("lg_log failed to log message");
-    }
+    append(str);
 
     return *this;
 }
 
 io::itext_writer& io::clogger_as_writer::operator<<(const char* str) 
 {
-    lg_log(m_clogger, str);
+    append(str);
 
     return *this;
-}
\ No newline at end of file
+}
+
+void io::clogger_as_writer::append(std::string_view str)
+{
+    // tokens are gathered into records, lg_log gets one call per record and appends the newline itself
+    std::size_t newline;
+    while ((newline = str.find('\n')) != std::string_view::npos)
+    {
+        m_record.append(str.substr(0, newline));
+        str.remove_prefix(newline + 1);
+
+        lg_result_e result = lg_log(m_clogger, m_record.c_str());
+        m_record.clear();
+
+        if (result != lgr_ok) 
+        {
+            throw std::runtime_error("lg_log failed to log message");
+        }
+    }
+    m_record.append(str);
+}
@@ -0,0 +1,123 @@
+#include "decorators/backtrace_decorator.h"
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <cstring>
+#include <string>
+
+namespace lib::decorators {
+
+    // the rings of one thread, one per decorator it logged through; freed when the thread exits
+    struct ring_holder {
+        struct entry {
+            std::uint64_t id;
+            std::shared_ptr<backtrace_decorator::ring> ring;
+        };
+        std::vector<entry> rings;
+    };
+}
+
+namespace {
+    std::atomic<std::uint64_t> next_id{1};
+    thread_local lib::decorators::ring_holder local;
+}
+
+lib::decorators::backtrace_decorator::backtrace_decorator(std::unique_ptr<ilogger> inner, std::size_t capacity,
+                                                          std::size_t record_size, loggers::level trigger) :
+    decorator{std::move(inner)},
+    m_capacity{std::max<std::size_t>(capacity, 1)},
+    m_record_size{std::max<std::size_t>(record_size, 1)},
+    m_trigger{trigger},
+    m_id{next_id.fetch_add(1, std::memory_order_relaxed)}
+{}
+
+void lib::decorators::backtrace_decorator::log(loggers::level lvl, std::string_view msg) const {
+    if (lvl <= loggers::level::debug) {
+        local_ring().push(lvl, msg);
+        return;
+    }
+
+    if (lvl >= m_trigger) {
+        local_ring().replay(*this);
+    }
+    decorator::log(lvl, msg);
+}
+
+void lib::decorators::backtrace_decorator::log(loggers::level lvl, loggers::message_builder build) const {
+    if (lvl <= loggers::level::debug) {
+        // the ring keeps bytes, not callables, whatever the message refers to may be gone by the replay
+        if (decorator::will_log(lvl)) {
+            thread_local std::string cache;
+            auto message = std::move(cache);
+            message.clear();
+            build(message);
+            local_ring().push(lvl, message);
+            cache = std::move(message);
+        }
+        return;
+    }
+
+    if (lvl >= m_trigger) {
+        local_ring().replay(*this);
+    }
+    decorator::log(lvl, build);
+}
+
+lib::decorators::backtrace_decorator::~backtrace_decorator() {
+    std::lock_guard lock{m_mutex};
+    for (auto& weak : m_rings) {
+        if (auto r = weak.lock()) {
+            r->detached.store(true, std::memory_order_release);
+        }
+    }
+}
+
+lib::decorators::backtrace_decorator::ring& lib::decorators::backtrace_decorator::local_ring() const {
+    thread_local std::uint64_t cached_id = 0;
+    thread_local ring* cached = nullptr;
+
+    if (cached_id != m_id) {
+        auto found = std::find_if(local.rings.begin(), local.rings.end(), [&](const auto& e) { return e.id == m_id; });
+        if (found == local.rings.end()) {
+            // the rings of destroyed decorators go first
+            std::erase_if(local.rings, [](const auto& e) { return e.ring->detached.load(std::memory_order_acquire); });
+
+            auto fresh = std::make_shared<ring>(m_capacity, m_record_size);
+            {
+                std::lock_guard lock{m_mutex};
+                std::erase_if(m_rings, [](const auto& weak) { return weak.expired(); });
+                m_rings.push_back(fresh);
+            }
+            local.rings.push_back({m_id, std::move(fresh)});
+            found = std::prev(local.rings.end());
+        }
+        cached = found->ring.get();
+        cached_id = m_id;
+    }
+    return *cached;
+}
+
+lib::decorators::backtrace_decorator::ring::ring(std::size_t capacity, std::size_t record_size) :
+    m_record_size{record_size},
+    m_storage(capacity * record_size),
+    m_entries(capacity)
+{}
+
+void lib::decorators::backtrace_decorator::ring::push(loggers::level lvl, std::string_view msg) noexcept {
+    auto length = std::min(msg.size(), m_record_size);
+    std::memcpy(&m_storage[m_next * m_record_size], msg.data(), length);
+    m_entries[m_next] = {lvl, static_cast<std::uint32_t>(length)};
+
+    m_next = (m_next + 1) % m_entries.size();
+    m_count = std::min(m_count + 1, m_entries.size());
+}
+
+void lib::decorators::backtrace_decorator::ring::replay(const decorator& logger) {
+    auto first = (m_next + m_entries.size() - m_count) % m_entries.size();
+    for (std::size_t i = 0; i < m_count; ++i) {
+        auto index = (first + i) % m_entries.size();
+        const auto& e = m_entries[index];
+        logger.decorator::log(e.lvl, {&m_storage[index * m_record_size], e.length});
+    }
+    m_count = 0;
+}
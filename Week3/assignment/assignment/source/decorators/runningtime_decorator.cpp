@@ -2,26 +2,59 @@
 // Created by dza02 on 9/9/2021.
 //
 
-#include <sstream>
-#include <iomanip>
+#include <charconv>
+#include <string>
 
 #include "decorators/runningtime_decorator.h"
 #include "global/runningtime_provider.h"
 
-
-void lib::decorators::runningtime_decorator::log(std::string_view msg) const {
-    std::ostringstream oss;
-
-    auto running_time = global::runningtime_provider::get_instance().running_time();
-
-    // full seconds of the runing time
-    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(running_time);
-    running_time -= seconds;
-
-    // remaining nanoseconds of the running time
-    auto nano = std::chrono::duration_cast<std::chrono::nanoseconds>(running_time);
-
-    oss << '[' << seconds.count() << '.' << std::setfill('0') << std::setw(9) << nano.count() << "] " << msg;
-    auto str = oss.str();
-    decorator::log(str);
-}
\ No newline at end of file
+lib::decorators::runningtime_decorator::runningtime_decorator(std::unique_ptr<ilogger> inner,
+                                                              std::shared_ptr<const global::clock_source> clock) :
+    decorator{std::move(inner)}, m_clock{std::move(clock)}
+{}
+
+namespace {
+    // "[seconds.nanoseconds] " into buffer, returns the end of the prefix
+    char* format_prefix(const global::clock_source& clock, char (&buffer)[48]) {
+        auto running_time = global::runningtime_provider::get_instance().running_time(clock);
+
+        // full seconds of the runing time
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(running_time);
+        running_time -= seconds;
+
+        // remaining nanoseconds of the running time, zero padded to 9 digits
+        auto nano = std::chrono::duration_cast<std::chrono::nanoseconds>(running_time).count();
+
+        buffer[0] = '[';
+        auto end = std::to_chars(buffer + 1, buffer + sizeof(buffer), seconds.count()).ptr;
+        *end++ = '.';
+        for (int digit = 8; digit >= 0; --digit) {
+            end[digit] = static_cast<char>('0' + nano % 10);
+            nano /= 10;
+        }
+        end += 9;
+        *end++ = ']';
+        *end++ = ' ';
+        return end;
+    }
+}
+
+void lib::decorators::runningtime_decorator::log(loggers::level lvl, std::string_view msg) const {
+    thread_local std::string line;
+
+    char buffer[48];
+    auto end = format_prefix(*m_clock, buffer);
+
+    line.assign(buffer, end);
+    line.append(msg);
+    decorator::log(lvl, line);
+}
+
+void lib::decorators::runningtime_decorator::log(loggers::level lvl, loggers::message_builder build) const {
+    auto stamped = [&](std::string& out) {
+        char buffer[48];
+        out.append(buffer, format_prefix(*m_clock, buffer));
+        build(out);
+    };
+    decorator::log(lvl, loggers::message_builder{stamped});
+}
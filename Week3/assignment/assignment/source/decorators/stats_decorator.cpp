@@ -0,0 +1,99 @@
+#include "decorators/stats_decorator.h"
+
+#include <optional>
+
+using clock_type = std::chrono::steady_clock;
+
+lib::decorators::stats_decorator::stats_decorator(std::unique_ptr<ilogger> inner, std::string name,
+                                                  const writers::multi_writer* sinks,
+                                                  std::chrono::seconds report_interval) :
+    decorator{std::move(inner)},
+    m_name{std::move(name)},
+    m_sinks{sinks},
+    m_report_interval{report_interval},
+    m_next_report{(clock_type::now() + report_interval).time_since_epoch().count()},
+    m_registry_id{metrics::registry::get_instance().add([this] { return stats(); })}
+{}
+
+lib::decorators::stats_decorator::~stats_decorator() {
+    metrics::registry::get_instance().remove(m_registry_id);
+}
+
+void lib::decorators::stats_decorator::log(loggers::level lvl, std::string_view msg) const {
+    auto t0 = clock_type::now();
+    try {
+        decorator::log(lvl, msg);
+    } catch (...) {
+        m_errors.add();
+        throw;
+    }
+    auto t1 = clock_type::now();
+
+    m_records.add();
+    m_bytes.add(msg.size() + 1);
+    m_latency.record(t1 - t0);
+
+    if (m_report_interval.count() > 0) {
+        report_if_due(t1);
+    }
+}
+
+void lib::decorators::stats_decorator::log(loggers::level lvl, loggers::message_builder build) const {
+    // the builder only runs when a record is made, a call filtered further in is no record
+    std::optional<std::size_t> bytes;
+    auto measured = [&](std::string& out) {
+        auto before = out.size();
+        build(out);
+        bytes = out.size() - before + 1;
+    };
+
+    auto t0 = clock_type::now();
+    try {
+        decorator::log(lvl, loggers::message_builder{measured});
+    } catch (...) {
+        m_errors.add();
+        throw;
+    }
+    auto t1 = clock_type::now();
+
+    if (bytes) {
+        m_records.add();
+        m_bytes.add(*bytes);
+        m_latency.record(t1 - t0);
+    }
+
+    if (m_report_interval.count() > 0) {
+        report_if_due(t1);
+    }
+}
+
+metrics::logger_stats lib::decorators::stats_decorator::stats() const {
+    metrics::logger_stats result{};
+    result.name = m_name;
+    result.records = m_records.value();
+    result.bytes = m_bytes.value();
+    result.errors = m_errors.value();
+    result.log_latency = m_latency.snapshot();
+
+    if (m_sinks) {
+        result.sinks = m_sinks->stats();
+        for (const auto& sink : result.sinks) {
+            result.drops += sink.drops;
+            result.errors += sink.errors;
+        }
+    }
+    return result;
+}
+
+void lib::decorators::stats_decorator::report_if_due(clock_type::time_point now) const {
+    auto due = m_next_report.load(std::memory_order_relaxed);
+    if (now.time_since_epoch().count() < due) {
+        return;
+    }
+
+    // only the thread that moves the deadline writes the report
+    auto next = (now + m_report_interval).time_since_epoch().count();
+    if (m_next_report.compare_exchange_strong(due, next, std::memory_order_relaxed)) {
+        decorator::log(loggers::level::info, metrics::format(stats()));
+    }
+}
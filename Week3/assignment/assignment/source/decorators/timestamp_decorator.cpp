@@ -4,20 +4,45 @@
 
 #include "decorators/timestamp_decorator.h"
 #include <ctime>
-#include <sstream>
-#include <iomanip>
+#include <string>
 
-static const char* TIME_FMT = "%H:%M:%S";
+static const char* TIME_FMT = "[%H:%M:%S] ";
 
-void lib::decorators::timestamp_decorator::log(std::string_view msg) const {
+namespace {
+    std::string_view current_prefix(const global::clock_source& clock) {
+        // the prefix only changes once a second, so it is formatted once per second and thread
+        thread_local std::time_t formatted_second = -1;
+        thread_local char prefix[16];
+        thread_local std::size_t prefix_length = 0;
 
-    std::ostringstream oss;
+        auto now = clock.now();
+        auto time_point = std::chrono::system_clock::to_time_t(now);
+        if (time_point != formatted_second) {
+            prefix_length = global::clock_source::format(now, prefix, TIME_FMT).size();
+            formatted_second = time_point;
+        }
+        return {prefix, prefix_length};
+    }
+}
+
+lib::decorators::timestamp_decorator::timestamp_decorator(std::unique_ptr<ilogger> inner,
+                                                          std::shared_ptr<const global::clock_source> clock) :
+    decorator{std::move(inner)}, m_clock{std::move(clock)}
+{}
 
-    auto time_point = std::time(nullptr);
-    auto local_time = std::localtime(&time_point);
+void lib::decorators::timestamp_decorator::log(loggers::level lvl, std::string_view msg) const {
+    thread_local std::string line;
 
-    oss << '[' << std::put_time(local_time, TIME_FMT) << "] " << msg;
-    auto str = oss.str();
+    line.assign(current_prefix(*m_clock));
+    line.append(msg);
+
+    decorator::log(lvl, line);
+}
 
-    decorator::log(str);
+void lib::decorators::timestamp_decorator::log(loggers::level lvl, loggers::message_builder build) const {
+    auto stamped = [&](std::string& out) {
+        out.append(current_prefix(*m_clock));
+        build(out);
+    };
+    decorator::log(lvl, loggers::message_builder{stamped});
 }
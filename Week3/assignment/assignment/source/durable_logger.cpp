@@ -0,0 +1,16 @@
+#include "durable_logger.h"
+
+namespace lib {
+
+    durable_logger::durable_logger(const char* fname, writers::group_commit_writer::options opts) :
+        m_out{fname, opts}
+    {}
+
+    void durable_logger::log(loggers::level, std::string_view msg) const {
+        m_out.write_durable(msg);
+    }
+
+    writers::group_commit_writer::commit_ack durable_logger::log_durable(std::string_view msg) const {
+        return m_out.write_durable(msg);
+    }
+}
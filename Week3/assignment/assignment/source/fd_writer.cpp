@@ -0,0 +1,169 @@
+#include "fd_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+    constexpr std::size_t PAGE_SIZE = 4096;
+    // the cache is dropped in steps, not after every write
+    constexpr std::size_t ADVISE_STEP = 4 * 1024 * 1024;
+
+    std::size_t round_to_pages(std::size_t size) {
+        return std::max<std::size_t>((size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE, PAGE_SIZE);
+    }
+}
+
+namespace writers {
+
+    fd_writer::fd_writer(const char* fname) : fd_writer(fname, options{}) {}
+
+    fd_writer::fd_writer(const char* fname, options opts) :
+        m_opts{opts}
+    {
+        m_opts.buffer_size = round_to_pages(m_opts.buffer_size);
+
+        auto flags = O_WRONLY | O_CREAT | O_CLOEXEC | (m_opts.append ? O_APPEND : O_TRUNC) | (m_opts.dsync ? O_DSYNC : 0);
+        m_fd = ::open(fname, flags, 0644);
+        if (m_fd < 0) {
+            throw std::runtime_error(std::string{"fd_writer: cannot open "} + fname + ": " + std::strerror(errno));
+        }
+
+        m_buffer.reset(static_cast<char*>(std::aligned_alloc(PAGE_SIZE, m_opts.buffer_size)));
+        if (!m_buffer) {
+            ::close(m_fd);
+            throw std::bad_alloc();
+        }
+    }
+
+    fd_writer::~fd_writer() {
+        try {
+            write_out({});
+        } catch (const std::runtime_error&) {
+            // nothing left to report the error to
+        }
+        if (m_opts.drop_written_pages) {
+            ::fdatasync(m_fd);
+            advise_written();
+        }
+        ::close(m_fd);
+    }
+
+    io::itext_writer& fd_writer::operator<<(std::string_view view) {
+        if (view.size() <= m_opts.buffer_size - m_used) {
+            std::memcpy(m_buffer.get() + m_used, view.data(), view.size());
+            m_used += view.size();
+        } else {
+            write_out(view);
+        }
+        return *this;
+    }
+
+    io::itext_writer& fd_writer::operator<<(const char* string) {
+        return *this << std::string_view{string};
+    }
+
+    io::itext_writer& fd_writer::operator<<(char c) {
+        if (m_used == m_opts.buffer_size) {
+            write_out({});
+        }
+        m_buffer.get()[m_used++] = c;
+        return *this;
+    }
+
+    template <typename T>
+    io::itext_writer& fd_writer::format(T n) {
+        // formatted straight into the buffer
+        if (m_opts.buffer_size - m_used < max_number_length) {
+            write_out({});
+        }
+        auto begin = m_buffer.get() + m_used;
+        auto [end, ec] = std::to_chars(begin, begin + max_number_length, n);
+        m_used += static_cast<std::size_t>(end - begin);
+        return *this;
+    }
+
+    io::itext_writer& fd_writer::operator<<(int n) {
+        return format(n);
+    }
+
+    io::itext_writer& fd_writer::operator<<(long n) {
+        return format(n);
+    }
+
+    io::itext_writer& fd_writer::operator<<(unsigned long n) {
+        return format(n);
+    }
+
+    io::itext_writer& fd_writer::operator<<(long long n) {
+        return format(n);
+    }
+
+    io::itext_writer& fd_writer::operator<<(unsigned long long n) {
+        return format(n);
+    }
+
+    io::itext_writer& fd_writer::operator<<(double n) {
+        return format(n);
+    }
+
+    io::itext_writer& fd_writer::operator<<(io::flush_t) {
+        write_out({});
+        return *this;
+    }
+
+    void fd_writer::write_out(std::string_view tail) {
+        iovec parts[2] = {
+            {m_buffer.get(), m_used},
+            {const_cast<char*>(tail.data()), tail.size()}
+        };
+        auto total = m_used + tail.size();
+        m_used = 0;
+
+        iovec* part = parts;
+        int count = 2;
+        while (count > 0) {
+            if (part->iov_len == 0) {
+                ++part;
+                --count;
+                continue;
+            }
+            auto written = ::writev(m_fd, part, count);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(std::string{"fd_writer: write failed: "} + std::strerror(errno));
+            }
+
+            // a short write leaves the rest of the parts for the next call
+            auto left = static_cast<std::size_t>(written);
+            while (count > 0 && left >= part->iov_len) {
+                left -= part->iov_len;
+                ++part;
+                --count;
+            }
+            if (count > 0) {
+                part->iov_base = static_cast<char*>(part->iov_base) + left;
+                part->iov_len -= left;
+            }
+        }
+
+        m_unadvised += total;
+        if (m_opts.drop_written_pages && m_unadvised >= ADVISE_STEP) {
+            advise_written();
+        }
+    }
+
+    void fd_writer::advise_written() {
+        // only pages that have been written back can be dropped, with O_DSYNC that is all of them
+        ::posix_fadvise(m_fd, 0, 0, POSIX_FADV_DONTNEED);
+        m_unadvised = 0;
+    }
+}
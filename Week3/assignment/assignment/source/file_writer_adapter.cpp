@@ -3,18 +3,11 @@
 //
 
 #include "file_writer_adapter.h"
+#include <charconv>
 
 io::itext_writer& writers::file_writer_adapter::operator<<(std::string_view view) {
-    // if the view contains a null terminator at the right position then:
-    if (*view.cend() == '\0'){
-        m_wrt.write(view.data());
-    } else{
-        // otherwise, iterate over the range
-        auto iter{view.cbegin()};
-        while(iter != view.cend()){
-            m_wrt.write(*iter++);
-        }
-    }
+    // views need not be NUL-terminated, the whole range is written at once
+    m_wrt.write(view.data(), view.size());
     return *this;
 }
 
@@ -28,13 +21,14 @@ io::itext_writer& writers::file_writer_adapter::operator<<(char c) {
     return *this;}
 
 io::itext_writer& writers::file_writer_adapter::operator<<(int n) {
-    char buffer[16];
-    sprintf(&buffer[0], "%d", n);
-    m_wrt.write(&buffer[0]);
+    char temp[12];
+    auto [end, ec] = std::to_chars(temp, temp + sizeof(temp), n);
+    m_wrt.write(temp, static_cast<std::size_t>(end - temp));
     return *this;
 }
 
 io::itext_writer& writers::file_writer_adapter::operator<<(io::flush_t) {
+    m_wrt.flush();
     return *this;
 }
 
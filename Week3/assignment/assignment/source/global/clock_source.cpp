@@ -0,0 +1,138 @@
+#include "global/clock_source.h"
+#include "global/runningtime_provider.h"
+#include <ctime>
+#include <mutex>
+#include <time.h>
+
+namespace {
+    std::chrono::nanoseconds since_epoch(clockid_t id) noexcept {
+        timespec ts{};
+        ::clock_gettime(id, &ts);
+        return std::chrono::seconds{ts.tv_sec} + std::chrono::nanoseconds{ts.tv_nsec};
+    }
+}
+
+global::clock_source::steady_time global::clock_source::start() const noexcept {
+    return runningtime_provider::get_instance().steady_start_time();
+}
+
+std::string_view global::clock_source::format(std::span<char> buffer, const char* format) const noexcept {
+    return clock_source::format(now(), buffer, format);
+}
+
+std::string_view global::clock_source::format(wall_time time, std::span<char> buffer, const char* format) noexcept {
+    auto time_point = std::chrono::system_clock::to_time_t(time);
+    std::tm local_time{};
+    localtime_r(&time_point, &local_time);
+    auto length = std::strftime(buffer.data(), buffer.size(), format, &local_time);
+    return {buffer.data(), length};
+}
+
+global::clock_source::wall_time global::precise_clock::now() const noexcept {
+    return std::chrono::system_clock::now();
+}
+
+global::clock_source::steady_time global::precise_clock::steady_now() const noexcept {
+    return std::chrono::steady_clock::now();
+}
+
+#if defined(CLOCK_REALTIME_COARSE) && defined(CLOCK_MONOTONIC_COARSE)
+
+// steady_clock is CLOCK_MONOTONIC, so the coarse readings share its epoch
+global::clock_source::wall_time global::coarse_clock::now() const noexcept {
+    return wall_time{std::chrono::duration_cast<wall_time::duration>(since_epoch(CLOCK_REALTIME_COARSE))};
+}
+
+global::clock_source::steady_time global::coarse_clock::steady_now() const noexcept {
+    return steady_time{std::chrono::duration_cast<steady_time::duration>(since_epoch(CLOCK_MONOTONIC_COARSE))};
+}
+
+#else
+
+global::clock_source::wall_time global::coarse_clock::now() const noexcept {
+    return std::chrono::system_clock::now();
+}
+
+global::clock_source::steady_time global::coarse_clock::steady_now() const noexcept {
+    return std::chrono::steady_clock::now();
+}
+
+#endif
+
+global::ticker_clock::ticker_clock(std::chrono::microseconds period) {
+    // readers never see a time that was not published yet
+    tick();
+    m_thread = std::jthread{[this, period](std::stop_token stop) {
+        while (!stop.stop_requested()) {
+            std::this_thread::sleep_for(period);
+            tick();
+        }
+    }};
+}
+
+void global::ticker_clock::tick() noexcept {
+    m_wall.store(std::chrono::system_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    m_steady.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+global::clock_source::wall_time global::ticker_clock::now() const noexcept {
+    return wall_time{wall_time::duration{m_wall.load(std::memory_order_relaxed)}};
+}
+
+global::clock_source::steady_time global::ticker_clock::steady_now() const noexcept {
+    return steady_time{steady_time::duration{m_steady.load(std::memory_order_relaxed)}};
+}
+
+global::virtual_clock::virtual_clock(wall_time start, std::chrono::nanoseconds step) :
+    m_start{start}, m_step{step.count()}
+{}
+
+std::chrono::nanoseconds global::virtual_clock::read() const noexcept {
+    return std::chrono::nanoseconds{m_elapsed.fetch_add(m_step, std::memory_order_relaxed)};
+}
+
+global::clock_source::wall_time global::virtual_clock::now() const noexcept {
+    return m_start + std::chrono::duration_cast<wall_time::duration>(read());
+}
+
+global::clock_source::steady_time global::virtual_clock::steady_now() const noexcept {
+    return start() + std::chrono::duration_cast<steady_time::duration>(read());
+}
+
+global::clock_source::steady_time global::virtual_clock::start() const noexcept {
+    return steady_time{std::chrono::duration_cast<steady_time::duration>(m_start.time_since_epoch())};
+}
+
+void global::virtual_clock::advance(std::chrono::nanoseconds by) noexcept {
+    m_elapsed.fetch_add(by.count(), std::memory_order_relaxed);
+}
+
+void global::virtual_clock::set(wall_time time) noexcept {
+    m_elapsed.store(std::chrono::duration_cast<std::chrono::nanoseconds>(time - m_start).count(), std::memory_order_relaxed);
+}
+
+std::shared_ptr<const global::clock_source> global::make_clock(clock_type type) {
+    switch (type) {
+        case clock_type::coarse:
+            return std::make_shared<coarse_clock>();
+        case clock_type::ticker: {
+            static std::mutex mutex;
+            static std::weak_ptr<const clock_source> shared;
+            std::lock_guard lock{mutex};
+            auto ticker = shared.lock();
+            if (!ticker) {
+                ticker = std::make_shared<ticker_clock>();
+                shared = ticker;
+            }
+            return ticker;
+        }
+        case clock_type::precise:
+        default:
+            return default_clock();
+    }
+}
+
+std::shared_ptr<const global::clock_source> global::default_clock() {
+    static const auto clock = std::make_shared<precise_clock>();
+    return clock;
+}
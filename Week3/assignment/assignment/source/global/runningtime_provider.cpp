@@ -3,6 +3,7 @@
 //
 
 #include "global/runningtime_provider.h"
+#include <algorithm>
 
 /* a dummy object to trigger the singleton creation */
 [[maybe_unused]] static auto nothing = global::runningtime_provider::get_instance().start_time();
@@ -11,12 +12,22 @@ global::runningtime_provider::time_point global::runningtime_provider::start_tim
     return m_t0;
 }
 
+global::clock_source::steady_time global::runningtime_provider::steady_start_time() const noexcept {
+    return m_steady_t0;
+}
+
 global::runningtime_provider::duration global::runningtime_provider::running_time() const noexcept {
     return std::chrono::high_resolution_clock::now() - m_t0;
 }
 
+global::runningtime_provider::duration global::runningtime_provider::running_time(const clock_source& clock) const noexcept {
+    // coarse clocks may lag behind the precise start time by a tick
+    return std::max(duration::zero(), std::chrono::duration_cast<duration>(clock.steady_now() - clock.start()));
+}
+
 global::runningtime_provider::runningtime_provider():
-    m_t0{std::chrono::high_resolution_clock::now()}
+    m_t0{std::chrono::high_resolution_clock::now()},
+    m_steady_t0{std::chrono::steady_clock::now()}
 {}
 
 const global::runningtime_provider& global::runningtime_provider::get_instance() {
@@ -0,0 +1,215 @@
+#include "group_commit_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace writers {
+
+    bool group_commit_writer::commit_ack::ready() const noexcept {
+        return m_writer->m_synced.load(std::memory_order_acquire) >= m_batch;
+    }
+
+    void group_commit_writer::commit_ack::wait() const {
+        auto synced = m_writer->m_synced.load(std::memory_order_acquire);
+        while (synced < m_batch) {
+            m_writer->m_synced.wait(synced, std::memory_order_acquire);
+            synced = m_writer->m_synced.load(std::memory_order_acquire);
+        }
+        if (m_writer->failed(m_batch)) {
+            throw std::runtime_error("group_commit_writer: the record could not be synced");
+        }
+    }
+
+    bool group_commit_writer::commit_ack::await_suspend(std::coroutine_handle<> handle) const {
+        std::lock_guard lock{m_writer->m_mutex};
+        if (ready()) {
+            return false;
+        }
+        m_writer->m_waiters.emplace_back(m_batch, handle);
+        return true;
+    }
+
+    group_commit_writer::group_commit_writer(const char* fname) : group_commit_writer(fname, options{}) {}
+
+    group_commit_writer::group_commit_writer(const char* fname, options opts) :
+        m_opts{opts}
+    {
+        m_fd = ::open(fname, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (m_fd < 0) {
+            throw std::runtime_error(std::string{"group_commit_writer: cannot open "} + fname + ": " + std::strerror(errno));
+        }
+        m_open.reserve(m_opts.max_batch_bytes);
+        m_committer = std::thread{[this] { commit_batches(); }};
+    }
+
+    group_commit_writer::~group_commit_writer() {
+        {
+            std::lock_guard lock{m_mutex};
+            if (!m_partial.empty()) {
+                m_partial += '\n';
+                append_records(m_partial, 1);
+                m_partial.clear();
+            }
+            m_stop = true;
+        }
+        m_wakeup.notify_one();
+        m_committer.join();
+        ::close(m_fd);
+    }
+
+    group_commit_writer::commit_ack group_commit_writer::write_durable(std::string_view record) {
+        std::lock_guard lock{m_mutex};
+        auto was_empty = m_open.empty();
+        auto batch = append_records(record, 1);
+        m_open += '\n';
+        if (was_empty || m_open.size() >= m_opts.max_batch_bytes) {
+            m_wakeup.notify_one();
+        }
+        return {this, batch};
+    }
+
+    io::itext_writer& group_commit_writer::operator<<(std::string_view view) {
+        append_tokens(view);
+        return *this;
+    }
+
+    io::itext_writer& group_commit_writer::operator<<(const char* string) {
+        append_tokens(string);
+        return *this;
+    }
+
+    io::itext_writer& group_commit_writer::operator<<(char c) {
+        append_tokens({&c, 1});
+        return *this;
+    }
+
+    io::itext_writer& group_commit_writer::operator<<(int n) {
+        char temp[12];
+        auto [end, ec] = std::to_chars(temp, temp + sizeof(temp), n);
+        append_tokens({temp, static_cast<std::size_t>(end - temp)});
+        return *this;
+    }
+
+    io::itext_writer& group_commit_writer::operator<<(io::flush_t) {
+        std::uint64_t last;
+        {
+            std::lock_guard lock{m_mutex};
+            last = m_open.empty() ? m_open_batch - 1 : m_open_batch;
+        }
+        if (last > 0) {
+            commit_ack{this, last}.wait();
+        }
+        return *this;
+    }
+
+    std::uint64_t group_commit_writer::batches() const noexcept {
+        return m_synced.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t group_commit_writer::records() const noexcept {
+        return m_records.load(std::memory_order_relaxed);
+    }
+
+    void group_commit_writer::append_tokens(std::string_view tokens) {
+        std::lock_guard lock{m_mutex};
+        auto last_newline = tokens.rfind('\n');
+        if (last_newline == std::string_view::npos) {
+            m_partial.append(tokens);
+            return;
+        }
+
+        auto complete = tokens.substr(0, last_newline + 1);
+        auto count = static_cast<std::size_t>(std::count(complete.cbegin(), complete.cend(), '\n'));
+        auto was_empty = m_open.empty();
+        if (!m_partial.empty()) {
+            m_open.append(m_partial);
+            m_partial.clear();
+        }
+        append_records(complete, count);
+        m_partial.assign(tokens.substr(last_newline + 1));
+
+        if (was_empty || m_open.size() >= m_opts.max_batch_bytes) {
+            m_wakeup.notify_one();
+        }
+    }
+
+    std::uint64_t group_commit_writer::append_records(std::string_view records, std::size_t count) {
+        if (m_open_records == 0) {
+            m_open_since = clock_type::now();
+        }
+        m_open.append(records);
+        m_open_records += count;
+        return m_open_batch;
+    }
+
+    bool group_commit_writer::failed(std::uint64_t batch) const noexcept {
+        return batch >= m_first_failed.load(std::memory_order_acquire);
+    }
+
+    void group_commit_writer::commit_batches() {
+        std::string batch;
+        batch.reserve(m_opts.max_batch_bytes);
+        std::vector<std::coroutine_handle<>> resuming;
+
+        std::unique_lock lock{m_mutex};
+        while (true) {
+            m_wakeup.wait(lock, [this] { return m_stop || !m_open.empty(); });
+            if (m_open.empty()) {
+                break;
+            }
+            m_wakeup.wait_until(lock, m_open_since + m_opts.window, [this] {
+                return m_stop || m_open.size() >= m_opts.max_batch_bytes;
+            });
+
+            batch.swap(m_open);
+            auto id = m_open_batch++;
+            auto count = std::exchange(m_open_records, 0);
+            lock.unlock();
+
+            if (!write_batch(batch)) {
+                auto none = UINT64_MAX;
+                m_first_failed.compare_exchange_strong(none, id, std::memory_order_release);
+            }
+            batch.clear();
+            m_records.fetch_add(count, std::memory_order_relaxed);
+
+            lock.lock();
+            m_synced.store(id, std::memory_order_release);
+            auto first_waiting = std::partition(m_waiters.begin(), m_waiters.end(),
+                                                [id](const auto& w) { return w.first > id; });
+            for (auto it = first_waiting; it != m_waiters.end(); ++it) {
+                resuming.push_back(it->second);
+            }
+            m_waiters.erase(first_waiting, m_waiters.end());
+            lock.unlock();
+
+            m_synced.notify_all();
+            for (auto handle : resuming) {
+                handle.resume();
+            }
+            resuming.clear();
+            lock.lock();
+        }
+    }
+
+    bool group_commit_writer::write_batch(const std::string& batch) {
+        std::size_t done = 0;
+        while (done < batch.size()) {
+            auto written = ::write(m_fd, batch.data() + done, batch.size() - done);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            done += static_cast<std::size_t>(written);
+        }
+        return ::fdatasync(m_fd) == 0;
+    }
+}
@@ -0,0 +1,59 @@
+#include "itext_writer.h"
+
+#include <charconv>
+#include <cstddef>
+
+namespace {
+    template<typename T, typename... Format>
+    io::itext_writer& write_number(io::itext_writer& out, T n, Format... format) {
+        // enough for any 64-bit integer and the shortest form of any double
+        char temp[32];
+        auto [end, ec] = std::to_chars(temp, temp + sizeof(temp), n, format...);
+        return out << std::string_view{temp, static_cast<std::size_t>(end - temp)};
+    }
+}
+
+namespace io {
+
+    itext_writer& itext_writer::operator<<(unsigned int n) {
+        return write_number(*this, n);
+    }
+
+    itext_writer& itext_writer::operator<<(long n) {
+        return write_number(*this, n);
+    }
+
+    itext_writer& itext_writer::operator<<(unsigned long n) {
+        return write_number(*this, n);
+    }
+
+    itext_writer& itext_writer::operator<<(long long n) {
+        return write_number(*this, n);
+    }
+
+    itext_writer& itext_writer::operator<<(unsigned long long n) {
+        return write_number(*this, n);
+    }
+
+    itext_writer& itext_writer::operator<<(float n) {
+        return write_number(*this, n);
+    }
+
+    itext_writer& itext_writer::operator<<(double n) {
+        return write_number(*this, n);
+    }
+
+    itext_writer& itext_writer::operator<<(bool b) {
+        return *this << (b ? std::string_view{"true"} : std::string_view{"false"});
+    }
+
+    itext_writer& itext_writer::operator<<(hex_t n) {
+        return write_number(*this, n.value, 16);
+    }
+
+    itext_writer& itext_writer::operator<<(const void* p) {
+        char temp[2 + 2 * sizeof(std::uintptr_t)] = {'0', 'x'};
+        auto [end, ec] = std::to_chars(temp + 2, temp + sizeof(temp), reinterpret_cast<std::uintptr_t>(p), 16);
+        return *this << std::string_view{temp, static_cast<std::size_t>(end - temp)};
+    }
+}
@@ -7,8 +7,30 @@
 
 namespace lib{
 
-    void logger::log(std::string_view msg) const{
-        *m_out << msg << '\n';
+    void logger::log(loggers::level, std::string_view msg) const{
+        // one token per record, so the records of concurrent threads never interleave
+        thread_local std::string record;
+        record.assign(msg);
+        record += '\n';
+        *m_out << std::string_view{record};
+    }
+
+    void logger::log(loggers::level lvl, loggers::message_builder build) const {
+        if (!will_log(lvl)) {
+            return;
+        }
+        // taken out of the cache while in use, a message that logs while being built gets a record of its own
+        thread_local std::string cache;
+        auto record = std::move(cache);
+        record.clear();
+        build(record);
+        record += '\n';
+        *m_out << std::string_view{record};
+        cache = std::move(record);
+    }
+
+    bool logger::will_log(loggers::level) const {
+        return m_out->wants_records();
     }
 
     logger::logger(std::unique_ptr<io::itext_writer> out) : m_out{std::move(out)}{}
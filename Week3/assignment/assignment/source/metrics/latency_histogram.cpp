@@ -0,0 +1,102 @@
+#include "metrics/latency_histogram.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+    constexpr std::uint64_t HALF = std::uint64_t{1} << (metrics::latency_histogram::sub_bucket_bits - 1);
+    constexpr std::uint64_t LINEAR_LIMIT = HALF * 2;
+}
+
+namespace metrics {
+
+    std::size_t latency_histogram::bucket_of(std::uint64_t value) noexcept {
+        if (value < LINEAR_LIMIT) {
+            return static_cast<std::size_t>(value);
+        }
+        value = std::min(value, (std::uint64_t{1} << max_value_bits) - 1);
+
+        // value >> exponent falls into [HALF, 2 * HALF)
+        auto exponent = static_cast<unsigned>(std::bit_width(value)) - sub_bucket_bits;
+        return static_cast<std::size_t>(exponent * HALF + (value >> exponent));
+    }
+
+    std::uint64_t latency_histogram::lower_bound_of(std::size_t bucket) noexcept {
+        if (bucket < LINEAR_LIMIT) {
+            return bucket;
+        }
+        auto exponent = bucket / HALF - 1;
+        auto sub = bucket - exponent * HALF;
+        return sub << exponent;
+    }
+
+    std::uint64_t latency_histogram::upper_bound_of(std::size_t bucket) noexcept {
+        if (bucket < LINEAR_LIMIT) {
+            return bucket;
+        }
+        auto exponent = bucket / HALF - 1;
+        return lower_bound_of(bucket) + (std::uint64_t{1} << exponent) - 1;
+    }
+
+    void latency_histogram::record(std::uint64_t nanoseconds) noexcept {
+        auto& shard = m_shards.local();
+        shard.buckets[bucket_of(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    histogram_snapshot latency_histogram::snapshot() const {
+        histogram_snapshot result{};
+        result.buckets.assign(bucket_count, 0);
+        m_shards.for_each([&](const shard& s) {
+            for (std::size_t i = 0; i < bucket_count; ++i) {
+                auto n = s.buckets[i].load(std::memory_order_relaxed);
+                result.buckets[i] += n;
+                result.count += n;
+            }
+            result.sum += s.sum.load(std::memory_order_relaxed);
+        });
+        return result;
+    }
+
+    std::uint64_t histogram_snapshot::percentile(double p) const noexcept {
+        if (count == 0) {
+            return 0;
+        }
+        auto rank = static_cast<std::uint64_t>(p / 100.0 * static_cast<double>(count));
+        rank = std::clamp<std::uint64_t>(rank, 1, count);
+
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < buckets.size(); ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return latency_histogram::upper_bound_of(i);
+            }
+        }
+        return max();
+    }
+
+    std::uint64_t histogram_snapshot::min() const noexcept {
+        auto first = std::find_if(buckets.cbegin(), buckets.cend(), [](auto n) { return n != 0; });
+        return first == buckets.cend() ? 0 : latency_histogram::lower_bound_of(static_cast<std::size_t>(first - buckets.cbegin()));
+    }
+
+    std::uint64_t histogram_snapshot::max() const noexcept {
+        auto last = std::find_if(buckets.crbegin(), buckets.crend(), [](auto n) { return n != 0; });
+        return last == buckets.crend() ? 0 : latency_histogram::upper_bound_of(static_cast<std::size_t>(buckets.crend() - last - 1));
+    }
+
+    std::uint64_t histogram_snapshot::mean() const noexcept {
+        return count ? sum / count : 0;
+    }
+
+    void histogram_snapshot::merge(const histogram_snapshot& other) {
+        if (buckets.size() < other.buckets.size()) {
+            buckets.resize(other.buckets.size(), 0);
+        }
+        for (std::size_t i = 0; i < other.buckets.size(); ++i) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        sum += other.sum;
+    }
+}
@@ -0,0 +1,200 @@
+#include "metrics/metrics_logger.h"
+
+#include <algorithm>
+#include <charconv>
+#include <utility>
+
+namespace {
+    void append_number(std::string& out, std::uint64_t n) {
+        char temp[20];
+        auto [end, ec] = std::to_chars(temp, temp + sizeof(temp), n);
+        out.append(temp, end);
+    }
+
+    void append_number(std::string& out, std::int64_t n) {
+        char temp[20];
+        auto [end, ec] = std::to_chars(temp, temp + sizeof(temp), n);
+        out.append(temp, end);
+    }
+
+    void append_field(std::string& out, const char* name, std::uint64_t n) {
+        out += name;
+        out += '=';
+        append_number(out, n);
+    }
+}
+
+namespace metrics {
+
+    metrics_logger::metrics_logger(const loggers::ilogger& out, std::chrono::milliseconds interval, loggers::level lvl) :
+        m_out{out},
+        m_interval{std::max(interval, std::chrono::milliseconds{1})},
+        m_level{lvl},
+        m_timer{[this] { run(); }}
+    {}
+
+    metrics_logger::~metrics_logger() {
+        {
+            std::lock_guard lock{m_timer_mutex};
+            m_stop = true;
+        }
+        m_wakeup.notify_one();
+        m_timer.join();
+
+        emit();
+    }
+
+    void metrics_logger::count(std::string_view key, std::uint64_t n) {
+        auto& s = m_shards.local();
+        std::lock_guard lock{s.mutex};
+        auto it = s.counters.find(key);
+        if (it == s.counters.end()) {
+            it = s.counters.emplace(key, 0).first;
+        }
+        it->second += n;
+    }
+
+    void metrics_logger::gauge(std::string_view key, std::int64_t value) {
+        auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+        auto& s = m_shards.local();
+        std::lock_guard lock{s.mutex};
+        auto it = s.gauges.find(key);
+        if (it == s.gauges.end()) {
+            it = s.gauges.emplace(key, gauge_value{}).first;
+        }
+        it->second = {value, stamp, true};
+    }
+
+    void metrics_logger::observe(std::string_view key, std::uint64_t value) {
+        auto& s = m_shards.local();
+        std::lock_guard lock{s.mutex};
+        auto it = s.histograms.find(key);
+        if (it == s.histograms.end()) {
+            it = s.histograms.emplace(key, histogram_value{}).first;
+        }
+        it->second.add(value);
+    }
+
+    void metrics_logger::flush() {
+        emit();
+    }
+
+    void metrics_logger::emit() {
+        std::lock_guard emit_lock{m_emit_mutex};
+
+        m_shards.for_each([this](shard& s) {
+            std::lock_guard lock{s.mutex};
+            for (auto& [key, n] : s.counters) {
+                if (n) {
+                    auto it = m_counters.try_emplace(key, 0).first;
+                    it->second += std::exchange(n, 0);
+                }
+            }
+            for (auto& [key, g] : s.gauges) {
+                if (g.set) {
+                    auto& merged = m_gauges[key];
+                    if (!merged.set || g.stamp >= merged.stamp) {
+                        merged = g;
+                    }
+                    g.set = false;
+                }
+            }
+            for (auto& [key, h] : s.histograms) {
+                if (h.count) {
+                    m_histograms[key].take(h);
+                }
+            }
+        });
+
+        m_record.assign("metrics:");
+        auto empty = true;
+
+        for (auto& [key, n] : m_counters) {
+            if (n) {
+                m_record += ' ';
+                m_record += key;
+                m_record += '{';
+                append_field(m_record, "count", std::exchange(n, 0));
+                m_record += '}';
+                empty = false;
+            }
+        }
+        for (const auto& [key, g] : m_gauges) {
+            m_record += ' ';
+            m_record += key;
+            m_record += "{gauge=";
+            append_number(m_record, g.value);
+            m_record += '}';
+            empty = false;
+        }
+        for (auto& [key, h] : m_histograms) {
+            if (!h.count) {
+                continue;
+            }
+            histogram_snapshot snapshot{h.count, h.sum, std::move(h.buckets)};
+            m_record += ' ';
+            m_record += key;
+            m_record += '{';
+            append_field(m_record, "count", h.count);
+            append_field(m_record += ' ', "sum", h.sum);
+            append_field(m_record += ' ', "min", h.min);
+            append_field(m_record += ' ', "max", h.max);
+            // bucket bounds may lie a few percent outside of what was observed
+            append_field(m_record += ' ', "p50", std::clamp(snapshot.percentile(50), h.min, h.max));
+            append_field(m_record += ' ', "p99", std::clamp(snapshot.percentile(99), h.min, h.max));
+            m_record += '}';
+            empty = false;
+
+            h.buckets = std::move(snapshot.buckets);
+            std::fill(h.buckets.begin(), h.buckets.end(), 0);
+            h.count = 0;
+            h.sum = 0;
+        }
+
+        if (!empty) {
+            m_out.log(m_level, m_record);
+        }
+    }
+
+    void metrics_logger::run() {
+        std::unique_lock lock{m_timer_mutex};
+        while (!m_stop) {
+            if (m_wakeup.wait_for(lock, m_interval, [this] { return m_stop; })) {
+                break;
+            }
+            lock.unlock();
+            emit();
+            lock.lock();
+        }
+    }
+
+    void metrics_logger::histogram_value::add(std::uint64_t value) {
+        if (buckets.empty()) {
+            buckets.assign(latency_histogram::bucket_count, 0);
+        }
+        if (count == 0) {
+            min = max = value;
+        } else {
+            min = std::min(min, value);
+            max = std::max(max, value);
+        }
+        ++count;
+        sum += value;
+        ++buckets[latency_histogram::bucket_of(value)];
+    }
+
+    void metrics_logger::histogram_value::take(histogram_value& other) {
+        if (buckets.empty()) {
+            buckets.assign(latency_histogram::bucket_count, 0);
+        }
+        min = count ? std::min(min, other.min) : other.min;
+        max = count ? std::max(max, other.max) : other.max;
+        count += other.count;
+        sum += other.sum;
+        for (std::size_t i = 0; i < buckets.size(); ++i) {
+            buckets[i] += std::exchange(other.buckets[i], 0);
+        }
+        other.count = 0;
+        other.sum = 0;
+    }
+}
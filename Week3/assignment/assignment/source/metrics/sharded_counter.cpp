@@ -0,0 +1,57 @@
+#include "metrics/sharded_counter.h"
+
+#include <mutex>
+#include <vector>
+
+namespace {
+
+    // hands out the lowest free slot, so the shards in use stay packed at the front
+    class slot_allocator {
+    public:
+        std::size_t acquire() {
+            std::lock_guard lock{m_mutex};
+            if (m_free.empty()) {
+                return m_next++;
+            }
+            auto slot = m_free.back();
+            m_free.pop_back();
+            return slot;
+        }
+
+        void release(std::size_t slot) noexcept {
+            std::lock_guard lock{m_mutex};
+            try {
+                m_free.push_back(slot);
+            } catch (...) {
+                // the slot is lost, the thread that would have reused it gets a new one
+            }
+        }
+
+        static slot_allocator& get_instance() {
+            // never destroyed, threads may still exit while static objects are being destroyed
+            static auto obj = new slot_allocator{};
+            return *obj;
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::vector<std::size_t> m_free;
+        std::size_t m_next = 0;
+    };
+
+    // gives the slot of an exiting thread back
+    struct slot_holder {
+        std::size_t slot;
+
+        slot_holder() : slot{slot_allocator::get_instance().acquire()} {}
+
+        ~slot_holder() {
+            slot_allocator::get_instance().release(slot);
+        }
+    };
+}
+
+std::size_t metrics::thread_slot() noexcept {
+    thread_local slot_holder holder;
+    return holder.slot;
+}
@@ -0,0 +1,89 @@
+#include "metrics/stats.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace {
+    void format_latency(std::ostringstream& oss, const char* label, const metrics::histogram_snapshot& h) {
+        oss << ' ' << label << "_ns{p50=" << h.percentile(50) << " p99=" << h.percentile(99)
+            << " max=" << h.max() << " n=" << h.count << '}';
+    }
+}
+
+namespace metrics {
+
+    void sink_metrics::record_write(std::size_t bytes, bool ends_record, std::chrono::nanoseconds latency) noexcept {
+        m_bytes.add(bytes);
+        if (ends_record) {
+            m_records.add();
+        }
+        m_write_latency.record(latency);
+    }
+
+    void sink_metrics::record_flush(std::chrono::nanoseconds latency) noexcept {
+        m_flushes.add();
+        m_write_latency.record(latency);
+    }
+
+    void sink_metrics::record_error() noexcept {
+        m_errors.add();
+    }
+
+    sink_stats sink_metrics::snapshot(std::string name, std::uint64_t drops) const {
+        return {
+            std::move(name),
+            m_records.value(),
+            m_bytes.value(),
+            m_flushes.value(),
+            drops,
+            m_errors.value(),
+            m_write_latency.snapshot(),
+            {}
+        };
+    }
+
+    std::string format(const logger_stats& stats) {
+        std::ostringstream oss;
+        oss << "stats " << stats.name << ": records=" << stats.records << " bytes=" << stats.bytes
+            << " drops=" << stats.drops << " errors=" << stats.errors;
+        format_latency(oss, "log", stats.log_latency);
+
+        for (const auto& sink : stats.sinks) {
+            oss << " | sink " << sink.name << ": records=" << sink.records << " bytes=" << sink.bytes
+                << " flushes=" << sink.flushes << " drops=" << sink.drops << " errors=" << sink.errors;
+            format_latency(oss, "write", sink.write_latency);
+            if (sink.spill.spilled_records) {
+                // the backlog still on disk; the rates follow from two consecutive reports
+                oss << " spilled=" << sink.spill.spilled_records << " replayed=" << sink.spill.replayed_records
+                    << " spill_backlog_bytes=" << (sink.spill.spilled_bytes - sink.spill.replayed_bytes);
+            }
+        }
+        return oss.str();
+    }
+
+    std::size_t registry::add(provider source) {
+        std::lock_guard lock{m_mutex};
+        m_providers.emplace_back(m_next_id, std::move(source));
+        return m_next_id++;
+    }
+
+    void registry::remove(std::size_t id) {
+        std::lock_guard lock{m_mutex};
+        std::erase_if(m_providers, [id](const auto& entry) { return entry.first == id; });
+    }
+
+    std::vector<logger_stats> registry::snapshot() const {
+        std::lock_guard lock{m_mutex};
+        std::vector<logger_stats> result;
+        result.reserve(m_providers.size());
+        for (const auto& [_, source] : m_providers) {
+            result.push_back(source());
+        }
+        return result;
+    }
+
+    registry& registry::get_instance() {
+        static registry obj{};
+        return obj;
+    }
+}
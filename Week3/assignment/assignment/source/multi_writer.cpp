@@ -3,40 +3,207 @@
 //
 
 #include "multi_writer.h"
+#include "rcu/epoch.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    std::size_t decimal_length(int n) {
+        std::size_t length = (n < 0) ? 2 : 1;
+        for (long long rest = n < 0 ? -static_cast<long long>(n) : n; rest >= 10; rest /= 10) {
+            ++length;
+        }
+        return length;
+    }
+}
+
+template <typename Write>
+void writers::multi_writer::for_each_sink(std::size_t bytes, bool ends_record, Write&& write) {
+    rcu::guard guard;
+    for (const auto& s: *m_sinks.load(std::memory_order_acquire)) {
+        std::lock_guard lock{s->mutex};
+        auto sink_metrics = s->metrics.load(std::memory_order_acquire);
+        if (!sink_metrics) {
+            write(*s);
+            continue;
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        try {
+            write(*s);
+        } catch (...) {
+            sink_metrics->record_error();
+            throw;
+        }
+        sink_metrics->record_write(bytes, ends_record, std::chrono::steady_clock::now() - t0);
+    }
+}
+
+template <typename T>
+void writers::multi_writer::write_all(const T& value, std::size_t bytes, bool ends_record) {
+    for_each_sink(bytes, ends_record, [&](sink& s) { *s.writer << value; });
+}
+
+void writers::multi_writer::write_record(std::string_view record) {
+    // made for the first sink that keeps records, released when the last of them is done with it
+    io::shared_record shared;
+    for_each_sink(record.size(), true, [&](sink& s) {
+        if (!s.holder) {
+            *s.writer << record;
+            return;
+        }
+        if (!shared) {
+            shared = io::record_pool::get_instance().make(record);
+        }
+        s.holder->write(shared);
+    });
+}
 
 io::itext_writer& writers::multi_writer::operator<<(std::string_view view) {
-    for (const auto& [_, w]: m_writers)
-        *w << view;
+    if (!view.empty() && view.back() == '\n') {
+        write_record(view);
+    } else {
+        write_all(view, view.size(), false);
+    }
     return *this;
 }
 
 io::itext_writer& writers::multi_writer::operator<<(const char* string) {
-    for (const auto& [_, w]: m_writers)
-        *w << string;
+    auto length = std::strlen(string);
+    write_all(string, length, length && string[length - 1] == '\n');
     return *this;}
 
 io::itext_writer& writers::multi_writer::operator<<(char c) {
-    for (const auto& [_, w]: m_writers)
-        *w << c;
+    write_all(c, 1, c == '\n');
     return *this;}
 
 io::itext_writer& writers::multi_writer::operator<<(int n) {
-    for (const auto& [_, w]: m_writers)
-        *w << n;
+    write_all(n, decimal_length(n), false);
     return *this;}
 
 io::itext_writer& writers::multi_writer::operator<<(io::flush_t flush) {
-    for (const auto& [_, w]: m_writers)
-        *w << flush;
+    rcu::guard guard;
+    for (const auto& s: *m_sinks.load(std::memory_order_acquire)) {
+        std::lock_guard lock{s->mutex};
+        auto t0 = std::chrono::steady_clock::now();
+        *s->writer << flush;
+        if (auto sink_metrics = s->metrics.load(std::memory_order_acquire)) {
+            sink_metrics->record_flush(std::chrono::steady_clock::now() - t0);
+        }
+    }
     return *this;}
 
-writers::multi_writer::multi_writer(): m_writers{} {}
+bool writers::multi_writer::wants_records() const {
+    rcu::guard guard;
+    const auto& sinks = *m_sinks.load(std::memory_order_acquire);
+    return std::any_of(sinks.cbegin(), sinks.cend(), [](const auto& s) { return s->writer->wants_records(); });
+}
+
+writers::multi_writer::multi_writer(): m_sinks{new sink_set{}}, m_metrics{false} {
+    // the domain and the pool have to outlive every multi_writer, including static ones
+    rcu::epoch_domain::get_instance();
+    io::record_pool::get_instance();
+}
+
+writers::multi_writer::~multi_writer() {
+    delete m_sinks.load(std::memory_order_relaxed);
+    // close the sinks of older snapshots too
+    rcu::epoch_domain::get_instance().synchronize();
+}
 
 void writers::multi_writer::add_writer(const std::string& name, std::unique_ptr<io::itext_writer> writer) {
-    m_writers.emplace(name, std::move(writer));
+    auto s = std::make_shared<sink>();
+    s->name = name;
+    s->drops = dynamic_cast<const metrics::idrop_counter*>(writer.get());
+    s->breaker = nullptr;
+    s->spill = dynamic_cast<const metrics::ispill_counter*>(writer.get());
+    s->holder = dynamic_cast<io::irecord_holder*>(writer.get());
+    s->writer = std::move(writer);
+    add_sink(std::move(s));
+}
+
+void writers::multi_writer::add_writer(const std::string& name, std::unique_ptr<io::itext_writer> writer,
+                                       const circuit_breaker_writer::policy& isolation) {
+    auto breaker = std::make_unique<circuit_breaker_writer>(std::move(writer), isolation);
+    auto s = std::make_shared<sink>();
+    s->name = name;
+    s->drops = breaker.get();
+    s->breaker = breaker.get();
+    s->spill = nullptr;
+    s->holder = nullptr;
+    s->writer = std::move(breaker);
+    add_sink(std::move(s));
+}
+
+void writers::multi_writer::add_writer(const std::string& name, std::unique_ptr<io::itext_writer> writer,
+                                       const async_writer::options& queueing) {
+    add_writer(name, std::make_unique<async_writer>(std::move(writer), queueing));
+}
+
+void writers::multi_writer::add_sink(std::shared_ptr<sink> s) {
+    std::lock_guard lock{m_update_mutex};
+    const auto& current = *m_sinks.load(std::memory_order_relaxed);
+    if (std::any_of(current.cbegin(), current.cend(), [&](const auto& other) { return other->name == s->name; })) {
+        return;
+    }
+
+    if (m_metrics) {
+        s->metrics_storage = std::make_unique<metrics::sink_metrics>();
+        s->metrics.store(s->metrics_storage.get(), std::memory_order_relaxed);
+    }
+
+    auto next = new sink_set{current};
+    next->push_back(std::move(s));
+    publish(next);
 }
 
 void writers::multi_writer::remove_writer(const std::string& name) {
-    m_writers.erase(name);
+    std::lock_guard lock{m_update_mutex};
+    const auto& current = *m_sinks.load(std::memory_order_relaxed);
+
+    auto next = new sink_set{};
+    std::copy_if(current.cbegin(), current.cend(), std::back_inserter(*next),
+                 [&](const auto& s) { return s->name != name; });
+    publish(next);
 }
 
+void writers::multi_writer::publish(const sink_set* next) {
+    auto previous = m_sinks.exchange(next, std::memory_order_acq_rel);
+    rcu::epoch_domain::get_instance().retire(previous);
+}
+
+void writers::multi_writer::enable_metrics() {
+    std::lock_guard lock{m_update_mutex};
+    m_metrics = true;
+    for (const auto& s: *m_sinks.load(std::memory_order_relaxed)) {
+        if (!s->metrics_storage) {
+            s->metrics_storage = std::make_unique<metrics::sink_metrics>();
+            s->metrics.store(s->metrics_storage.get(), std::memory_order_release);
+        }
+    }
+}
+
+std::vector<metrics::sink_stats> writers::multi_writer::stats() const {
+    rcu::guard guard;
+    std::vector<metrics::sink_stats> result;
+    for (const auto& s: *m_sinks.load(std::memory_order_acquire)) {
+        if (auto sink_metrics = s->metrics.load(std::memory_order_acquire)) {
+            result.push_back(sink_metrics->snapshot(s->name, s->drops ? s->drops->dropped_records() : 0));
+            if (s->spill) {
+                result.back().spill = s->spill->spilled();
+            }
+        }
+    }
+    return result;
+}
+
+std::optional<writers::circuit_breaker_writer::health> writers::multi_writer::health(const std::string& name) const {
+    rcu::guard guard;
+    for (const auto& s: *m_sinks.load(std::memory_order_acquire)) {
+        if (s->name == name && s->breaker) {
+            return s->breaker->status();
+        }
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,339 @@
+#include "ordered_writer.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <iterator>
+
+namespace writers {
+
+    // the producers of one thread, one per ordered_writer it wrote to; orphaned when the thread exits
+    struct producer_holder {
+        struct entry {
+            std::uint64_t id;
+            std::shared_ptr<ordered_writer::producer> producer;
+        };
+        std::vector<entry> producers;
+
+        ~producer_holder() {
+            for (auto& e : producers) {
+                e.producer->orphaned.store(true, std::memory_order_release);
+            }
+        }
+    };
+}
+
+namespace {
+    std::atomic<std::uint64_t> next_id{1};
+    thread_local writers::producer_holder local;
+
+    // every ring entry starts with a header and is padded to a multiple of its size, so a header always fits
+    // in front of the end of the ring; a header with length wrap tells the reader to continue at the start
+    struct entry_header {
+        std::uint64_t stamp;
+        std::uint32_t length;
+        std::uint32_t reserved;
+    };
+
+    constexpr std::size_t HEADER_SIZE = sizeof(entry_header);
+    constexpr std::uint32_t WRAP = UINT32_MAX;
+
+    std::size_t entry_size(std::size_t length) {
+        return (HEADER_SIZE + length + HEADER_SIZE - 1) / HEADER_SIZE * HEADER_SIZE;
+    }
+
+    std::uint64_t now_ns() {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    struct merge_head {
+        std::uint64_t stamp;
+        std::size_t index;
+
+        // std::push_heap and friends keep the largest element first, the merge needs the oldest record
+        bool operator<(const merge_head& other) const noexcept {
+            return stamp != other.stamp ? stamp > other.stamp : index > other.index;
+        }
+    };
+}
+
+namespace writers {
+
+    ordered_writer::ordered_writer(std::unique_ptr<io::itext_writer> inner) :
+        ordered_writer(std::move(inner), options{})
+    {}
+
+    ordered_writer::ordered_writer(std::unique_ptr<io::itext_writer> inner, options opts) :
+        m_opts{opts},
+        m_mask{std::bit_ceil(std::max<std::size_t>(opts.ring_bytes, 4096)) - 1},
+        m_id{next_id.fetch_add(1, std::memory_order_relaxed)},
+        m_inner{std::move(inner)},
+        m_merger{[this](std::stop_token stop) { merge_loop(stop); }}
+    {}
+
+    ordered_writer::~ordered_writer() {
+        m_merger.request_stop();
+        m_merger.join();
+
+        merge(true);
+        // unfinished records are finished here, their threads are gone
+        for (auto& p : m_producers) {
+            if (!p->partial.empty()) {
+                push(*p, p->partial);
+                p->partial.clear();
+            }
+        }
+        merge(true);
+        *m_inner << io::flush;
+
+        for (auto& p : m_producers) {
+            p->detached.store(true, std::memory_order_release);
+        }
+    }
+
+    io::itext_writer& ordered_writer::operator<<(std::string_view view) {
+        append(view);
+        return *this;
+    }
+
+    io::itext_writer& ordered_writer::operator<<(const char* string) {
+        append(string);
+        return *this;
+    }
+
+    io::itext_writer& ordered_writer::operator<<(char c) {
+        append({&c, 1});
+        return *this;
+    }
+
+    io::itext_writer& ordered_writer::operator<<(int n) {
+        char temp[12];
+        auto [end, ec] = std::to_chars(temp, temp + sizeof(temp), n);
+        append({temp, static_cast<std::size_t>(end - temp)});
+        return *this;
+    }
+
+    io::itext_writer& ordered_writer::operator<<(io::flush_t) {
+        m_flush_requested.store(true, std::memory_order_relaxed);
+        return *this;
+    }
+
+    std::uint64_t ordered_writer::late_records() const noexcept {
+        return m_late.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t ordered_writer::full_waits() const noexcept {
+        return m_full_waits.value();
+    }
+
+    std::uint64_t ordered_writer::truncated_records() const noexcept {
+        return m_truncated.load(std::memory_order_relaxed);
+    }
+
+    ordered_writer::producer& ordered_writer::local_producer() {
+        thread_local std::uint64_t cached_id = 0;
+        thread_local producer* cached = nullptr;
+
+        if (cached_id != m_id) {
+            auto found = std::find_if(local.producers.begin(), local.producers.end(),
+                                      [&](const auto& e) { return e.id == m_id; });
+            if (found == local.producers.end()) {
+                // the producers of destroyed writers go first
+                std::erase_if(local.producers,
+                              [](const auto& e) { return e.producer->detached.load(std::memory_order_acquire); });
+
+                auto fresh = std::make_shared<producer>();
+                fresh->storage = std::make_unique<char[]>(m_mask + 1);
+                {
+                    std::lock_guard lock{m_producers_mutex};
+                    m_producers.push_back(fresh);
+                }
+                local.producers.push_back({m_id, std::move(fresh)});
+                found = std::prev(local.producers.end());
+            }
+            cached = found->producer.get();
+            cached_id = m_id;
+        }
+        return *cached;
+    }
+
+    void ordered_writer::append(std::string_view tokens) {
+        auto& p = local_producer();
+        std::size_t newline;
+        while ((newline = tokens.find('\n')) != std::string_view::npos) {
+            if (p.partial.empty()) {
+                push(p, tokens.substr(0, newline));
+            } else {
+                p.partial.append(tokens.substr(0, newline));
+                push(p, p.partial);
+                p.partial.clear();
+            }
+            tokens.remove_prefix(newline + 1);
+        }
+        p.partial.append(tokens);
+    }
+
+    void ordered_writer::push(producer& p, std::string_view record) {
+        auto capacity = m_mask + 1;
+        if (record.size() > capacity / 2 - HEADER_SIZE) {
+            record = record.substr(0, capacity / 2 - HEADER_SIZE);
+            m_truncated.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // the merge thread must not pass the stamp before it can see the record
+        p.sequence.store(p.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        p.pending.store(busy, std::memory_order_seq_cst);
+        auto stamp = now_ns();
+        p.pending.store(stamp, std::memory_order_seq_cst);
+
+        auto size = entry_size(record.size());
+        auto head = p.head.load(std::memory_order_relaxed);
+        auto to_end = capacity - (head & m_mask);
+        auto needed = size + (to_end < size ? to_end : 0);
+
+        if (capacity - (head - p.cached_tail) < needed) {
+            p.cached_tail = p.tail.load(std::memory_order_acquire);
+            if (capacity - (head - p.cached_tail) < needed) {
+                m_full_waits.add();
+                do {
+                    std::this_thread::yield();
+                    p.cached_tail = p.tail.load(std::memory_order_acquire);
+                } while (capacity - (head - p.cached_tail) < needed);
+            }
+        }
+
+        if (to_end < size) {
+            entry_header wrap{0, WRAP, 0};
+            std::memcpy(&p.storage[head & m_mask], &wrap, HEADER_SIZE);
+            head += to_end;
+        }
+
+        entry_header header{stamp, static_cast<std::uint32_t>(record.size()), 0};
+        auto at = &p.storage[head & m_mask];
+        std::memcpy(at, &header, HEADER_SIZE);
+        std::memcpy(at + HEADER_SIZE, record.data(), record.size());
+
+        p.head.store(head + size, std::memory_order_release);
+        p.pending.store(idle, std::memory_order_release);
+    }
+
+    void ordered_writer::merge_loop(std::stop_token stop) {
+        while (!stop.stop_requested()) {
+            std::this_thread::sleep_for(m_opts.merge_interval);
+            merge(false);
+        }
+    }
+
+    void ordered_writer::merge(bool final) {
+        // true once the thread of p has exited and everything in its ring is written
+        auto drained = [](const producer& p) {
+            return p.orphaned.load(std::memory_order_acquire) &&
+                   p.tail.load(std::memory_order_relaxed) == p.head.load(std::memory_order_acquire);
+        };
+
+        {
+            std::lock_guard lock{m_producers_mutex};
+            // exited threads whose records are all written are released
+            std::erase_if(m_producers, [&](const auto& p) { return drained(*p) && p->partial.empty(); });
+            m_merging.clear();
+            for (const auto& p : m_producers) {
+                m_merging.push_back(p.get());
+            }
+        }
+
+        // the clock is read before the pending stamps: a thread that is idle now stamps its next record later
+        auto now = now_ns();
+        auto watermark = final ? idle : now;
+        auto window = static_cast<std::uint64_t>(std::chrono::nanoseconds{m_opts.reorder_window}.count());
+        for (auto p : m_merging) {
+            if (final) {
+                break;
+            }
+            auto pending = p->pending.load(std::memory_order_seq_cst);
+            auto sequence = p->sequence.load(std::memory_order_relaxed);
+            if (pending == idle) {
+                p->seen_pending = idle;
+                continue;
+            }
+            if (pending != p->seen_pending || sequence != p->seen_sequence) {
+                p->seen_pending = pending;
+                p->seen_sequence = sequence;
+                p->seen_since = now;
+            }
+            // a stalled thread does not hold the others back forever
+            if (now - p->seen_since <= window) {
+                watermark = std::min(watermark, pending);
+            }
+        }
+
+        auto capacity = m_mask + 1;
+        // the oldest record of p, nullptr when its ring is empty
+        auto peek = [&](producer& p) -> const entry_header* {
+            auto tail = p.tail.load(std::memory_order_relaxed);
+            while (tail != p.head.load(std::memory_order_acquire)) {
+                auto header = reinterpret_cast<const entry_header*>(&p.storage[tail & m_mask]);
+                if (header->length != WRAP) {
+                    return header;
+                }
+                tail += capacity - (tail & m_mask);
+                p.tail.store(tail, std::memory_order_release);
+            }
+            return nullptr;
+        };
+
+        std::vector<merge_head> heads;
+        for (std::size_t i = 0; i < m_merging.size(); ++i) {
+            if (auto header = peek(*m_merging[i])) {
+                heads.push_back({header->stamp, i});
+            }
+        }
+        std::make_heap(heads.begin(), heads.end());
+
+        while (!heads.empty() && heads.front().stamp <= watermark) {
+            std::pop_heap(heads.begin(), heads.end());
+            auto index = heads.back().index;
+            heads.pop_back();
+
+            auto& p = *m_merging[index];
+            auto tail = p.tail.load(std::memory_order_relaxed);
+            auto header = reinterpret_cast<const entry_header*>(&p.storage[tail & m_mask]);
+
+            if (header->stamp < m_last_written) {
+                m_late.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                m_last_written = header->stamp;
+            }
+            if (m_opts.stamp_prefix) {
+                char stamp[17];
+                auto [end, ec] = std::to_chars(stamp, stamp + 16, header->stamp, 16);
+                auto digits = static_cast<std::size_t>(end - stamp);
+                m_out.append(16 - digits, '0').append(stamp, digits) += ' ';
+            }
+            m_out.append(reinterpret_cast<const char*>(header) + HEADER_SIZE, header->length) += '\n';
+            p.tail.store(tail + entry_size(header->length), std::memory_order_release);
+
+            if (auto next = peek(p)) {
+                heads.push_back({next->stamp, index});
+                std::push_heap(heads.begin(), heads.end());
+            }
+        }
+
+        if (!m_out.empty()) {
+            *m_inner << std::string_view{m_out};
+            m_out.clear();
+        }
+
+        // an unfinished record of an exited thread goes into its empty ring, the next merge writes it
+        for (auto p : m_merging) {
+            if (drained(*p) && !p->partial.empty()) {
+                push(*p, p->partial);
+                p->partial.clear();
+            }
+        }
+        if (m_flush_requested.exchange(false, std::memory_order_relaxed)) {
+            *m_inner << io::flush;
+        }
+    }
+}
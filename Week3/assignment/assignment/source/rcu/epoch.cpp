@@ -0,0 +1,146 @@
+#include "rcu/epoch.h"
+#include <thread>
+
+namespace rcu {
+
+    // hands the record of a thread back to the domain when the thread exits
+    struct record_holder {
+        epoch_domain::thread_record* record = nullptr;
+
+        ~record_holder() {
+            if (record) {
+                record->epoch.store(0, std::memory_order_release);
+                record->in_use.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    namespace {
+        thread_local record_holder local;
+    }
+
+    epoch_domain::~epoch_domain() {
+        run(m_retired);
+        m_retired.clear();
+
+        auto record = m_records.load(std::memory_order_acquire);
+        while (record) {
+            auto next = record->next;
+            delete record;
+            record = next;
+        }
+    }
+
+    void epoch_domain::enter() noexcept {
+        auto& record = local_record();
+        if (record.nesting++ == 0) {
+            record.epoch.store(m_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            // the announcement has to be visible before the guarded pointer is read
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    void epoch_domain::leave() noexcept {
+        auto& record = *local.record;
+        if (--record.nesting == 0) {
+            record.epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    void epoch_domain::retire(void* object, deleter_t deleter) {
+        std::vector<retired> ready;
+        {
+            std::lock_guard lock{m_mutex};
+            m_retired.push_back({object, deleter, m_epoch.load(std::memory_order_relaxed)});
+            try_advance();
+            ready = collect();
+        }
+        // deleters may retire objects themselves
+        run(ready);
+    }
+
+    void epoch_domain::synchronize() {
+        for (;;) {
+            std::vector<retired> ready;
+            bool done;
+            {
+                std::lock_guard lock{m_mutex};
+                try_advance();
+                ready = collect();
+                done = m_retired.empty();
+            }
+            run(ready);
+            if (done && ready.empty()) {
+                return;
+            }
+            if (ready.empty()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void epoch_domain::run(const std::vector<retired>& ready) {
+        for (const auto& r : ready) {
+            r.deleter(r.object);
+        }
+    }
+
+    epoch_domain& epoch_domain::get_instance() {
+        static epoch_domain obj{};
+        return obj;
+    }
+
+    epoch_domain::thread_record& epoch_domain::local_record() {
+        if (!local.record) {
+            local.record = acquire_record();
+        }
+        return *local.record;
+    }
+
+    epoch_domain::thread_record* epoch_domain::acquire_record() {
+        // records of exited threads are reused, the list only grows with the peak number of threads
+        for (auto record = m_records.load(std::memory_order_acquire); record; record = record->next) {
+            bool expected = false;
+            if (!record->in_use.load(std::memory_order_relaxed)
+                && record->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                return record;
+            }
+        }
+
+        auto record = new thread_record{};
+        record->in_use.store(true, std::memory_order_relaxed);
+        auto head = m_records.load(std::memory_order_relaxed);
+        do {
+            record->next = head;
+        } while (!m_records.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+        return record;
+    }
+
+    bool epoch_domain::try_advance() {
+        auto epoch = m_epoch.load(std::memory_order_relaxed);
+        // pairs with the fence in enter: a reader not seen here reads the pointers published before
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (auto record = m_records.load(std::memory_order_acquire); record; record = record->next) {
+            auto seen = record->epoch.load(std::memory_order_acquire);
+            if (seen != 0 && seen != epoch) {
+                return false;
+            }
+        }
+        m_epoch.store(epoch + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::vector<epoch_domain::retired> epoch_domain::collect() {
+        // readers inside a guard are at most one epoch behind, so two advances free an object
+        auto epoch = m_epoch.load(std::memory_order_relaxed);
+        std::vector<retired> ready;
+        std::erase_if(m_retired, [&](const retired& r) {
+            if (r.epoch + 2 <= epoch) {
+                ready.push_back(r);
+                return true;
+            }
+            return false;
+        });
+        return ready;
+    }
+}
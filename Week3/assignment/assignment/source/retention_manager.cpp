@@ -0,0 +1,294 @@
+#include "retention_manager.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if LOGGING_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+    bool all_digits(std::string_view s) {
+        return !s.empty() && std::all_of(s.begin(), s.end(), [](unsigned char c) { return std::isdigit(c); });
+    }
+
+    struct rolled_name {
+        // the time prefix and shard, the same for all files of one logger
+        std::string logger;
+        std::uint64_t number;
+        bool compressed;
+    };
+
+    // yymmdd_HHMMSS.N, optionally followed by .SHARD and .gz
+    std::optional<rolled_name> parse_rolled_name(std::string_view name) {
+        auto compressed = name.ends_with(".gz");
+        if (compressed) {
+            name.remove_suffix(3);
+        }
+        if (name.size() < 15 || name[6] != '_' || name[13] != '.' ||
+            !all_digits(name.substr(0, 6)) || !all_digits(name.substr(7, 6))) {
+            return std::nullopt;
+        }
+        std::string logger{name.substr(0, 13)};
+        name.remove_prefix(14);
+
+        auto dot = name.find('.');
+        auto digits = name.substr(0, dot);
+        std::uint64_t number = 0;
+        auto [end, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), number);
+        if (!all_digits(digits) || ec != std::errc{}) {
+            return std::nullopt;
+        }
+        if (dot != std::string_view::npos) {
+            auto shard = name.substr(dot + 1);
+            if (shard.empty() || shard.find('.') != std::string_view::npos || shard == "idx" || shard == "gz") {
+                return std::nullopt;
+            }
+            logger.append(".").append(shard);
+        }
+        return rolled_name{std::move(logger), number, compressed};
+    }
+
+    std::uint64_t index_size(const std::string& path) {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(path + ".idx", ec);
+        return ec ? 0 : size;
+    }
+
+#if LOGGING_HAVE_ZLIB
+    // writes path to target in gzip format, false when anything fails
+    bool gzip_file(const std::string& path, const std::string& target) {
+        auto in = std::fopen(path.c_str(), "rb");
+        if (!in) {
+            return false;
+        }
+        auto out = gzopen(target.c_str(), "wb6");
+        if (!out) {
+            std::fclose(in);
+            return false;
+        }
+        gzbuffer(out, 256 * 1024);
+
+        bool ok = true;
+        std::vector<char> buffer(256 * 1024);
+        std::size_t read;
+        while (ok && (read = std::fread(buffer.data(), 1, buffer.size(), in)) > 0) {
+            ok = gzwrite(out, buffer.data(), static_cast<unsigned>(read)) == static_cast<int>(read);
+        }
+        ok = ok && !std::ferror(in);
+        std::fclose(in);
+        return gzclose(out) == Z_OK && ok;
+    }
+#endif
+}
+
+namespace writers {
+
+    retention_manager::retention_manager(policy p, std::string directory,
+                                         std::shared_ptr<const global::clock_source> clock) :
+        m_policy{p},
+        m_directory{std::move(directory)},
+        m_clock{clock ? std::move(clock) : global::default_clock()}
+    {
+#if !LOGGING_HAVE_ZLIB
+        if (m_policy.compress) {
+            throw std::runtime_error("retention_manager: built without zlib, files cannot be compressed");
+        }
+#endif
+        adopt_existing();
+        m_worker = std::thread{[this] { run(); }};
+    }
+
+    retention_manager::~retention_manager() {
+        {
+            std::lock_guard lock{m_mutex};
+            m_stop = true;
+        }
+        m_wakeup.notify_one();
+        m_worker.join();
+    }
+
+    void retention_manager::attach(lg_logger_t* log) {
+        lg_set_roll_callback(log, &retention_manager::on_roll, this);
+    }
+
+    void retention_manager::on_roll(void* ctx, const char* path, std::size_t bytes) {
+        static_cast<retention_manager*>(ctx)->add_file(path, bytes);
+    }
+
+    void retention_manager::add_file(std::string path, std::uint64_t bytes) {
+        {
+            std::lock_guard lock{m_mutex};
+            m_queue.push_back({std::move(path), bytes, m_clock->now()});
+            ++m_queued;
+        }
+        m_wakeup.notify_one();
+    }
+
+    void retention_manager::sync() {
+        std::unique_lock lock{m_mutex};
+        auto target = m_queued;
+        m_idle.wait(lock, [this, target] { return m_applied >= target; });
+    }
+
+    retention_manager::totals retention_manager::stats() const {
+        std::lock_guard lock{m_mutex};
+        return m_totals;
+    }
+
+    void retention_manager::adopt_existing() {
+        struct candidate {
+            rolled_name name;
+            std::string path;
+            struct stat st;
+        };
+        std::vector<candidate> candidates;
+        std::unordered_map<std::string, std::uint64_t> newest;
+
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator{m_directory, ec}) {
+            auto name = parse_rolled_name(entry.path().filename().string());
+            struct stat st{};
+            if (!name || ::stat(entry.path().c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+                continue;
+            }
+            auto& number = newest[name->logger];
+            number = std::max(number, name->number);
+            candidates.push_back({std::move(*name), entry.path().string(), st});
+        }
+
+        // ages are carried over to the manager's clock, which stamps the files closed from now on
+        auto now = m_clock->now();
+        auto system_now = std::chrono::system_clock::now();
+        for (auto& c : candidates) {
+            // the newest file of a logger may still be open, it is reported when it is closed
+            if (!c.name.compressed && c.name.number == newest[c.name.logger]) {
+                continue;
+            }
+
+            auto modified = std::chrono::system_clock::from_time_t(c.st.st_mtim.tv_sec) +
+                            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                                std::chrono::nanoseconds{c.st.st_mtim.tv_nsec});
+            auto age = std::max(system_now - modified, std::chrono::system_clock::duration::zero());
+            auto bytes = static_cast<std::uint64_t>(c.st.st_size) + (c.name.compressed ? 0 : index_size(c.path));
+            m_files.push_back({std::move(c.path), bytes, now - age, !c.name.compressed});
+        }
+
+        std::sort(m_files.begin(), m_files.end(), [](const tracked_file& a, const tracked_file& b) {
+            return a.closed != b.closed ? a.closed < b.closed : a.path < b.path;
+        });
+        m_totals.files = m_files.size();
+        for (const auto& file : m_files) {
+            m_totals.bytes += file.bytes;
+        }
+    }
+
+    void retention_manager::run() {
+        std::unique_lock lock{m_mutex};
+        for (;;) {
+            m_wakeup.wait_for(lock, m_policy.check_interval, [this] { return m_stop || !m_queue.empty(); });
+            apply(lock);
+            if (m_stop && m_queue.empty()) {
+                return;
+            }
+        }
+    }
+
+    void retention_manager::apply(std::unique_lock<std::mutex>& lock) {
+        auto closed = std::exchange(m_queue, {});
+        auto target = m_queued;
+        auto removed = m_totals.removed;
+        auto compressed = m_totals.compressed;
+        lock.unlock();
+
+        for (auto& file : closed) {
+            auto bytes = file.bytes + index_size(file.path);
+            m_files.push_back({std::move(file.path), bytes, file.closed, m_policy.compress});
+        }
+
+        std::uint64_t bytes = 0;
+        for (const auto& file : m_files) {
+            bytes += file.bytes;
+        }
+        auto now = m_clock->now();
+        auto over_budget = [&] {
+            if (m_files.empty()) {
+                return false;
+            }
+            return (m_policy.max_files && m_files.size() > m_policy.max_files) ||
+                   (m_policy.max_bytes && bytes > m_policy.max_bytes) ||
+                   (m_policy.max_age.count() > 0 && now - m_files.front().closed > m_policy.max_age);
+        };
+        auto trim = [&] {
+            while (over_budget()) {
+                remove(m_files.front());
+                bytes -= m_files.front().bytes;
+                m_files.pop_front();
+                ++removed;
+            }
+        };
+
+        // files that are going anyway are not compressed first
+        trim();
+        if (m_policy.compress && m_files.size() > m_policy.keep_uncompressed) {
+            auto end = m_files.end() - static_cast<std::ptrdiff_t>(m_policy.keep_uncompressed);
+            for (auto it = m_files.begin(); it != end; ++it) {
+                if (it->compressible) {
+                    bytes -= it->bytes;
+                    compressed += compress(*it);
+                    bytes += it->bytes;
+                }
+            }
+            trim();
+        }
+
+        lock.lock();
+        m_totals = {m_files.size(), bytes, removed, compressed};
+        m_applied = target;
+        m_idle.notify_all();
+    }
+
+    bool retention_manager::compress(tracked_file& file) {
+        // a file that cannot be compressed stays as it is and is not tried again
+        file.compressible = false;
+#if LOGGING_HAVE_ZLIB
+        auto target = file.path + ".gz";
+        auto temp = target + ".tmp";
+        if (!gzip_file(file.path, temp) || std::rename(temp.c_str(), target.c_str()) != 0) {
+            ::unlink(temp.c_str());
+            return false;
+        }
+
+        // the offsets of the index do not point into the compressed file
+        ::unlink((file.path + ".idx").c_str());
+        ::unlink(file.path.c_str());
+        std::error_code ec;
+        auto size = std::filesystem::file_size(target, ec);
+        file.path = std::move(target);
+        file.bytes = ec ? 0 : size;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void retention_manager::remove(const tracked_file& file) {
+        ::unlink(file.path.c_str());
+        if (!file.path.ends_with(".gz")) {
+            ::unlink((file.path + ".idx").c_str());
+        }
+    }
+}
@@ -0,0 +1,180 @@
+#include "sharded_file_writer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <stdexcept>
+
+namespace writers {
+
+    // the shards of one thread, one per sharded_file_writer it wrote to; closed when the thread exits
+    struct shard_holder {
+        struct entry {
+            std::uint64_t id;
+            std::shared_ptr<sharded_file_writer::shard> shard;
+        };
+        std::vector<entry> shards;
+
+        ~shard_holder() {
+            for (auto& e : shards) {
+                std::lock_guard lock{e.shard->close_mutex};
+                // the shard of a destroyed writer is closed already
+                if (!e.shard->detached.load(std::memory_order_relaxed)) {
+                    e.shard->owner->close(*e.shard);
+                }
+            }
+        }
+    };
+}
+
+namespace {
+    std::atomic<std::uint64_t> next_id{1};
+    thread_local writers::shard_holder local;
+
+    constexpr std::size_t STAMP_DIGITS = 16;
+}
+
+namespace writers {
+
+    sharded_file_writer::sharded_file_writer(std::chrono::seconds roll_interval,
+                                             std::shared_ptr<const global::clock_source> clock,
+                                             std::shared_ptr<retention_manager> retention) :
+        m_roll_interval{roll_interval},
+        m_clock{clock ? std::move(clock) : global::default_clock()},
+        m_retention{std::move(retention)},
+        m_id{next_id.fetch_add(1, std::memory_order_relaxed)}
+    {}
+
+    sharded_file_writer::~sharded_file_writer() {
+        // the threads that exited have closed their shards, the others are closed here
+        for (auto& s : m_shards) {
+            std::lock_guard lock{s->close_mutex};
+            if (!s->closed.load(std::memory_order_relaxed)) {
+                close(*s);
+            }
+            s->detached.store(true, std::memory_order_release);
+        }
+    }
+
+    io::itext_writer& sharded_file_writer::operator<<(std::string_view view) {
+        append(view);
+        return *this;
+    }
+
+    io::itext_writer& sharded_file_writer::operator<<(const char* string) {
+        append(string);
+        return *this;
+    }
+
+    io::itext_writer& sharded_file_writer::operator<<(char c) {
+        append({&c, 1});
+        return *this;
+    }
+
+    io::itext_writer& sharded_file_writer::operator<<(int n) {
+        char temp[12];
+        auto [end, ec] = std::to_chars(temp, temp + sizeof(temp), n);
+        append({temp, static_cast<std::size_t>(end - temp)});
+        return *this;
+    }
+
+    io::itext_writer& sharded_file_writer::operator<<(io::flush_t) {
+        // the shards are written by their own threads only, lg_logger flushes when it rolls and closes
+        return *this;
+    }
+
+    std::size_t sharded_file_writer::shards() const {
+        std::lock_guard lock{m_mutex};
+        return static_cast<std::size_t>(std::count_if(m_shards.begin(), m_shards.end(), [](const auto& s) {
+            return !s->closed.load(std::memory_order_acquire);
+        }));
+    }
+
+    sharded_file_writer::shard& sharded_file_writer::local_shard() {
+        thread_local std::uint64_t cached_id = 0;
+        thread_local shard* cached = nullptr;
+
+        if (cached_id != m_id) {
+            auto found = std::find_if(local.shards.begin(), local.shards.end(),
+                                      [&](const auto& e) { return e.id == m_id; });
+            if (found == local.shards.end()) {
+                // the shards of destroyed writers go first
+                std::erase_if(local.shards,
+                              [](const auto& e) { return e.shard->detached.load(std::memory_order_acquire); });
+
+                auto fresh = std::make_shared<shard>();
+                fresh->owner = this;
+                {
+                    // lg_create is not thread safe (localtime), the shards are created one at a time
+                    std::lock_guard lock{m_mutex};
+                    std::erase_if(m_shards, [](const auto& s) { return s->closed.load(std::memory_order_acquire); });
+
+                    std::string suffix{"t"};
+                    suffix += std::to_string(m_next_shard);
+                    if (lg_create_shard(&fresh->log, m_roll_interval.count(), suffix.c_str()) != lgr_ok) {
+                        throw std::runtime_error("sharded_file_writer: cannot create the shard " + suffix);
+                    }
+                    ++m_next_shard;
+                    lg_set_clock(fresh->log, [](void* ctx) {
+                        return std::chrono::system_clock::to_time_t(static_cast<const global::clock_source*>(ctx)->now());
+                    }, const_cast<global::clock_source*>(m_clock.get()));
+                    if (m_retention) {
+                        m_retention->attach(fresh->log);
+                    }
+                    m_shards.push_back(fresh);
+                }
+                local.shards.push_back({m_id, std::move(fresh)});
+                found = std::prev(local.shards.end());
+            }
+            cached = found->shard.get();
+            cached_id = m_id;
+        }
+        return *cached;
+    }
+
+    void sharded_file_writer::append(std::string_view tokens) {
+        auto& s = local_shard();
+        std::size_t newline;
+        while ((newline = tokens.find('\n')) != std::string_view::npos) {
+            if (s.partial.empty()) {
+                write_record(s, tokens.substr(0, newline));
+            } else {
+                s.partial.append(tokens.substr(0, newline));
+                write_record(s, s.partial);
+                s.partial.clear();
+            }
+            tokens.remove_prefix(newline + 1);
+        }
+        s.partial.append(tokens);
+    }
+
+    void sharded_file_writer::write_record(shard& s, std::string_view record) {
+        auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(m_clock->now().time_since_epoch()).count();
+
+        char stamp[STAMP_DIGITS];
+        auto [end, ec] = std::to_chars(stamp, stamp + STAMP_DIGITS, static_cast<std::uint64_t>(nanoseconds), 16);
+        auto digits = static_cast<std::size_t>(end - stamp);
+
+        // lg_log appends the newline
+        s.record.assign(STAMP_DIGITS - digits, '0');
+        s.record.append(stamp, digits);
+        s.record += ' ';
+        s.record.append(record);
+        if (lg_log(s.log, s.record.c_str()) != lgr_ok) {
+            throw std::runtime_error("sharded_file_writer: lg_log failed to log message");
+        }
+    }
+
+    void sharded_file_writer::close(shard& s) noexcept {
+        if (!s.partial.empty()) {
+            try {
+                write_record(s, s.partial);
+            } catch (const std::runtime_error&) {
+                // nothing left to report the error to
+            }
+            s.partial.clear();
+        }
+        [[maybe_unused]] lg_result_e result = lg_destroy(&s.log);
+        s.closed.store(true, std::memory_order_release);
+    }
+}
@@ -0,0 +1,197 @@
+#include "shared_record.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <utility>
+
+namespace {
+    // set once the cache of the thread is gone, records released after that go to the free lists
+    thread_local bool cache_destroyed = false;
+}
+
+namespace io {
+
+    shared_record::shared_record(const shared_record& other) noexcept : m_buffer{other.m_buffer} {
+        if (m_buffer) {
+            m_buffer->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    shared_record::shared_record(shared_record&& other) noexcept : m_buffer{std::exchange(other.m_buffer, nullptr)} {}
+
+    shared_record& shared_record::operator=(const shared_record& other) noexcept {
+        if (this != &other) {
+            shared_record copy{other};
+            std::swap(m_buffer, copy.m_buffer);
+        }
+        return *this;
+    }
+
+    shared_record& shared_record::operator=(shared_record&& other) noexcept {
+        if (this != &other) {
+            release();
+            m_buffer = std::exchange(other.m_buffer, nullptr);
+        }
+        return *this;
+    }
+
+    shared_record::~shared_record() {
+        release();
+    }
+
+    std::string_view shared_record::view() const noexcept {
+        if (!m_buffer) {
+            return {};
+        }
+        return {m_buffer->bytes(), m_buffer->size};
+    }
+
+    std::size_t shared_record::size() const noexcept {
+        return m_buffer ? m_buffer->size : 0;
+    }
+
+    void shared_record::release() noexcept {
+        // the last reference has to see the writes of all others before the buffer is reused
+        if (m_buffer && m_buffer->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            record_pool::get_instance().release(m_buffer);
+        }
+        m_buffer = nullptr;
+    }
+
+    record_pool::~record_pool() {
+        for (auto& c : m_classes) {
+            for (auto buffer : c.free) {
+                destroy(buffer);
+            }
+        }
+    }
+
+    void record_pool::destroy(shared_record::header* buffer) noexcept {
+        buffer->~header();
+        ::operator delete(buffer);
+    }
+
+    record_pool::thread_cache::~thread_cache() {
+        cache_destroyed = true;
+        for (std::size_t index = 0; index < free.size(); ++index) {
+            record_pool::get_instance().give_back(index, free[index].data(), free[index].size());
+        }
+    }
+
+    record_pool::thread_cache* record_pool::local_cache() noexcept {
+        if (cache_destroyed) {
+            return nullptr;
+        }
+        thread_local thread_cache cache;
+        return &cache;
+    }
+
+    shared_record record_pool::make(std::string_view bytes) {
+        std::uint32_t index = 0;
+        while (index < CLASS_SIZES.size() && CLASS_SIZES[index] < bytes.size()) {
+            ++index;
+        }
+
+        shared_record::header* buffer = nullptr;
+        if (index < CLASS_SIZES.size()) {
+            auto& c = m_classes[index];
+            if (auto cache = local_cache()) {
+                auto& local = cache->free[index];
+                if (local.empty()) {
+                    // half of what the thread may keep is taken at once, release() fills up the rest
+                    local.reserve(local_capacity(index));
+                    std::lock_guard lock{c.mutex};
+                    auto count = static_cast<std::ptrdiff_t>(std::min(c.free.size(), local_capacity(index) / 2));
+                    local.insert(local.end(), c.free.end() - count, c.free.end());
+                    c.free.erase(c.free.end() - count, c.free.end());
+                }
+                if (!local.empty()) {
+                    buffer = local.back();
+                    local.pop_back();
+                }
+            } else {
+                std::lock_guard lock{c.mutex};
+                if (!c.free.empty()) {
+                    buffer = c.free.back();
+                    c.free.pop_back();
+                }
+            }
+        }
+
+        if (buffer) {
+            m_reused.fetch_add(1, std::memory_order_relaxed);
+            buffer->refs.store(1, std::memory_order_relaxed);
+        } else {
+            auto capacity = index < CLASS_SIZES.size() ? CLASS_SIZES[index] : bytes.size();
+            buffer = new (::operator new(sizeof(shared_record::header) + capacity)) shared_record::header{{1}, index, 0};
+        }
+
+        std::memcpy(buffer->bytes(), bytes.data(), bytes.size());
+        buffer->size = bytes.size();
+        m_records.fetch_add(1, std::memory_order_relaxed);
+        m_bytes.fetch_add(bytes.size(), std::memory_order_relaxed);
+        return shared_record{buffer};
+    }
+
+    void record_pool::release(shared_record::header* buffer) noexcept {
+        auto index = buffer->size_class;
+        if (index >= CLASS_SIZES.size()) {
+            destroy(buffer);
+            return;
+        }
+
+        if (auto cache = local_cache()) {
+            auto& local = cache->free[index];
+            if (local.capacity() < local_capacity(index)) {
+                try {
+                    local.reserve(local_capacity(index));
+                } catch (...) {
+                }
+            }
+            if (local.size() == local_capacity(index)) {
+                // the older half goes back, the buffers released last are the ones still in the cache
+                auto half = static_cast<std::ptrdiff_t>(local_capacity(index) / 2);
+                give_back(index, local.data(), static_cast<std::size_t>(half));
+                local.erase(local.begin(), local.begin() + half);
+            }
+            if (local.size() < local.capacity()) {
+                local.push_back(buffer);
+                return;
+            }
+        }
+        give_back(index, &buffer, 1);
+    }
+
+    void record_pool::give_back(std::size_t index, shared_record::header* const* buffers, std::size_t count) noexcept {
+        std::size_t kept = 0;
+        {
+            auto& c = m_classes[index];
+            std::lock_guard lock{c.mutex};
+            auto room = FREE_BUDGET / CLASS_SIZES[index] - std::min(c.free.size(), FREE_BUDGET / CLASS_SIZES[index]);
+            // the list only allocates while it grows towards its budget
+            try {
+                kept = std::min(count, room);
+                c.free.insert(c.free.end(), buffers, buffers + kept);
+            } catch (...) {
+                kept = 0;
+            }
+        }
+        for (auto it = buffers + kept; it != buffers + count; ++it) {
+            destroy(*it);
+        }
+    }
+
+    record_pool::totals record_pool::stats() const {
+        return {
+            m_records.load(std::memory_order_relaxed),
+            m_bytes.load(std::memory_order_relaxed),
+            m_reused.load(std::memory_order_relaxed)
+        };
+    }
+
+    record_pool& record_pool::get_instance() {
+        static record_pool obj{};
+        return obj;
+    }
+}
@@ -0,0 +1,281 @@
+#include "shm/shm_ring.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr std::uint64_t RING_MAGIC = 0x474e4952474f4cULL; // "LOGRING"
+    constexpr std::uint32_t RING_VERSION = 2;
+    constexpr std::size_t CACHE_LINE = 64;
+    // set in the sequence of a slot while its producer writes the record
+    constexpr std::uint64_t CLAIMED = std::uint64_t{1} << 63;
+    // a dead owner may also be a producer in another pid namespace, it gets this long to finish
+    constexpr std::chrono::milliseconds DEAD_OWNER_GRACE{10};
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "the ring needs address-free 64 bit atomics");
+
+    std::string segment_name(std::string_view name) {
+        std::string result{name};
+        if (result.empty() || result.front() != '/') {
+            result.insert(result.begin(), '/');
+        }
+        return result;
+    }
+
+    std::size_t round_up(std::size_t n, std::size_t multiple) {
+        return (n + multiple - 1) / multiple * multiple;
+    }
+
+    // getpid(2) is a system call, the pid is cached and forgotten in forked children
+    std::atomic<pid_t> cached_pid{0};
+
+    pid_t current_pid() noexcept {
+        auto pid = cached_pid.load(std::memory_order_relaxed);
+        if (pid == 0) {
+            pid = ::getpid();
+            cached_pid.store(pid, std::memory_order_relaxed);
+        }
+        return pid;
+    }
+
+    void forget_pid() noexcept {
+        cached_pid.store(0, std::memory_order_relaxed);
+    }
+}
+
+namespace shm {
+
+    struct ring::header {
+        std::atomic<std::uint64_t> magic;
+        std::uint32_t version;
+        std::uint32_t slot_size;
+        std::uint64_t capacity;
+
+        alignas(CACHE_LINE) std::atomic<std::uint64_t> tail;
+        alignas(CACHE_LINE) std::atomic<std::uint64_t> head;
+        alignas(CACHE_LINE) std::atomic<std::uint64_t> dropped;
+        std::atomic<std::uint64_t> truncated;
+        std::atomic<std::uint64_t> abandoned;
+    };
+
+    struct ring::slot {
+        // pos while free, pos | CLAIMED while written, pos + 1 once published,
+        // pos + capacity once consumed or taken back and free for the next lap
+        std::atomic<std::uint64_t> sequence;
+        std::atomic<pid_t> owner;
+        std::uint32_t length;
+    };
+
+    ring::ring(std::string_view name, std::size_t capacity, std::size_t slot_size) :
+        m_name{segment_name(name)}
+    {
+        static const int atfork = ::pthread_atfork(nullptr, nullptr, &forget_pid);
+        (void) atfork;
+
+        capacity = std::bit_ceil(std::max<std::size_t>(capacity, 2));
+        slot_size = round_up(std::max(slot_size, sizeof(slot) + 16), CACHE_LINE);
+
+        bool created = true;
+        int fd = ::shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd < 0 && errno == EEXIST) {
+            created = false;
+            fd = ::shm_open(m_name.c_str(), O_RDWR | O_CLOEXEC, 0600);
+        }
+        if (fd < 0) {
+            throw std::runtime_error("shm_open failed for the log ring " + m_name);
+        }
+
+        auto header_size = round_up(sizeof(header), CACHE_LINE);
+        if (created) {
+            m_mapped_size = header_size + capacity * slot_size;
+            if (::ftruncate(fd, static_cast<off_t>(m_mapped_size)) != 0) {
+                ::close(fd);
+                ::shm_unlink(m_name.c_str());
+                throw std::runtime_error("ftruncate failed for the log ring " + m_name);
+            }
+        } else {
+            // the creator may still be sizing the segment
+            struct stat st{};
+            for (int attempt = 0; attempt < 1000 && ::fstat(fd, &st) == 0 && st.st_size == 0; ++attempt) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+            m_mapped_size = static_cast<std::size_t>(st.st_size);
+        }
+
+        void* addr = (m_mapped_size > header_size)
+            ? ::mmap(nullptr, m_mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+            : MAP_FAILED;
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            throw std::runtime_error("mmap failed for the log ring " + m_name);
+        }
+        m_header = static_cast<header*>(addr);
+
+        if (created) {
+            auto* h = new (addr) header{};
+            h->version = RING_VERSION;
+            h->slot_size = static_cast<std::uint32_t>(slot_size);
+            h->capacity = capacity;
+            for (std::uint64_t pos = 0; pos < capacity; ++pos) {
+                auto* s = new (&at(pos)) slot{};
+                s->sequence.store(pos, std::memory_order_relaxed);
+            }
+            h->magic.store(RING_MAGIC, std::memory_order_release);
+        } else {
+            for (int attempt = 0; attempt < 1000 && m_header->magic.load(std::memory_order_acquire) != RING_MAGIC; ++attempt) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+            if (m_header->magic.load(std::memory_order_acquire) != RING_MAGIC
+                || m_header->version != RING_VERSION
+                || m_mapped_size < header_size + m_header->capacity * m_header->slot_size) {
+                ::munmap(m_header, m_mapped_size);
+                throw std::runtime_error("incompatible log ring " + m_name);
+            }
+        }
+    }
+
+    ring::~ring() {
+        if (m_header) {
+            ::munmap(m_header, m_mapped_size);
+        }
+    }
+
+    bool ring::try_push(std::string_view record) noexcept {
+        auto& h = *m_header;
+        auto pos = h.tail.load(std::memory_order_relaxed);
+        slot* s;
+
+        while (true) {
+            s = &at(pos);
+            auto seq = s->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::int64_t>(seq - pos);
+            if (diff == 0) {
+                if (h.tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                h.dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = h.tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        // the consumer may have taken the slot back already, thinking this producer dead
+        auto expected = pos;
+        if (!s->sequence.compare_exchange_strong(expected, pos | CLAIMED, std::memory_order_acquire)) {
+            h.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // lets the consumer tell a dead producer from a slow one
+        s->owner.store(current_pid(), std::memory_order_relaxed);
+
+        auto length = std::min(record.size(), max_record_size());
+        if (length < record.size()) {
+            h.truncated.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::memcpy(payload(*s), record.data(), length);
+        s->length = static_cast<std::uint32_t>(length);
+
+        // taken back while the record was written, the slot belongs to a later lap now
+        expected = pos | CLAIMED;
+        if (!s->sequence.compare_exchange_strong(expected, pos + 1, std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
+            h.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    std::size_t ring::capacity() const noexcept {
+        return m_header->capacity;
+    }
+
+    std::size_t ring::max_record_size() const noexcept {
+        return m_header->slot_size - sizeof(slot);
+    }
+
+    ring::counters ring::stats() const noexcept {
+        return {
+            m_header->dropped.load(std::memory_order_relaxed),
+            m_header->truncated.load(std::memory_order_relaxed),
+            m_header->abandoned.load(std::memory_order_relaxed)
+        };
+    }
+
+    void ring::unlink(std::string_view name) {
+        ::shm_unlink(segment_name(name).c_str());
+    }
+
+    ring::slot& ring::at(std::uint64_t pos) const noexcept {
+        auto* base = reinterpret_cast<char*>(m_header) + round_up(sizeof(header), CACHE_LINE);
+        auto index = pos & (m_header->capacity - 1);
+        return *reinterpret_cast<slot*>(base + index * m_header->slot_size);
+    }
+
+    char* ring::payload(slot& s) const noexcept {
+        return reinterpret_cast<char*>(&s) + sizeof(slot);
+    }
+
+    bool ring::try_pop(std::string_view& record, std::uint64_t& pos) noexcept {
+        pos = m_header->head.load(std::memory_order_relaxed);
+        auto& s = at(pos);
+        if (s.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+        record = {payload(s), s.length};
+        return true;
+    }
+
+    void ring::release(std::uint64_t pos) noexcept {
+        auto& s = at(pos);
+        s.owner.store(0, std::memory_order_relaxed);
+        s.sequence.store(pos + m_header->capacity, std::memory_order_release);
+        m_header->head.store(pos + 1, std::memory_order_relaxed);
+    }
+
+    bool ring::is_abandoned(std::uint64_t pos, std::chrono::milliseconds stall_timeout) {
+        // nothing reserved at pos, the ring is simply empty
+        if (m_header->tail.load(std::memory_order_acquire) <= pos) {
+            return false;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (m_stalled_pos != pos) {
+            m_stalled_pos = pos;
+            m_stalled_since = now;
+        }
+
+        // taking the slot back only costs a live producer its record, the CASes keep the ring intact
+        auto stalled_for = now - m_stalled_since;
+        auto owner = at(pos).owner.load(std::memory_order_relaxed);
+        bool owner_dead = owner != 0 && stalled_for >= DEAD_OWNER_GRACE && ::kill(owner, 0) != 0 && errno == ESRCH;
+        return owner_dead || stalled_for >= stall_timeout;
+    }
+
+    bool ring::reclaim(std::uint64_t pos) noexcept {
+        auto& s = at(pos);
+        auto state = s.sequence.load(std::memory_order_acquire);
+        if (state != pos && state != (pos | CLAIMED)) {
+            return false;
+        }
+        if (!s.sequence.compare_exchange_strong(state, pos + m_header->capacity, std::memory_order_acq_rel)) {
+            return false;
+        }
+        s.owner.store(0, std::memory_order_relaxed);
+        m_header->head.store(pos + 1, std::memory_order_relaxed);
+        m_header->abandoned.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+}
@@ -0,0 +1,73 @@
+#include "shm_ring_writer.h"
+
+#include <charconv>
+
+namespace writers {
+
+    shm_ring_writer::shm_ring_writer(std::string_view ring_name) :
+        shm_ring_writer(ring_name, shm::ring::default_capacity, shm::ring::default_slot_size) {}
+
+    shm_ring_writer::shm_ring_writer(std::string_view ring_name, std::size_t capacity, std::size_t slot_size) :
+        m_ring{ring_name, capacity, slot_size}
+    {
+        // the record buffer never grows on the hot path
+        m_record.reserve(m_ring.max_record_size() + 1);
+    }
+
+    io::itext_writer& shm_ring_writer::operator<<(std::string_view view) {
+        append(view);
+        return *this;
+    }
+
+    io::itext_writer& shm_ring_writer::operator<<(const char* string) {
+        append(string);
+        return *this;
+    }
+
+    io::itext_writer& shm_ring_writer::operator<<(char c) {
+        append({&c, 1});
+        return *this;
+    }
+
+    io::itext_writer& shm_ring_writer::operator<<(int n) {
+        char buffer[16];
+        auto [end, _] = std::to_chars(&buffer[0], &buffer[sizeof(buffer)], n);
+        append({&buffer[0], static_cast<std::size_t>(end - &buffer[0])});
+        return *this;
+    }
+
+    io::itext_writer& shm_ring_writer::operator<<(io::flush_t) {
+        if (!m_record.empty()) {
+            push_record();
+        }
+        return *this;
+    }
+
+    shm::ring::counters shm_ring_writer::stats() const noexcept {
+        return m_ring.stats();
+    }
+
+    std::uint64_t shm_ring_writer::dropped_records() const noexcept {
+        return m_ring.stats().dropped;
+    }
+
+    void shm_ring_writer::append(std::string_view data) {
+        // anything longer than a slot is truncated by the ring anyway
+        auto append_bounded = [this](std::string_view part) {
+            m_record.append(part.substr(0, m_record.capacity() - m_record.size()));
+        };
+
+        std::size_t newline;
+        while ((newline = data.find('\n')) != std::string_view::npos) {
+            append_bounded(data.substr(0, newline));
+            push_record();
+            data.remove_prefix(newline + 1);
+        }
+        append_bounded(data);
+    }
+
+    void shm_ring_writer::push_record() {
+        m_ring.try_push(m_record);
+        m_record.clear();
+    }
+}
@@ -0,0 +1,280 @@
+#include "socket_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    std::size_t count_records(std::string_view records) {
+        return static_cast<std::size_t>(std::count(records.cbegin(), records.cend(), '\n'));
+    }
+
+    // the longest prefix of data that holds whole records and fits into limit (at least one record)
+    std::string_view next_datagram(std::string_view data, std::size_t limit) {
+        auto end = data.substr(0, limit).rfind('\n');
+        if (end == std::string_view::npos) {
+            end = data.find('\n');
+        }
+        return data.substr(0, end == std::string_view::npos ? data.size() : end + 1);
+    }
+}
+
+namespace writers {
+
+    socket_writer::socket_writer(std::string_view path) : socket_writer(path, options{}) {}
+
+    socket_writer::socket_writer(std::string_view path, options opts) :
+        m_path{path}, m_opts{opts}
+    {
+        if (m_path.size() >= sizeof(sockaddr_un::sun_path)) {
+            throw std::invalid_argument("socket_writer: socket path is too long");
+        }
+        m_buffer.reserve(m_opts.batch_bytes * 2);
+        try_connect();
+    }
+
+    socket_writer::~socket_writer() {
+        if (!m_buffer.empty() && m_buffer.back() != '\n') {
+            m_buffer.push_back('\n');
+        }
+        // nothing is kept for later anymore: whatever the collector refuses goes to the local files
+        m_opts.max_pending_bytes = 0;
+        if (m_opts.on_full == backpressure::drop) {
+            m_opts.on_full = backpressure::fallback;
+        }
+        send_complete_records();
+        disconnect();
+
+        if (m_fallback) {
+            [[maybe_unused]] lg_result_e result = lg_destroy(&m_fallback);
+        }
+    }
+
+    io::itext_writer& socket_writer::operator<<(std::string_view view) {
+        append(view);
+        return *this;
+    }
+
+    io::itext_writer& socket_writer::operator<<(const char* string) {
+        append(string);
+        return *this;
+    }
+
+    io::itext_writer& socket_writer::operator<<(char c) {
+        append({&c, 1});
+        return *this;
+    }
+
+    io::itext_writer& socket_writer::operator<<(int n) {
+        char buffer[16];
+        auto [end, _] = std::to_chars(&buffer[0], &buffer[sizeof(buffer)], n);
+        append({&buffer[0], static_cast<std::size_t>(end - &buffer[0])});
+        return *this;
+    }
+
+    io::itext_writer& socket_writer::operator<<(io::flush_t) {
+        send_complete_records();
+        return *this;
+    }
+
+    bool socket_writer::connected() const noexcept {
+        return m_fd >= 0;
+    }
+
+    std::uint64_t socket_writer::dropped_records() const noexcept {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t socket_writer::fallback_records() const noexcept {
+        return m_fallback_records.load(std::memory_order_relaxed);
+    }
+
+    void socket_writer::append(std::string_view data) {
+        m_buffer.append(data);
+        if (m_buffer.size() >= m_opts.batch_bytes) {
+            send_complete_records();
+        }
+    }
+
+    void socket_writer::send_complete_records() {
+        auto last = m_buffer.rfind('\n');
+        if (last == std::string::npos) {
+            return;
+        }
+
+        const std::string_view records{m_buffer.data(), last + 1};
+        std::size_t sent = 0;
+        bool waited = false;
+
+        while (sent < records.size()) {
+            auto rest = records.substr(sent);
+
+            if (!try_connect()) {
+                write_fallback(rest);
+                sent = records.size();
+                break;
+            }
+
+            auto n = send_some(rest);
+            if (n < 0) {
+                disconnect();
+                continue;
+            }
+            if (n > 0) {
+                sent += static_cast<std::size_t>(n);
+                waited = false;
+                // the fallback files and the next connection only ever get whole records
+                if (records[sent - 1] != '\n') {
+                    sent = finish_record(records, sent);
+                }
+                continue;
+            }
+
+            // the collector is busy, keep the records for the next batch while there is room
+            if (m_buffer.size() - sent <= m_opts.max_pending_bytes) {
+                break;
+            }
+
+            if (m_opts.on_full == backpressure::block && !waited && wait_writable()) {
+                waited = true;
+                continue;
+            }
+
+            if (m_opts.on_full == backpressure::drop) {
+                drop(rest);
+            } else {
+                write_fallback(rest);
+            }
+            sent = records.size();
+        }
+
+        m_buffer.erase(0, sent);
+    }
+
+    std::size_t socket_writer::finish_record(std::string_view records, std::size_t sent) {
+        auto end = records.find('\n', sent) + 1;
+        auto deadline = std::chrono::steady_clock::now() + m_opts.block_timeout;
+        while (sent < end) {
+            auto n = send_some(records.substr(sent, end - sent));
+            if (n > 0) {
+                sent += static_cast<std::size_t>(n);
+                continue;
+            }
+
+            // the collector already has the head, so the tail can only go on this connection: wait for it,
+            // but no longer than block_timeout
+            auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (n == 0 && left.count() > 0) {
+                pollfd pfd{m_fd, POLLOUT, 0};
+                if ((::poll(&pfd, 1, static_cast<int>(left.count())) >= 0 || errno == EINTR) &&
+                    !(pfd.revents & (POLLERR | POLLHUP))) {
+                    continue;
+                }
+            }
+            // the connection is gone or stuck with a torn record, its tail is dropped
+            disconnect();
+            drop(records.substr(sent, end - sent));
+            break;
+        }
+        return end;
+    }
+
+    bool socket_writer::try_connect() {
+        if (m_fd >= 0) {
+            return true;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now < m_next_connect) {
+            return false;
+        }
+        m_next_connect = now + m_opts.reconnect_interval;
+
+        auto type = (m_opts.type == socket_type::stream) ? SOCK_STREAM : SOCK_DGRAM;
+        int fd = ::socket(AF_UNIX, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return false;
+        }
+
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::memcpy(&addr.sun_path[0], m_path.c_str(), m_path.size() + 1);
+
+        if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            return false;
+        }
+
+        m_fd = fd;
+        return true;
+    }
+
+    void socket_writer::disconnect() {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    long socket_writer::send_some(std::string_view data) {
+        if (m_opts.type == socket_type::datagram) {
+            data = next_datagram(data, m_opts.batch_bytes);
+        }
+
+        while (true) {
+            auto n = ::send(m_fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (n >= 0) {
+                return n;
+            }
+
+            switch (errno) {
+                case EINTR:
+                    continue;
+                case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+                case EWOULDBLOCK:
+#endif
+                case ENOBUFS:
+                    return 0;
+                case EMSGSIZE:
+                    // a single record that can never fit into a datagram
+                    drop(data);
+                    return static_cast<long>(data.size());
+                default:
+                    return -1;
+            }
+        }
+    }
+
+    bool socket_writer::wait_writable() {
+        pollfd pfd{m_fd, POLLOUT, 0};
+        auto timeout = static_cast<int>(m_opts.block_timeout.count());
+        return ::poll(&pfd, 1, timeout) > 0 && (pfd.revents & POLLOUT);
+    }
+
+    void socket_writer::write_fallback(std::string_view records) {
+        if (!m_fallback) {
+            if (lg_create(&m_fallback, m_opts.fallback_roll_interval.count()) != lgr_ok) {
+                drop(records);
+                return;
+            }
+            lg_set_append_newline(m_fallback, false);
+        }
+
+        if (lg_log(m_fallback, std::string{records}.c_str()) == lgr_ok) {
+            m_fallback_records.fetch_add(count_records(records), std::memory_order_relaxed);
+        } else {
+            drop(records);
+        }
+    }
+
+    void socket_writer::drop(std::string_view records) {
+        m_dropped.fetch_add(count_records(records), std::memory_order_relaxed);
+    }
+}
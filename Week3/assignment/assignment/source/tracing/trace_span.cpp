@@ -0,0 +1,196 @@
+#include "tracing/trace_span.h"
+#include "global/runningtime_provider.h"
+#include <charconv>
+#include <unistd.h>
+
+namespace tracing {
+
+    // hands the ring of an exiting thread to the collector, which drains and releases it
+    struct ring_holder {
+        std::shared_ptr<tracer::ring> ring;
+
+        ~ring_holder() {
+            if (ring) {
+                ring->orphaned.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    namespace {
+        thread_local ring_holder local;
+
+        void append_escaped(std::string& out, const char* text) {
+            for (; *text; ++text) {
+                auto c = static_cast<unsigned char>(*text);
+                if (c == '"' || c == '\\') {
+                    out += '\\';
+                    out += static_cast<char>(c);
+                } else if (c < 0x20) {
+                    static const char* hex = "0123456789abcdef";
+                    out += "\\u00";
+                    out += hex[c >> 4];
+                    out += hex[c & 0xf];
+                } else {
+                    out += static_cast<char>(c);
+                }
+            }
+        }
+
+        template <typename T>
+        void append_number(std::string& out, T value) {
+            char buffer[24];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, result.ptr);
+        }
+    }
+
+    tracer::~tracer() {
+        stop();
+    }
+
+    void tracer::start(std::unique_ptr<io::itext_writer> sink, std::chrono::milliseconds interval) {
+        stop();
+        {
+            std::lock_guard lock{m_sink_mutex};
+            m_sink = std::move(sink);
+            m_first_event = true;
+            m_pid = static_cast<int>(::getpid());
+            *m_sink << "[\n";
+        }
+
+        m_collector = std::jthread{[this, interval](std::stop_token stop) {
+            while (!stop.stop_requested()) {
+                std::this_thread::sleep_for(interval);
+                collect();
+            }
+        }};
+        detail::enabled.store(true, std::memory_order_relaxed);
+    }
+
+    void tracer::stop() {
+        if (!m_collector.joinable()) {
+            return;
+        }
+        detail::enabled.store(false, std::memory_order_relaxed);
+        m_collector.request_stop();
+        m_collector.join();
+
+        collect();
+        std::lock_guard lock{m_sink_mutex};
+        *m_sink << "\n]\n" << io::flush;
+        m_sink.reset();
+    }
+
+    bool tracer::record(const char* name, const char* category, char phase) noexcept {
+        auto r = local_ring();
+        if (!r) {
+            m_dropped.add();
+            return false;
+        }
+
+        auto head = r->head.load(std::memory_order_relaxed);
+        if (phase == 'B') {
+            auto used = head - r->tail.load(std::memory_order_acquire);
+            if (used + r->open + 2 > ring_capacity) {
+                m_dropped.add();
+                return false;
+            }
+            ++r->open;
+        } else if (phase == 'E') {
+            --r->open;
+        }
+
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        r->events[head % ring_capacity] = {name, category, std::chrono::duration_cast<std::chrono::nanoseconds>(now).count(), phase};
+        r->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::uint64_t tracer::dropped_events() const noexcept {
+        return m_dropped.value();
+    }
+
+    tracer& tracer::get_instance() {
+        static tracer obj{};
+        return obj;
+    }
+
+    tracer::ring* tracer::local_ring() noexcept {
+        if (!local.ring) {
+            try {
+                auto r = std::make_shared<ring>();
+                r->tid = static_cast<int>(::gettid());
+                std::lock_guard lock{m_mutex};
+                m_rings.push_back(r);
+                local.ring = std::move(r);
+            } catch (...) {
+                return nullptr;
+            }
+        }
+        return local.ring.get();
+    }
+
+    void tracer::collect() {
+        std::vector<std::shared_ptr<ring>> rings;
+        {
+            std::lock_guard lock{m_mutex};
+            rings = m_rings;
+        }
+
+        std::lock_guard lock{m_sink_mutex};
+        if (!m_sink) {
+            return;
+        }
+
+        for (const auto& r : rings) {
+            // an orphaned ring gets no more events, once drained it can go
+            bool orphaned = r->orphaned.load(std::memory_order_acquire);
+            auto tail = r->tail.load(std::memory_order_relaxed);
+            auto head = r->head.load(std::memory_order_acquire);
+            write_events(*r, tail, head);
+            r->tail.store(head, std::memory_order_release);
+
+            if (orphaned) {
+                std::lock_guard rings_lock{m_mutex};
+                std::erase(m_rings, r);
+            }
+        }
+
+        if (!m_out.empty()) {
+            *m_sink << std::string_view{m_out};
+            m_out.clear();
+        }
+    }
+
+    void tracer::write_events(const ring& r, std::size_t from, std::size_t to) {
+        auto start = global::runningtime_provider::get_instance().steady_start_time().time_since_epoch();
+        auto start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(start).count();
+
+        for (auto i = from; i != to; ++i) {
+            const auto& e = r.events[i % ring_capacity];
+            auto ns = e.steady_ns - start_ns;
+
+            m_out += m_first_event ? "" : ",\n";
+            m_first_event = false;
+            m_out += R"({"name":")";
+            append_escaped(m_out, e.name);
+            m_out += R"(","cat":")";
+            append_escaped(m_out, e.category);
+            m_out += R"(","ph":")";
+            m_out += e.phase;
+            // trace-event time stamps are microseconds
+            m_out += R"(","ts":)";
+            append_number(m_out, ns / 1000);
+            m_out += '.';
+            auto fraction = ns % 1000;
+            m_out += static_cast<char>('0' + fraction / 100);
+            m_out += static_cast<char>('0' + fraction / 10 % 10);
+            m_out += static_cast<char>('0' + fraction % 10);
+            m_out += R"(,"pid":)";
+            append_number(m_out, m_pid);
+            m_out += R"(,"tid":)";
+            append_number(m_out, r.tid);
+            m_out += '}';
+        }
+    }
+}
@@ -0,0 +1,611 @@
+#include "uring_writer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace writers {
+
+    class uring_writer::engine {
+    public:
+        virtual ~engine() = default;
+
+        // starts writing the first length bytes of buffer index to offset in the file
+        virtual void submit(unsigned index, std::size_t length, std::uint64_t offset) = 0;
+        // adds the buffers whose write is done to done, waiting for at least one when wait is set;
+        // returns 0 or the errno of a write that failed
+        virtual int reap(std::vector<unsigned>& done, bool wait) = 0;
+
+        virtual bool is_io_uring() const noexcept = 0;
+    };
+}
+
+namespace {
+    constexpr std::size_t PAGE_SIZE = 4096;
+    // buffers that follow each other in the file and go out in one pwritev
+    constexpr std::size_t MAX_RUN = 64;
+
+    std::size_t round_to_pages(std::size_t size) {
+        return std::max<std::size_t>((size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE, PAGE_SIZE);
+    }
+
+    // glibc has no wrappers for the io_uring system calls
+    int io_uring_setup(unsigned entries, io_uring_params* params) {
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int io_uring_enter(int ring, unsigned to_submit, unsigned min_complete, unsigned flags) {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, ring, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    int io_uring_register(int ring, unsigned opcode, const void* arg, unsigned count) {
+        return static_cast<int>(::syscall(__NR_io_uring_register, ring, opcode, arg, count));
+    }
+
+    struct pending_write {
+        std::size_t length = 0;
+        std::size_t done = 0;
+        std::uint64_t offset = 0;
+    };
+
+    /*
+     * One submission ring used by the writing thread only. Every buffer has at most one write in
+     * flight and there are as many ring entries as buffers, so neither ring can run full.
+     */
+    class uring_engine final : public writers::uring_writer::engine {
+    public:
+        uring_engine(int file, char* buffers, std::size_t buffer_size, unsigned count) :
+            m_file{file}, m_buffers{buffers}, m_buffer_size{buffer_size}, m_pending(count)
+        {
+            io_uring_params params{};
+            m_ring = io_uring_setup(count, &params);
+            if (m_ring < 0) {
+                return;
+            }
+            if (!supports_write()) {
+                release();
+                return;
+            }
+
+            m_sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            m_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (single) {
+                m_sq_size = m_cq_size = std::max(m_sq_size, m_cq_size);
+            }
+            m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+            m_sq = map(m_sq_size, IORING_OFF_SQ_RING);
+            m_cq = single ? m_sq : map(m_cq_size, IORING_OFF_CQ_RING);
+            m_sqes = static_cast<io_uring_sqe*>(map(m_sqes_size, IORING_OFF_SQES));
+            if (!m_sq || !m_cq || !m_sqes) {
+                release();
+                return;
+            }
+
+            auto sq = static_cast<char*>(m_sq);
+            m_sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            m_sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            m_sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            auto cq = static_cast<char*>(m_cq);
+            m_cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            m_cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            m_cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+            // registered buffers stay pinned, plain writes are used when they cannot be (RLIMIT_MEMLOCK)
+            std::vector<iovec> registered(count);
+            for (unsigned i = 0; i < count; ++i) {
+                registered[i] = {m_buffers + i * m_buffer_size, m_buffer_size};
+            }
+            m_fixed = io_uring_register(m_ring, IORING_REGISTER_BUFFERS, registered.data(), count) == 0;
+        }
+
+        uring_engine(const uring_engine&) = delete;
+        uring_engine& operator=(const uring_engine&) = delete;
+
+        ~uring_engine() override {
+            // the kernel may still read from the buffers
+            std::vector<unsigned> done;
+            while (m_in_flight > 0) {
+                auto in_flight = m_in_flight;
+                if (reap(done, true) != 0 && m_in_flight == in_flight) {
+                    // io_uring_enter fails, waiting any longer would never end
+                    break;
+                }
+            }
+            release();
+        }
+
+        bool ready() const noexcept { return m_ring >= 0; }
+
+        void submit(unsigned index, std::size_t length, std::uint64_t offset) override {
+            m_pending[index] = {length, 0, offset};
+            if (!push(index)) {
+                throw std::runtime_error(std::string{"uring_writer: io_uring_enter failed: "} + std::strerror(errno));
+            }
+            ++m_in_flight;
+        }
+
+        int reap(std::vector<unsigned>& done, bool wait) override {
+            int error = 0;
+            for (;;) {
+                auto head = *m_cq_head;
+                auto tail = std::atomic_ref<unsigned>{*m_cq_tail}.load(std::memory_order_acquire);
+                bool finished = false;
+                m_retry.clear();
+
+                for (; head != tail; ++head) {
+                    const auto& cqe = m_cqes[head & m_cq_mask];
+                    auto index = static_cast<unsigned>(cqe.user_data);
+                    auto& write = m_pending[index];
+
+                    if (cqe.res > 0) {
+                        write.done += static_cast<std::size_t>(cqe.res);
+                        if (write.done < write.length) {
+                            m_retry.push_back(index);
+                            continue;
+                        }
+                    } else if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+                        m_retry.push_back(index);
+                        continue;
+                    } else {
+                        // a write of 0 bytes would be repeated forever
+                        error = cqe.res == 0 ? EIO : -cqe.res;
+                    }
+                    --m_in_flight;
+                    done.push_back(index);
+                    finished = true;
+                }
+                std::atomic_ref<unsigned>{*m_cq_head}.store(head, std::memory_order_release);
+
+                // short writes continue where they stopped
+                for (auto index : m_retry) {
+                    if (!push(index)) {
+                        error = errno;
+                        --m_in_flight;
+                        done.push_back(index);
+                        finished = true;
+                    }
+                }
+                if (finished || !wait || m_in_flight == 0) {
+                    return error;
+                }
+                if (io_uring_enter(m_ring, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+                    return errno;
+                }
+            }
+        }
+
+        bool is_io_uring() const noexcept override { return true; }
+
+    private:
+        // kernels before 5.6 set up a ring but fail every IORING_OP_WRITE, they do not know the probe either
+        bool supports_write() const {
+            constexpr unsigned ops = 256;
+            // zeroed, as the kernel wants it
+            std::vector<std::uint64_t> storage((sizeof(io_uring_probe) + ops * sizeof(io_uring_probe_op) + 7) / 8);
+            auto probe = reinterpret_cast<io_uring_probe*>(storage.data());
+            if (io_uring_register(m_ring, IORING_REGISTER_PROBE, probe, ops) < 0) {
+                return false;
+            }
+            return IORING_OP_WRITE < probe->ops_len && (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+        }
+
+        void* map(std::size_t size, std::uint64_t offset) {
+            auto p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring,
+                            static_cast<off_t>(offset));
+            return p == MAP_FAILED ? nullptr : p;
+        }
+
+        void release() {
+            if (m_sqes) {
+                ::munmap(m_sqes, m_sqes_size);
+            }
+            if (m_cq && m_cq != m_sq) {
+                ::munmap(m_cq, m_cq_size);
+            }
+            if (m_sq) {
+                ::munmap(m_sq, m_sq_size);
+            }
+            if (m_ring >= 0) {
+                ::close(m_ring);
+            }
+            m_sqes = nullptr;
+            m_cq = m_sq = nullptr;
+            m_ring = -1;
+        }
+
+        // false when the kernel did not take the write, errno tells why
+        bool push(unsigned index) {
+            const auto& write = m_pending[index];
+            // only this thread moves the tail
+            auto tail = *m_sq_tail;
+            auto slot = tail & m_sq_mask;
+
+            auto& sqe = m_sqes[slot];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = m_fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+            sqe.fd = m_file;
+            sqe.off = write.offset + write.done;
+            sqe.addr = reinterpret_cast<std::uint64_t>(m_buffers + index * m_buffer_size + write.done);
+            sqe.len = static_cast<std::uint32_t>(write.length - write.done);
+            sqe.buf_index = static_cast<std::uint16_t>(index);
+            sqe.user_data = index;
+
+            m_sq_array[slot] = slot;
+            std::atomic_ref<unsigned>{*m_sq_tail}.store(tail + 1, std::memory_order_release);
+
+            while (io_uring_enter(m_ring, 1, 0, 0) < 0) {
+                if (errno != EINTR) {
+                    // the entry was not consumed, it is taken back
+                    std::atomic_ref<unsigned>{*m_sq_tail}.store(tail, std::memory_order_release);
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        int m_ring = -1;
+        int m_file;
+        bool m_fixed = false;
+        char* m_buffers;
+        std::size_t m_buffer_size;
+
+        void* m_sq = nullptr;
+        void* m_cq = nullptr;
+        io_uring_sqe* m_sqes = nullptr;
+        std::size_t m_sq_size = 0;
+        std::size_t m_cq_size = 0;
+        std::size_t m_sqes_size = 0;
+
+        unsigned* m_sq_tail = nullptr;
+        unsigned m_sq_mask = 0;
+        unsigned* m_sq_array = nullptr;
+        unsigned* m_cq_head = nullptr;
+        unsigned* m_cq_tail = nullptr;
+        unsigned m_cq_mask = 0;
+        io_uring_cqe* m_cqes = nullptr;
+
+        std::vector<pending_write> m_pending;
+        std::vector<unsigned> m_retry;
+        unsigned m_in_flight = 0;
+    };
+
+    /*
+     * Hands the buffers to a few threads that write them with pwritev. A thread takes the buffers that
+     * follow each other in the file together, so a backlog goes out in large writes.
+     */
+    class pool_engine final : public writers::uring_writer::engine {
+    public:
+        pool_engine(int file, char* buffers, std::size_t buffer_size, unsigned threads) :
+            m_file{file}, m_buffers{buffers}, m_buffer_size{buffer_size}
+        {
+            for (unsigned t = 0; t < threads; ++t) {
+                m_threads.emplace_back([this] { work(); });
+            }
+        }
+
+        pool_engine(const pool_engine&) = delete;
+        pool_engine& operator=(const pool_engine&) = delete;
+
+        // the threads write out what is queued before they stop
+        ~pool_engine() override {
+            {
+                std::lock_guard lock{m_mutex};
+                m_stop = true;
+            }
+            m_work.notify_all();
+            for (auto& t : m_threads) {
+                t.join();
+            }
+        }
+
+        void submit(unsigned index, std::size_t length, std::uint64_t offset) override {
+            {
+                std::lock_guard lock{m_mutex};
+                m_queue.push_back({index, length, offset});
+            }
+            m_work.notify_one();
+        }
+
+        int reap(std::vector<unsigned>& done, bool wait) override {
+            std::unique_lock lock{m_mutex};
+            if (wait) {
+                m_finished.wait(lock, [this] { return !m_done.empty(); });
+            }
+            done.insert(done.end(), m_done.begin(), m_done.end());
+            m_done.clear();
+            return std::exchange(m_error, 0);
+        }
+
+        bool is_io_uring() const noexcept override { return false; }
+
+    private:
+        struct job {
+            unsigned index;
+            std::size_t length;
+            std::uint64_t offset;
+        };
+
+        void work() {
+            std::vector<job> run;
+            std::vector<iovec> parts;
+            std::unique_lock lock{m_mutex};
+            for (;;) {
+                m_work.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+                if (m_queue.empty()) {
+                    return;
+                }
+
+                run.clear();
+                do {
+                    run.push_back(m_queue.front());
+                    m_queue.pop_front();
+                } while (!m_queue.empty() && run.size() < MAX_RUN &&
+                         m_queue.front().offset == run.back().offset + run.back().length);
+
+                lock.unlock();
+                auto error = write_run(run, parts);
+                lock.lock();
+
+                for (const auto& j : run) {
+                    m_done.push_back(j.index);
+                }
+                if (error && !m_error) {
+                    m_error = error;
+                }
+                m_finished.notify_one();
+            }
+        }
+
+        int write_run(const std::vector<job>& run, std::vector<iovec>& parts) const {
+            parts.clear();
+            for (const auto& j : run) {
+                parts.push_back({m_buffers + j.index * m_buffer_size, j.length});
+            }
+
+            auto offset = run.front().offset;
+            iovec* part = parts.data();
+            auto count = static_cast<int>(parts.size());
+            while (count > 0) {
+                auto written = ::pwritev(m_file, part, count, static_cast<off_t>(offset));
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return errno;
+                }
+                if (written == 0) {
+                    return EIO;
+                }
+
+                // a short write leaves the rest of the parts for the next call
+                offset += static_cast<std::uint64_t>(written);
+                auto left = static_cast<std::size_t>(written);
+                while (count > 0 && left >= part->iov_len) {
+                    left -= part->iov_len;
+                    ++part;
+                    --count;
+                }
+                if (count > 0) {
+                    part->iov_base = static_cast<char*>(part->iov_base) + left;
+                    part->iov_len -= left;
+                }
+            }
+            return 0;
+        }
+
+        int m_file;
+        char* m_buffers;
+        std::size_t m_buffer_size;
+
+        std::mutex m_mutex;
+        std::condition_variable m_work;
+        std::condition_variable m_finished;
+        std::deque<job> m_queue;
+        std::vector<unsigned> m_done;
+        int m_error = 0;
+        bool m_stop = false;
+
+        std::vector<std::thread> m_threads;
+    };
+}
+
+namespace writers {
+
+    uring_writer::uring_writer(const char* fname) : uring_writer(fname, options{}) {}
+
+    uring_writer::uring_writer(const char* fname, options opts) :
+        m_opts{opts}
+    {
+        m_opts.buffer_size = round_to_pages(m_opts.buffer_size);
+        m_opts.buffers = std::max(m_opts.buffers, 2u);
+        m_opts.fallback_threads = std::max(m_opts.fallback_threads, 1u);
+
+        // the offsets are kept here, O_APPEND would make the kernel ignore them
+        auto flags = O_WRONLY | O_CREAT | O_CLOEXEC | (m_opts.append ? 0 : O_TRUNC);
+        m_fd = ::open(fname, flags, 0644);
+        if (m_fd < 0) {
+            throw std::runtime_error(std::string{"uring_writer: cannot open "} + fname + ": " + std::strerror(errno));
+        }
+        if (m_opts.append) {
+            m_offset = static_cast<std::uint64_t>(std::max<off_t>(::lseek(m_fd, 0, SEEK_END), 0));
+        }
+
+        m_buffers.reset(static_cast<char*>(std::aligned_alloc(PAGE_SIZE, m_opts.buffer_size * m_opts.buffers)));
+        if (!m_buffers) {
+            ::close(m_fd);
+            throw std::bad_alloc();
+        }
+
+        try {
+            if (!m_opts.force_fallback) {
+                auto ring = std::make_unique<uring_engine>(m_fd, m_buffers.get(), m_opts.buffer_size, m_opts.buffers);
+                if (ring->ready()) {
+                    m_engine = std::move(ring);
+                }
+            }
+            if (!m_engine) {
+                m_engine = std::make_unique<pool_engine>(m_fd, m_buffers.get(), m_opts.buffer_size, m_opts.fallback_threads);
+            }
+        } catch (...) {
+            ::close(m_fd);
+            throw;
+        }
+
+        // buffer 0 is filled first
+        for (unsigned i = m_opts.buffers - 1; i > 0; --i) {
+            m_free.push_back(i);
+        }
+    }
+
+    uring_writer::~uring_writer() {
+        try {
+            *this << io::flush;
+        } catch (const std::runtime_error&) {
+            // nothing left to report the error to
+        }
+        // waits for the writes still in flight
+        m_engine.reset();
+        ::close(m_fd);
+    }
+
+    io::itext_writer& uring_writer::operator<<(std::string_view view) {
+        while (!view.empty()) {
+            auto part = std::min(view.size(), m_opts.buffer_size - m_used);
+            std::memcpy(current() + m_used, view.data(), part);
+            m_used += part;
+            view.remove_prefix(part);
+            if (m_used == m_opts.buffer_size) {
+                submit_current();
+            }
+        }
+        return *this;
+    }
+
+    io::itext_writer& uring_writer::operator<<(const char* string) {
+        return *this << std::string_view{string};
+    }
+
+    io::itext_writer& uring_writer::operator<<(char c) {
+        current()[m_used++] = c;
+        if (m_used == m_opts.buffer_size) {
+            submit_current();
+        }
+        return *this;
+    }
+
+    template <typename T>
+    io::itext_writer& uring_writer::format(T n) {
+        // formatted straight into the buffer, or split over the next one when it does not fit anymore
+        if (m_opts.buffer_size - m_used >= max_number_length) {
+            auto begin = current() + m_used;
+            auto [end, ec] = std::to_chars(begin, begin + max_number_length, n);
+            m_used += static_cast<std::size_t>(end - begin);
+            if (m_used == m_opts.buffer_size) {
+                submit_current();
+            }
+            return *this;
+        }
+        char temp[max_number_length];
+        auto [end, ec] = std::to_chars(temp, temp + sizeof(temp), n);
+        return uring_writer::operator<<(std::string_view{temp, static_cast<std::size_t>(end - temp)});
+    }
+
+    io::itext_writer& uring_writer::operator<<(int n) {
+        return format(n);
+    }
+
+    io::itext_writer& uring_writer::operator<<(long n) {
+        return format(n);
+    }
+
+    io::itext_writer& uring_writer::operator<<(unsigned long n) {
+        return format(n);
+    }
+
+    io::itext_writer& uring_writer::operator<<(long long n) {
+        return format(n);
+    }
+
+    io::itext_writer& uring_writer::operator<<(unsigned long long n) {
+        return format(n);
+    }
+
+    io::itext_writer& uring_writer::operator<<(double n) {
+        return format(n);
+    }
+
+    io::itext_writer& uring_writer::operator<<(io::flush_t) {
+        int error = 0;
+        if (m_used > 0) {
+            try {
+                submit_current();
+            } catch (const std::runtime_error&) {
+                error = EIO;
+            }
+        }
+        while (m_free.size() + 1 < m_opts.buffers) {
+            auto free = m_free.size();
+            if (auto failed = m_engine->reap(m_free, true)) {
+                error = failed;
+                if (m_free.size() == free) {
+                    // the engine cannot wait for the writes in flight
+                    break;
+                }
+            }
+        }
+        if (error) {
+            throw std::runtime_error(std::string{"uring_writer: write failed: "} + std::strerror(error));
+        }
+        return *this;
+    }
+
+    bool uring_writer::uses_io_uring() const noexcept {
+        return m_engine->is_io_uring();
+    }
+
+    void uring_writer::submit_current() {
+        // the next buffer is secured before this one goes out, so there is always one that is not in flight
+        auto error = m_engine->reap(m_free, false);
+        while (m_free.empty()) {
+            if (auto failed = m_engine->reap(m_free, true)) {
+                error = failed;
+                if (m_free.empty()) {
+                    // the engine cannot wait for the writes in flight, the buffer is dropped and filled again
+                    m_used = 0;
+                    throw std::runtime_error(std::string{"uring_writer: cannot wait for writes, buffer dropped: "} +
+                                             std::strerror(error));
+                }
+            }
+        }
+
+        m_engine->submit(m_current, m_used, m_offset);
+        m_offset += m_used;
+        m_used = 0;
+
+        // a failed write is reported once the next buffer is taken
+        m_current = m_free.back();
+        m_free.pop_back();
+
+        if (error) {
+            throw std::runtime_error(std::string{"uring_writer: write failed: "} + std::strerror(error));
+        }
+    }
+}
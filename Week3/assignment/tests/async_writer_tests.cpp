@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "async_writer.h"
+#include "test_writers.h"
+
+namespace {
+
+    writers::async_writer::options spilling(std::size_t max_queued_bytes) {
+        writers::async_writer::options opts;
+        opts.on_full = writers::async_writer::overflow::spill;
+        opts.max_queued_bytes = max_queued_bytes;
+        return opts;
+    }
+
+    TEST(async_writer, writes_every_record_in_order) {
+        std::string out;
+        {
+            writers::async_writer writer{std::make_unique<tests::capture_writer>(out)};
+            for (int i = 0; i < 1000; ++i) {
+                writer << "record " << i << '\n';
+            }
+        }
+
+        auto records = tests::lines(out);
+        ASSERT_EQ(records.size(), 1000u);
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_EQ(records[static_cast<std::size_t>(i)], "record " + std::to_string(i));
+        }
+    }
+
+    TEST(async_writer, spilled_records_are_replayed_in_order) {
+        std::string out;
+        metrics::spill_stats spilled;
+        {
+            writers::async_writer writer{std::make_unique<tests::capture_writer>(out, std::chrono::microseconds{200}),
+                                         spilling(64)};
+            for (int i = 0; i < 300; ++i) {
+                writer << "record " << i << '\n';
+            }
+            // nothing is spilled after the last write, the replay has to catch up with it
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{30};
+            do {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+                spilled = writer.spilled();
+            } while (spilled.replayed_records < spilled.spilled_records && std::chrono::steady_clock::now() < deadline);
+        }
+
+        ASSERT_GT(spilled.spilled_records, 0u) << "the slow sink should have made the writer spill";
+        ASSERT_EQ(spilled.replayed_records, spilled.spilled_records);
+        ASSERT_EQ(spilled.replayed_bytes, spilled.spilled_bytes);
+
+        auto records = tests::lines(out);
+        ASSERT_EQ(records.size(), 300u);
+        for (int i = 0; i < 300; ++i) {
+            ASSERT_EQ(records[static_cast<std::size_t>(i)], "record " + std::to_string(i));
+        }
+    }
+
+    // the destructor used to spill the unfinished record without a newline and never finish the replay
+    TEST(async_writer, unfinished_record_behind_a_spill_ends_the_output) {
+        std::string out;
+        {
+            writers::async_writer writer{std::make_unique<tests::capture_writer>(out, std::chrono::microseconds{200}),
+                                         spilling(64)};
+            for (int i = 0; i < 200; ++i) {
+                writer << "record " << i << '\n';
+            }
+            writer << "tail without newline";
+        }
+
+        auto records = tests::lines(out);
+        ASSERT_EQ(records.size(), 201u);
+        ASSERT_EQ(records.back(), "tail without newline");
+        ASSERT_EQ(out.back(), '\n');
+    }
+
+    TEST(async_writer, records_of_many_threads_stay_whole) {
+        constexpr int threads = 4;
+        constexpr int per_thread = 500;
+        std::string out;
+        {
+            writers::async_writer writer{std::make_unique<tests::capture_writer>(out, std::chrono::microseconds{20}),
+                                         spilling(256)};
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back([&writer, t] {
+                    for (int i = 0; i < per_thread; ++i) {
+                        // one token per record, tokens of different threads are not kept apart
+                        writer << ("T" + std::to_string(t) + " " + std::to_string(i) + "\n");
+                    }
+                });
+            }
+            for (auto& w : workers) {
+                w.join();
+            }
+        }
+
+        std::vector<int> next(threads, 0);
+        auto records = tests::lines(out);
+        ASSERT_EQ(records.size(), static_cast<std::size_t>(threads * per_thread));
+        for (const auto& record : records) {
+            auto space = record.find(' ');
+            ASSERT_NE(space, std::string::npos) << record;
+            auto t = std::stoi(record.substr(1, space - 1));
+            ASSERT_EQ(std::stoi(record.substr(space + 1)), next[static_cast<std::size_t>(t)]++) << record;
+        }
+    }
+}
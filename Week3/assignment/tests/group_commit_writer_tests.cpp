@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "group_commit_writer.h"
+#include "test_writers.h"
+
+namespace {
+
+    TEST(group_commit_writer, ack_completes_once_the_record_is_in_the_file) {
+        tests::temp_dir dir{"group_commit_ack"};
+        auto path = dir.file("audit.log");
+        writers::group_commit_writer writer{path.c_str()};
+
+        auto ack = writer.write_durable("user 42 deleted");
+        ack.wait();
+
+        ASSERT_TRUE(ack.ready());
+        ASSERT_EQ(tests::read_file(path), "user 42 deleted\n");
+        ASSERT_GE(writer.batches(), 1u);
+    }
+
+    TEST(group_commit_writer, records_of_many_threads_share_batches) {
+        constexpr int threads = 8;
+        constexpr int per_thread = 200;
+        tests::temp_dir dir{"group_commit_threads"};
+        auto path = dir.file("audit.log");
+        {
+            writers::group_commit_writer::options opts;
+            opts.window = std::chrono::microseconds{200};
+            writers::group_commit_writer writer{path.c_str(), opts};
+
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back([&writer, t] {
+                    for (int i = 0; i < per_thread; ++i) {
+                        writer.write_durable("T" + std::to_string(t) + " " + std::to_string(i)).wait();
+                    }
+                });
+            }
+            for (auto& w : workers) {
+                w.join();
+            }
+
+            ASSERT_EQ(writer.records(), static_cast<std::uint64_t>(threads * per_thread));
+            ASSERT_LT(writer.batches(), static_cast<std::uint64_t>(threads * per_thread))
+                << "the records of waiting threads should have been synced together";
+        }
+
+        std::vector<int> next(threads, 0);
+        auto records = tests::lines(tests::read_file(path));
+        ASSERT_EQ(records.size(), static_cast<std::size_t>(threads * per_thread));
+        for (const auto& record : records) {
+            auto space = record.find(' ');
+            auto t = std::stoi(record.substr(1, space - 1));
+            ASSERT_EQ(std::stoi(record.substr(space + 1)), next[static_cast<std::size_t>(t)]++) << record;
+        }
+    }
+
+    TEST(group_commit_writer, tokens_join_the_batches_once_complete) {
+        tests::temp_dir dir{"group_commit_tokens"};
+        auto path = dir.file("audit.log");
+        {
+            writers::group_commit_writer writer{path.c_str()};
+            writer << "first " << 1 << '\n' << "second";
+            writer << io::flush;
+            ASSERT_EQ(tests::read_file(path), "first 1\n");
+            writer << " record\n";
+        }
+        ASSERT_EQ(tests::read_file(path), "first 1\nsecond record\n");
+    }
+
+    // /dev/full accepts the open but fails every write with ENOSPC
+    TEST(group_commit_writer, failed_batch_fails_its_ack_and_all_later_ones) {
+        writers::group_commit_writer writer{"/dev/full"};
+
+        auto first = writer.write_durable("lost");
+        ASSERT_THROW(first.wait(), std::runtime_error);
+
+        auto second = writer.write_durable("lost as well");
+        ASSERT_THROW(second.wait(), std::runtime_error);
+        ASSERT_THROW(writer << io::flush, std::runtime_error);
+    }
+}
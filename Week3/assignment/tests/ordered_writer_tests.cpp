@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ordered_writer.h"
+#include "test_writers.h"
+
+namespace {
+
+    writers::ordered_writer::options small_rings(bool stamp_prefix = false) {
+        writers::ordered_writer::options opts;
+        opts.ring_bytes = 4096;
+        opts.stamp_prefix = stamp_prefix;
+        return opts;
+    }
+
+    TEST(ordered_writer, records_come_out_in_stamp_order) {
+        constexpr int threads = 4;
+        constexpr int per_thread = 2000;
+        std::string out;
+        std::uint64_t late;
+        {
+            writers::ordered_writer writer{std::make_unique<tests::capture_writer>(out), small_rings(true)};
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back([&writer, t] {
+                    for (int i = 0; i < per_thread; ++i) {
+                        writer << 'T' << t << ' ' << i << '\n';
+                    }
+                });
+            }
+            for (auto& w : workers) {
+                w.join();
+            }
+            late = writer.late_records();
+        }
+
+        std::vector<int> next(threads, 0);
+        std::uint64_t previous = 0;
+        std::uint64_t out_of_order = 0;
+        auto records = tests::lines(out);
+        ASSERT_EQ(records.size(), static_cast<std::size_t>(threads * per_thread));
+        for (const auto& record : records) {
+            // 16 hexadecimal digits of the stamp and a space
+            ASSERT_GT(record.size(), 17u) << record;
+            auto stamp = static_cast<std::uint64_t>(std::stoull(record.substr(0, 16), nullptr, 16));
+            out_of_order += stamp < previous;
+            previous = std::max(previous, stamp);
+
+            auto body = record.substr(17);
+            auto space = body.find(' ');
+            auto t = std::stoi(body.substr(1, space - 1));
+            ASSERT_EQ(std::stoi(body.substr(space + 1)), next[static_cast<std::size_t>(t)]++) << record;
+        }
+        // only records that missed the reorder window may be out of order, and they are counted
+        ASSERT_LE(out_of_order, late);
+    }
+
+    // a thread that exits in the middle of a record used to leave it to whichever thread got its id next
+    TEST(ordered_writer, unfinished_records_of_exited_threads_are_finished) {
+        constexpr int rounds = 20;
+        constexpr int threads = 4;
+        std::string out;
+        {
+            writers::ordered_writer writer{std::make_unique<tests::capture_writer>(out), small_rings()};
+            for (int r = 0; r < rounds; ++r) {
+                std::vector<std::thread> workers;
+                for (int t = 0; t < threads; ++t) {
+                    workers.emplace_back([&writer, r, t] {
+                        writer << "whole " << r << ' ' << t << '\n';
+                        writer << "partial " << r << ' ' << t;
+                    });
+                }
+                for (auto& w : workers) {
+                    w.join();
+                }
+            }
+        }
+
+        std::size_t whole = 0;
+        std::size_t partial = 0;
+        for (const auto& record : tests::lines(out)) {
+            // a partial record never continues in the record of another thread
+            ASSERT_EQ(record.find("partial", 1), std::string::npos) << record;
+            ASSERT_EQ(record.find("whole", 1), std::string::npos) << record;
+            whole += record.starts_with("whole");
+            partial += record.starts_with("partial");
+        }
+        ASSERT_EQ(whole, static_cast<std::size_t>(rounds * threads));
+        ASSERT_EQ(partial, static_cast<std::size_t>(rounds * threads));
+    }
+
+    TEST(ordered_writer, records_longer_than_half_a_ring_are_truncated_and_counted) {
+        std::string out;
+        std::uint64_t truncated;
+        {
+            writers::ordered_writer writer{std::make_unique<tests::capture_writer>(out), small_rings()};
+            writer << std::string(3000, 'x') << '\n' << "short\n";
+            writer << io::flush;
+            truncated = writer.truncated_records();
+        }
+
+        auto records = tests::lines(out);
+        ASSERT_EQ(truncated, 1u);
+        ASSERT_EQ(records.size(), 2u);
+        ASSERT_LT(records[0].size(), 3000u);
+        ASSERT_EQ(records[1], "short");
+    }
+}
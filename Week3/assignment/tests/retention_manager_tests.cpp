@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "retention_manager.h"
+#include "test_writers.h"
+
+namespace {
+
+    void make_file(const tests::temp_dir& dir, const std::string& name, std::size_t bytes = 100,
+                   std::chrono::hours age = std::chrono::hours{0}) {
+        std::ofstream{dir.file(name)} << std::string(bytes, 'x');
+        std::filesystem::last_write_time(dir.file(name), std::filesystem::file_time_type::clock::now() - age);
+    }
+
+    bool exists(const tests::temp_dir& dir, const std::string& name) {
+        return std::filesystem::exists(dir.file(name));
+    }
+
+    TEST(retention_manager, trims_the_oldest_closed_files) {
+        tests::temp_dir dir{"retention_trim"};
+        writers::retention_manager::policy p;
+        p.max_files = 2;
+        writers::retention_manager manager{p, dir.path().string()};
+
+        for (int i = 0; i < 5; ++i) {
+            auto name = "211018_120000." + std::to_string(i);
+            make_file(dir, name);
+            manager.add_file(dir.file(name), 100);
+        }
+        manager.sync();
+
+        ASSERT_FALSE(exists(dir, "211018_120000.0"));
+        ASSERT_FALSE(exists(dir, "211018_120000.2"));
+        ASSERT_TRUE(exists(dir, "211018_120000.3"));
+        ASSERT_TRUE(exists(dir, "211018_120000.4"));
+        auto totals = manager.stats();
+        ASSERT_EQ(totals.files, 2u);
+        ASSERT_EQ(totals.removed, 3u);
+    }
+
+    // the newest file of a logger may still be written, adopting it let trimming unlink a live file
+    TEST(retention_manager, adoption_leaves_the_newest_file_of_every_logger) {
+        tests::temp_dir dir{"retention_adopt"};
+        for (auto name : {"211018_120000.1", "211018_120000.2", "211018_120000.3",
+                          "211018_120000.1.a", "211018_120000.2.a", "211018_130000.1.gz"}) {
+            make_file(dir, name);
+        }
+
+        writers::retention_manager::policy p;
+        p.max_files = 1;
+        {
+            writers::retention_manager manager{p, dir.path().string()};
+        }
+
+        ASSERT_TRUE(exists(dir, "211018_120000.3")) << "the live file of the plain logger was removed";
+        ASSERT_TRUE(exists(dir, "211018_120000.2.a")) << "the live file of shard a was removed";
+        // of the four adopted files only the newest stays
+        auto left = 0;
+        for (auto name : {"211018_120000.1", "211018_120000.2", "211018_120000.1.a", "211018_130000.1.gz"}) {
+            left += exists(dir, name);
+        }
+        ASSERT_EQ(left, 1);
+    }
+
+    // adopted files used to be stamped with their mtime while the age was measured on the manager's clock
+    TEST(retention_manager, adopted_files_age_on_the_managers_clock) {
+        tests::temp_dir dir{"retention_age"};
+        make_file(dir, "211018_120000.1", 100, std::chrono::hours{2});
+        make_file(dir, "211018_120000.2", 100, std::chrono::hours{0});
+        make_file(dir, "211018_120000.3");
+
+        writers::retention_manager::policy p;
+        p.max_age = std::chrono::hours{1};
+        {
+            // virtual time starts at the epoch, decades before any mtime
+            writers::retention_manager manager{p, dir.path().string(), std::make_shared<global::virtual_clock>()};
+        }
+
+        ASSERT_FALSE(exists(dir, "211018_120000.1"));
+        ASSERT_TRUE(exists(dir, "211018_120000.2"));
+        ASSERT_TRUE(exists(dir, "211018_120000.3"));
+    }
+
+    TEST(retention_manager, compresses_all_but_the_newest_files) {
+        tests::temp_dir dir{"retention_compress"};
+        writers::retention_manager::policy p;
+        p.compress = true;
+        p.keep_uncompressed = 1;
+
+        std::unique_ptr<writers::retention_manager> manager;
+        try {
+            manager = std::make_unique<writers::retention_manager>(p, dir.path().string());
+        } catch (const std::runtime_error&) {
+            GTEST_SKIP() << "built without zlib";
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            auto name = "211018_120000." + std::to_string(i);
+            make_file(dir, name, 10000);
+            manager->add_file(dir.file(name), 10000);
+        }
+        manager->sync();
+
+        ASSERT_TRUE(exists(dir, "211018_120000.0.gz"));
+        ASSERT_TRUE(exists(dir, "211018_120000.1.gz"));
+        ASSERT_FALSE(exists(dir, "211018_120000.0"));
+        ASSERT_TRUE(exists(dir, "211018_120000.2"));
+        ASSERT_EQ(manager->stats().compressed, 2u);
+    }
+}
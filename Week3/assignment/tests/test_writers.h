@@ -0,0 +1,93 @@
+#ifndef LESSON_TEST_WRITERS_H
+#define LESSON_TEST_WRITERS_H
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "itext_writer.h"
+
+namespace tests {
+
+    // keeps everything written to it, optionally taking delay per token to make the writer under test fall behind
+    class capture_writer : public io::itext_writer {
+    public:
+        explicit capture_writer(std::string& out, std::chrono::microseconds delay = std::chrono::microseconds{0}) :
+            m_out{out}, m_delay{delay}
+        {}
+
+        using io::itext_writer::operator<<;
+
+        itext_writer& operator<<(std::string_view view) override {
+            if (m_delay.count() > 0) {
+                std::this_thread::sleep_for(m_delay);
+            }
+            std::lock_guard lock{m_mutex};
+            m_out.append(view);
+            return *this;
+        }
+
+        itext_writer& operator<<(const char* string) override { return *this << std::string_view{string}; }
+
+        itext_writer& operator<<(char c) override { return *this << std::string_view{&c, 1}; }
+
+        itext_writer& operator<<(int n) override { return *this << std::string_view{std::to_string(n)}; }
+
+        itext_writer& operator<<(io::flush_t) override { return *this; }
+
+    private:
+        std::string& m_out;
+        std::chrono::microseconds m_delay;
+        std::mutex m_mutex;
+    };
+
+    // a directory of its own for every test, removed with everything in it
+    class temp_dir {
+    public:
+        explicit temp_dir(std::string_view name) :
+            m_path{std::filesystem::temp_directory_path() /
+                   ("logging_tests_" + std::to_string(::getpid()) + "_" + std::string{name})}
+        {
+            std::filesystem::remove_all(m_path);
+            std::filesystem::create_directories(m_path);
+        }
+
+        temp_dir(const temp_dir&) = delete;
+        temp_dir& operator=(const temp_dir&) = delete;
+
+        ~temp_dir() {
+            std::error_code ec;
+            std::filesystem::remove_all(m_path, ec);
+        }
+
+        std::string file(std::string_view name) const { return (m_path / name).string(); }
+        const std::filesystem::path& path() const noexcept { return m_path; }
+
+    private:
+        std::filesystem::path m_path;
+    };
+
+    inline std::string read_file(const std::string& path) {
+        std::ifstream in{path, std::ios::binary};
+        std::stringstream content;
+        content << in.rdbuf();
+        return content.str();
+    }
+
+    inline std::vector<std::string> lines(const std::string& text) {
+        std::vector<std::string> result;
+        std::istringstream in{text};
+        for (std::string line; std::getline(in, line);) {
+            result.push_back(line);
+        }
+        return result;
+    }
+}
+
+#endif //LESSON_TEST_WRITERS_H
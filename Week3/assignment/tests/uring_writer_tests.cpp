@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include "uring_writer.h"
+#include "test_writers.h"
+
+namespace {
+
+    // runs every test with io_uring (where the kernel has it) and with the thread pool fallback
+    class uring_writer_test : public ::testing::TestWithParam<bool> {
+    protected:
+        writers::uring_writer::options options(bool append = false) const {
+            writers::uring_writer::options opts;
+            // small buffers, so the records span many of them
+            opts.buffer_size = 4096;
+            opts.buffers = 4;
+            opts.append = append;
+            opts.force_fallback = GetParam();
+            return opts;
+        }
+
+        tests::temp_dir m_dir{"uring_writer_" + std::string{GetParam() ? "fallback" : "ring"}};
+    };
+
+    template <typename T>
+    void expect(std::string& expected, T n) {
+        char temp[32];
+        auto [end, ec] = std::to_chars(temp, temp + sizeof(temp), n);
+        expected.append(temp, end);
+    }
+
+    TEST_P(uring_writer_test, writes_every_token_in_order) {
+        auto path = m_dir.file("out.log");
+        std::string expected;
+        {
+            writers::uring_writer writer{path.c_str(), options()};
+            ASSERT_EQ(writer.uses_io_uring() && GetParam(), false);
+            for (int i = 0; i < 20000; ++i) {
+                auto big = static_cast<long long>(i) * -1234567891011LL;
+                auto fraction = i / 7.0;
+                writer << "record " << i << ' ' << big << ' ' << fraction << ' ' << static_cast<unsigned long>(i) << '\n';
+                expected += "record ";
+                expect(expected, i);
+                expected += ' ';
+                expect(expected, big);
+                expected += ' ';
+                expect(expected, fraction);
+                expected += ' ';
+                expect(expected, static_cast<unsigned long>(i));
+                expected += '\n';
+            }
+        }
+        ASSERT_EQ(tests::read_file(path), expected);
+    }
+
+    TEST_P(uring_writer_test, flush_makes_everything_visible) {
+        auto path = m_dir.file("out.log");
+        writers::uring_writer writer{path.c_str(), options()};
+        std::string expected;
+        for (int round = 0; round < 5; ++round) {
+            auto record = "round " + std::to_string(round) + " " + std::string(5000, 'x') + "\n";
+            writer << record;
+            expected += record;
+            writer << io::flush;
+            ASSERT_EQ(tests::read_file(path), expected);
+        }
+    }
+
+    TEST_P(uring_writer_test, append_continues_at_the_end) {
+        auto path = m_dir.file("out.log");
+        {
+            writers::uring_writer writer{path.c_str(), options()};
+            writer << "first\n";
+        }
+        {
+            writers::uring_writer writer{path.c_str(), options(true)};
+            writer << "second\n";
+        }
+        ASSERT_EQ(tests::read_file(path), "first\nsecond\n");
+        {
+            writers::uring_writer writer{path.c_str(), options(false)};
+            writer << "third\n";
+        }
+        ASSERT_EQ(tests::read_file(path), "third\n");
+    }
+
+    INSTANTIATE_TEST_SUITE_P(engines, uring_writer_test, ::testing::Values(false, true),
+                             [](const auto& info) { return info.param ? "fallback" : "io_uring"; });
+
+    // the builder opens every file type the same way, stream_writer truncates
+    TEST(uring_writer, truncates_by_default) {
+        tests::temp_dir dir{"uring_writer_default"};
+        auto path = dir.file("out.log");
+        for (auto record : {"first\n", "second\n"}) {
+            writers::uring_writer writer{path.c_str()};
+            writer << record;
+        }
+        ASSERT_EQ(tests::read_file(path), "second\n");
+    }
+}
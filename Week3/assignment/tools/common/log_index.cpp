@@ -0,0 +1,257 @@
+#include "log_index.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <span>
+#include <tuple>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "clib/logger.h"
+
+namespace {
+    constexpr std::size_t PREFIX_LENGTH = 13; // yymmdd_HHMMSS
+
+    bool all_digits(std::string_view text) {
+        return !text.empty() && std::all_of(text.cbegin(), text.cend(), [](unsigned char c) { return std::isdigit(c); });
+    }
+
+    std::string index_path(const std::string& path) {
+        return path + ".idx";
+    }
+
+    std::optional<std::time_t> make_time(int year, int month, int day, int hour, int minute, int second) {
+        std::tm tm{};
+        tm.tm_year = year - 1900;
+        tm.tm_mon = month - 1;
+        tm.tm_mday = day;
+        tm.tm_hour = hour;
+        tm.tm_min = minute;
+        tm.tm_sec = second;
+        tm.tm_isdst = -1;
+        auto result = std::mktime(&tm);
+        if (result == static_cast<std::time_t>(-1)) {
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    // the whole sidecar index of a log file, empty when there is none
+    class index_view {
+    public:
+        explicit index_view(const std::string& log_path) {
+            int fd = ::open(index_path(log_path).c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+            struct stat st{};
+            if (::fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(lg_index_entry_t))) {
+                m_length = static_cast<std::size_t>(st.st_size);
+                m_addr = ::mmap(nullptr, m_length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (m_addr == MAP_FAILED) {
+                    m_addr = nullptr;
+                }
+            }
+            ::close(fd);
+        }
+
+        index_view(const index_view&) = delete;
+        index_view& operator=(const index_view&) = delete;
+
+        ~index_view() {
+            if (m_addr) {
+                ::munmap(m_addr, m_length);
+            }
+        }
+
+        std::span<const lg_index_entry_t> entries() const noexcept {
+            if (!m_addr) {
+                return {};
+            }
+            return {static_cast<const lg_index_entry_t*>(m_addr), m_length / sizeof(lg_index_entry_t)};
+        }
+
+    private:
+        void* m_addr = nullptr;
+        std::size_t m_length = 0;
+    };
+}
+
+namespace logtools {
+
+    bool parse_rolled_name(std::string_view name, rolled_file& file) {
+        if (name.size() < PREFIX_LENGTH + 2 || name[6] != '_' || name[PREFIX_LENGTH] != '.') {
+            return false;
+        }
+        auto date = name.substr(0, 6);
+        auto time = name.substr(7, 6);
+        auto count = name.substr(PREFIX_LENGTH + 1);
+        std::string_view shard;
+        if (auto dot = count.find('.'); dot != std::string_view::npos) {
+            shard = count.substr(dot + 1);
+            count = count.substr(0, dot);
+            // the sidecar indexes and compressed files are no shards
+            if (shard.empty() || shard == "idx" || shard == "gz" || shard.find('.') != std::string_view::npos) {
+                return false;
+            }
+        }
+        if (!all_digits(date) || !all_digits(time) || !all_digits(count)) {
+            return false;
+        }
+        file.prefix = std::string{name.substr(0, PREFIX_LENGTH)};
+        file.count = std::stoul(std::string{count});
+        file.shard = std::string{shard};
+        return true;
+    }
+
+    std::vector<rolled_file> find_rolled_files(const std::string& directory) {
+        std::vector<rolled_file> files;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+            rolled_file file{};
+            if (entry.is_regular_file(ec) && parse_rolled_name(entry.path().filename().string(), file)) {
+                file.path = entry.path().string();
+                files.push_back(std::move(file));
+            }
+        }
+
+        std::sort(files.begin(), files.end(), [](const rolled_file& a, const rolled_file& b) {
+            return std::tie(a.prefix, a.shard, a.count) < std::tie(b.prefix, b.shard, b.count);
+        });
+        return files;
+    }
+
+    std::optional<std::time_t> first_indexed_time(const std::string& path) {
+        std::FILE* file = std::fopen(index_path(path).c_str(), "rb");
+        if (!file) {
+            return std::nullopt;
+        }
+        lg_index_entry_t entry{};
+        auto read = std::fread(&entry, sizeof(entry), 1, file);
+        std::fclose(file);
+        if (read != 1) {
+            return std::nullopt;
+        }
+        return static_cast<std::time_t>(entry.time);
+    }
+
+    std::vector<index_entry> read_index(const std::string& path) {
+        index_view index{path};
+        std::vector<index_entry> entries;
+        for (const auto& e : index.entries()) {
+            entries.push_back({static_cast<std::time_t>(e.time), static_cast<std::size_t>(e.offset)});
+        }
+        return entries;
+    }
+
+    byte_range time_range(const std::string& path, std::size_t file_size, std::time_t from, std::time_t to) {
+        index_view index{path};
+        auto entries = index.entries();
+        if (entries.empty()) {
+            return {0, file_size};
+        }
+
+        // records before the last entry older than from cannot be newer than from
+        auto first_not_before = std::partition_point(entries.begin(), entries.end(),
+                                                     [from](const lg_index_entry_t& e) { return e.time < from; });
+        std::size_t begin = (first_not_before == entries.begin()) ? 0 : std::prev(first_not_before)->offset;
+
+        // records from the first entry newer than to onwards are all newer than to
+        auto first_after = std::partition_point(entries.begin(), entries.end(),
+                                                [to](const lg_index_entry_t& e) { return e.time <= to; });
+        std::size_t end = (first_after == entries.end()) ? file_size : first_after->offset;
+
+        end = std::min(end, file_size);
+        begin = std::min(begin, end);
+        return {begin, end};
+    }
+
+    std::optional<std::time_t> parse_time(std::string_view text) {
+        std::string str{text};
+        int year, month, day, hour, minute, second = 0;
+        char tail;
+
+        if (!str.empty() && str.front() == '@' && all_digits(text.substr(1))) {
+            return static_cast<std::time_t>(std::stoll(str.substr(1)));
+        }
+
+        if (str.size() == PREFIX_LENGTH && str[6] == '_' && all_digits(text.substr(0, 6)) && all_digits(text.substr(7))) {
+            std::sscanf(str.c_str(), "%2d%2d%2d_%2d%2d%2d", &year, &month, &day, &hour, &minute, &second);
+            return make_time(2000 + year, month, day, hour, minute, second);
+        }
+
+        if (std::sscanf(str.c_str(), "%d-%d-%d%*1[ T]%d:%d:%d%c", &year, &month, &day, &hour, &minute, &second, &tail) == 6
+            || std::sscanf(str.c_str(), "%d-%d-%d%*1[ T]%d:%d%c", &year, &month, &day, &hour, &minute, &tail) == 5) {
+            return make_time(year, month, day, hour, minute, second);
+        }
+
+        if (std::sscanf(str.c_str(), "%d:%d:%d%c", &hour, &minute, &second, &tail) == 3
+            || std::sscanf(str.c_str(), "%d:%d%c", &hour, &minute, &tail) == 2) {
+            auto now = std::time(nullptr);
+            std::tm today{};
+            localtime_r(&now, &today);
+            return make_time(today.tm_year + 1900, today.tm_mon + 1, today.tm_mday, hour, minute, second);
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<std::size_t> file_size(const std::string& path) {
+        struct stat st{};
+        if (::stat(path.c_str(), &st) != 0) {
+            return std::nullopt;
+        }
+        return static_cast<std::size_t>(st.st_size);
+    }
+
+    mapped_range::mapped_range(const std::string& path, byte_range range) {
+        if (range.end <= range.begin) {
+            return;
+        }
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+
+        // mappings have to start at a page boundary
+        auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        auto offset = range.begin / page * page;
+        m_skip = range.begin - offset;
+        m_length = range.end - offset;
+
+        m_addr = ::mmap(nullptr, m_length, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(offset));
+        ::close(fd);
+        if (m_addr == MAP_FAILED) {
+            m_addr = nullptr;
+            m_length = 0;
+            m_skip = 0;
+            return;
+        }
+        ::madvise(m_addr, m_length, MADV_SEQUENTIAL);
+    }
+
+    mapped_range::mapped_range(mapped_range&& other) noexcept :
+        m_addr{other.m_addr}, m_length{other.m_length}, m_skip{other.m_skip}
+    {
+        other.m_addr = nullptr;
+        other.m_length = 0;
+        other.m_skip = 0;
+    }
+
+    mapped_range::~mapped_range() {
+        if (m_addr) {
+            ::munmap(m_addr, m_length);
+        }
+    }
+
+    std::string_view mapped_range::view() const noexcept {
+        if (!m_addr) {
+            return {};
+        }
+        return {static_cast<const char*>(m_addr) + m_skip, m_length - m_skip};
+    }
+}
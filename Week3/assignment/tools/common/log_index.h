@@ -0,0 +1,83 @@
+#ifndef LESSON_LOG_INDEX_H
+#define LESSON_LOG_INDEX_H
+
+#include <cstddef>
+#include <ctime>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace logtools {
+
+    // a file rolled by lg_logger, named yymmdd_HHMMSS.N, or yymmdd_HHMMSS.N.SHARD by one created with lg_create_shard
+    struct rolled_file {
+        std::string path;
+        std::string prefix;
+        std::size_t count;
+        std::string shard;
+    };
+
+    struct byte_range {
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    // when the record at offset was logged, from a sidecar index
+    struct index_entry {
+        std::time_t time;
+        std::size_t offset;
+    };
+
+    // all rolled files in directory, each logger's (prefix and shard) files in roll order
+    std::vector<rolled_file> find_rolled_files(const std::string& directory);
+
+    // true when name looks like a file rolled by lg_logger
+    bool parse_rolled_name(std::string_view name, rolled_file& file);
+
+    // true when both files were written by the same lg_logger
+    inline bool same_logger(const rolled_file& a, const rolled_file& b) {
+        return !a.prefix.empty() && a.prefix == b.prefix && a.shard == b.shard;
+    }
+
+    // first time stamp recorded in the sidecar index of path, if there is one
+    std::optional<std::time_t> first_indexed_time(const std::string& path);
+
+    // all entries of the sidecar index of path, ordered by offset; empty when there is none
+    std::vector<index_entry> read_index(const std::string& path);
+
+    /*
+     * The part of a log file of size file_size that may hold records logged within [from, to],
+     * computed from its sidecar index. Without an index the whole file is returned.
+     * The range is empty (begin == end) when the file cannot hold such records.
+     */
+    byte_range time_range(const std::string& path, std::size_t file_size, std::time_t from, std::time_t to);
+
+    /*
+     * Accepts "HH:MM[:SS]" (today, local time), "yymmdd_HHMMSS" (the rolled file names),
+     * "YYYY-MM-DD HH:MM[:SS]" or "@SECONDS_SINCE_EPOCH".
+     */
+    std::optional<std::time_t> parse_time(std::string_view text);
+
+    // read-only mapping of [begin, end) of a file
+    class mapped_range {
+    public:
+        mapped_range(const std::string& path, byte_range range);
+        mapped_range(mapped_range&& other) noexcept;
+        mapped_range(const mapped_range&) = delete;
+        mapped_range& operator=(const mapped_range&) = delete;
+        mapped_range& operator=(mapped_range&&) = delete;
+        ~mapped_range();
+
+        std::string_view view() const noexcept;
+
+    private:
+        void* m_addr = nullptr;
+        std::size_t m_length = 0;
+        std::size_t m_skip = 0;
+    };
+
+    std::optional<std::size_t> file_size(const std::string& path);
+}
+
+#endif //LESSON_LOG_INDEX_H
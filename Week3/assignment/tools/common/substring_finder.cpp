@@ -0,0 +1,114 @@
+#include "substring_finder.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   define LOGTOOLS_X86_SIMD 1
+#   include <immintrin.h>
+#else
+#   define LOGTOOLS_X86_SIMD 0
+#endif
+
+namespace {
+
+    std::size_t find_scalar(std::string_view haystack, std::string_view needle) noexcept {
+        return haystack.find(needle);
+    }
+
+#if LOGTOOLS_X86_SIMD
+
+    std::size_t find_tail(std::string_view haystack, std::string_view needle, std::size_t from) noexcept {
+        auto found = haystack.substr(from).find(needle);
+        return found == std::string_view::npos ? found : from + found;
+    }
+
+    bool matches_at(const char* candidate, std::string_view needle) noexcept {
+        // the first and the last byte are already known to match
+        return std::memcmp(candidate + 1, needle.data() + 1, needle.size() - 2) == 0;
+    }
+
+    std::size_t find_sse2(std::string_view haystack, std::string_view needle) noexcept {
+        const auto n = needle.size();
+        if (n < 2 || haystack.size() < n) {
+            return haystack.find(needle);
+        }
+
+        const auto first = _mm_set1_epi8(needle.front());
+        const auto last = _mm_set1_epi8(needle.back());
+        const char* data = haystack.data();
+
+        std::size_t i = 0;
+        for (; i + n - 1 + 16 <= haystack.size(); i += 16) {
+            auto block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            auto block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + n - 1));
+            auto eq = _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last));
+
+            auto mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+            while (mask) {
+                auto bit = static_cast<std::size_t>(__builtin_ctz(mask));
+                if (matches_at(data + i + bit, needle)) {
+                    return i + bit;
+                }
+                mask &= mask - 1;
+            }
+        }
+        return find_tail(haystack, needle, i);
+    }
+
+    __attribute__((target("avx2")))
+    std::size_t find_avx2(std::string_view haystack, std::string_view needle) noexcept {
+        const auto n = needle.size();
+        if (n < 2 || haystack.size() < n) {
+            return haystack.find(needle);
+        }
+
+        const auto first = _mm256_set1_epi8(needle.front());
+        const auto last = _mm256_set1_epi8(needle.back());
+        const char* data = haystack.data();
+
+        std::size_t i = 0;
+        for (; i + n - 1 + 32 <= haystack.size(); i += 32) {
+            auto block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            auto block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + n - 1));
+            auto eq = _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last));
+
+            auto mask = static_cast<unsigned>(_mm256_movemask_epi8(eq));
+            while (mask) {
+                auto bit = static_cast<std::size_t>(__builtin_ctz(mask));
+                if (matches_at(data + i + bit, needle)) {
+                    return i + bit;
+                }
+                mask &= mask - 1;
+            }
+        }
+        return find_tail(haystack, needle, i);
+    }
+
+#endif
+}
+
+namespace logtools {
+
+    substring_finder::substring_finder(std::string_view needle) :
+        m_needle{needle}, m_find{find_scalar}, m_name{"scalar"}
+    {
+#if LOGTOOLS_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            m_find = find_avx2;
+            m_name = "avx2";
+        } else if (__builtin_cpu_supports("sse2")) {
+            m_find = find_sse2;
+            m_name = "sse2";
+        }
+#endif
+    }
+
+    std::size_t substring_finder::find(std::string_view haystack) const noexcept {
+        return m_find(haystack, m_needle);
+    }
+
+    const char* substring_finder::implementation() const noexcept {
+        return m_name;
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef LESSON_SUBSTRING_FINDER_H
+#define LESSON_SUBSTRING_FINDER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace logtools {
+
+    /*
+     * Fixed-string search picking the widest SIMD implementation the CPU supports at run time
+     * (AVX2, SSE2, or a portable fallback). Candidates are found by comparing the first and the last
+     * byte of the needle over a whole register and verified with memcmp.
+     */
+    class substring_finder {
+    public:
+        explicit substring_finder(std::string_view needle);
+
+        // offset of the first occurrence of the needle in haystack or npos
+        std::size_t find(std::string_view haystack) const noexcept;
+
+        const char* implementation() const noexcept;
+
+        static constexpr std::size_t npos = std::string_view::npos;
+
+    private:
+        using find_fn = std::size_t (*)(std::string_view, std::string_view) noexcept;
+
+        std::string m_needle;
+        find_fn m_find;
+        const char* m_name;
+    };
+}
+
+#endif //LESSON_SUBSTRING_FINDER_H
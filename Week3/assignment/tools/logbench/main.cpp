@@ -0,0 +1,304 @@
+//
+// logbench - measures how fast the file writers take records. Every writer writes the same records
+// to a fresh file in DIRECTORY, once as whole records (one token per record, the way lib::logger
+// writes them) and once as a mix of small string and number tokens. The time includes the final
+// flush and closing the file; the best of ROUNDS runs is reported.
+// With -t the records are also logged through lib::logger by 1, 2, 4 ... THREADS threads, once into one
+// shared fd_writer behind a multi_writer and once into a sharded_file_writer with a file per thread.
+// With -s the records are fanned out to 1, 2, 4 ... SINKS async sinks behind one multi_writer, once
+// sharing one pooled copy of every record and once with a copy per sink.
+//
+
+#include "async_writer.h"
+#include "fd_writer.h"
+#include "file_writer_adapter.h"
+#include "logger.h"
+#include "multi_writer.h"
+#include "shared_record.h"
+#include "sharded_file_writer.h"
+#include "stream_writer.h"
+#include "uring_writer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+    struct config {
+        long records = 1000000;
+        int rounds = 3;
+        std::string directory = "/tmp";
+        bool dsync = false;
+        unsigned threads = 0;
+        unsigned sinks = 0;
+    };
+
+    struct candidate {
+        const char* name;
+        std::function<std::unique_ptr<io::itext_writer>(const std::string&)> make;
+    };
+
+    using workload = void (*)(io::itext_writer&, long);
+
+    void whole_records(io::itext_writer& out, long records) {
+        std::string record;
+        for (long i = 0; i < records; ++i) {
+            record = "2021-09-06 12:00:00 worker request " + std::to_string(i) + " handled, status ok, took 125 us\n";
+            out << std::string_view{record};
+        }
+    }
+
+    void mixed_tokens(io::itext_writer& out, long records) {
+        for (long i = 0; i < records; ++i) {
+            out << "request id=" << i << " bytes=" << static_cast<std::size_t>(i * 37 % 65536)
+                << " ratio=" << static_cast<double>(i % 1000) / 7.0 << " ok=" << (i % 3 != 0) << '\n';
+        }
+    }
+
+    bool parse_args(int argc, char** argv, config& cfg) {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg{argv[i]};
+            if (arg == "-n" && i + 1 < argc) {
+                cfg.records = std::strtol(argv[++i], nullptr, 10);
+            } else if (arg == "-r" && i + 1 < argc) {
+                cfg.rounds = std::atoi(argv[++i]);
+            } else if (arg == "-d" && i + 1 < argc) {
+                cfg.directory = argv[++i];
+            } else if (arg == "--dsync") {
+                cfg.dsync = true;
+            } else if (arg == "-t" && i + 1 < argc) {
+                cfg.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            } else if (arg == "-s" && i + 1 < argc) {
+                cfg.sinks = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            } else {
+                return false;
+            }
+        }
+        return cfg.records > 0 && cfg.rounds > 0;
+    }
+
+    // throws the records away, so the fan-out itself is measured
+    class discard_writer : public io::itext_writer {
+    public:
+        using io::itext_writer::operator<<;
+
+        virtual itext_writer& operator<<(std::string_view) override { return *this; }
+        virtual itext_writer& operator<<(const char*) override { return *this; }
+        virtual itext_writer& operator<<(char) override { return *this; }
+        virtual itext_writer& operator<<(int) override { return *this; }
+        virtual itext_writer& operator<<(io::flush_t) override { return *this; }
+    };
+
+    // hides that the writer keeps shared records, so multi_writer hands it the bytes and it copies them
+    class copying_sink : public io::itext_writer {
+    public:
+        explicit copying_sink(std::unique_ptr<io::itext_writer> inner) : m_inner{std::move(inner)} {}
+
+        using io::itext_writer::operator<<;
+
+        virtual itext_writer& operator<<(std::string_view view) override { *m_inner << view; return *this; }
+        virtual itext_writer& operator<<(const char* string) override { *m_inner << string; return *this; }
+        virtual itext_writer& operator<<(char c) override { *m_inner << c; return *this; }
+        virtual itext_writer& operator<<(int n) override { *m_inner << n; return *this; }
+        virtual itext_writer& operator<<(io::flush_t flush) override { *m_inner << flush; return *this; }
+
+    private:
+        std::unique_ptr<io::itext_writer> m_inner;
+    };
+
+    // seconds taken by the best round and the size of the file written
+    std::pair<double, long> run(const candidate& c, workload work, const config& cfg) {
+        auto path = cfg.directory + "/logbench." + std::to_string(::getpid());
+        double best = 1e300;
+        long size = 0;
+
+        for (int round = 0; round < cfg.rounds; ++round) {
+            ::unlink(path.c_str());
+            auto t0 = std::chrono::steady_clock::now();
+            {
+                auto writer = c.make(path);
+                work(*writer, cfg.records);
+                *writer << io::flush;
+            }
+            auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            best = std::min(best, elapsed);
+
+            if (auto file = std::fopen(path.c_str(), "rb")) {
+                std::fseek(file, 0, SEEK_END);
+                size = std::ftell(file);
+                std::fclose(file);
+            }
+        }
+        ::unlink(path.c_str());
+        return {best, size};
+    }
+
+    // seconds the best round takes to log cfg.records records from threads threads
+    double run_threads(bool sharded, unsigned threads, const config& cfg) {
+        // lg_logger names its files in the working directory, every round gets a fresh one
+        auto directory = std::filesystem::path{cfg.directory} / ("logbench." + std::to_string(::getpid()));
+        auto previous = std::filesystem::current_path();
+        auto per_thread = cfg.records / threads;
+        double best = 1e300;
+
+        for (int round = 0; round < cfg.rounds; ++round) {
+            std::filesystem::create_directories(directory);
+            std::filesystem::current_path(directory);
+
+            std::unique_ptr<io::itext_writer> writer;
+            if (sharded) {
+                writer = std::make_unique<writers::sharded_file_writer>(std::chrono::hours{1});
+            } else {
+                auto shared = std::make_unique<writers::multi_writer>();
+                shared->add_writer("file", std::make_unique<writers::fd_writer>("logbench.log",
+                                                                                writers::fd_writer::options{.append = false}));
+                writer = std::move(shared);
+            }
+
+            auto t0 = std::chrono::steady_clock::now();
+            {
+                lib::logger logger{std::move(writer)};
+                std::vector<std::jthread> workers;
+                for (unsigned t = 0; t < threads; ++t) {
+                    workers.emplace_back([&logger, per_thread, t] {
+                        std::string record;
+                        for (long i = 0; i < per_thread; ++i) {
+                            record.assign("worker ").append(std::to_string(t)).append(" request ")
+                                  .append(std::to_string(i)).append(" handled, status ok");
+                            logger.log(record);
+                        }
+                    });
+                }
+            }
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+
+            std::filesystem::current_path(previous);
+            std::filesystem::remove_all(directory);
+        }
+        return best;
+    }
+
+    // seconds the best round takes to log cfg.records records into sinks async sinks, and the record
+    // bytes copied into pooled buffers per record
+    std::pair<double, double> run_fan_out(bool shared, unsigned sinks, const config& cfg) {
+        double best = 1e300;
+        double copied = 0;
+
+        for (int round = 0; round < cfg.rounds; ++round) {
+            auto fan_out = std::make_unique<writers::multi_writer>();
+            for (unsigned s = 0; s < sinks; ++s) {
+                writers::async_writer::options queueing{};
+                queueing.on_full = writers::async_writer::overflow::block;
+                std::unique_ptr<io::itext_writer> sink =
+                    std::make_unique<writers::async_writer>(std::make_unique<discard_writer>(), queueing);
+                if (!shared) {
+                    sink = std::make_unique<copying_sink>(std::move(sink));
+                }
+                fan_out->add_writer("sink" + std::to_string(s), std::move(sink));
+            }
+
+            auto before = io::record_pool::get_instance().stats().bytes;
+            auto t0 = std::chrono::steady_clock::now();
+            {
+                lib::logger logger{std::move(fan_out)};
+                std::string record;
+                for (long i = 0; i < cfg.records; ++i) {
+                    record.assign("2021-09-06 12:00:00 worker request ").append(std::to_string(i))
+                          .append(" handled, status ok, took 125 us");
+                    logger.log(record);
+                }
+            }
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+            copied = static_cast<double>(io::record_pool::get_instance().stats().bytes - before) /
+                     static_cast<double>(cfg.records);
+        }
+        return {best, copied};
+    }
+}
+
+int main(int argc, char** argv) {
+    config cfg{};
+    if (!parse_args(argc, argv, cfg)) {
+        std::fprintf(stderr, "usage: %s [-n RECORDS] [-r ROUNDS] [-d DIRECTORY] [--dsync] [-t THREADS] [-s SINKS]\n"
+                             "  --dsync adds an fd_writer opened with O_DSYNC (use fewer records)\n"
+                             "  -t compares one shared file with a file per thread for up to THREADS threads\n"
+                             "  -s compares shared records with a copy per sink for up to SINKS async sinks\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<candidate> candidates{
+        {"stream_writer", [](const std::string& path) { return std::make_unique<writers::stream_writer>(path.c_str()); }},
+        {"file_writer_adapter", [](const std::string& path) { return std::make_unique<writers::file_writer_adapter>(path.c_str()); }},
+        {"fd_writer", [](const std::string& path) {
+            return std::make_unique<writers::fd_writer>(path.c_str(), writers::fd_writer::options{.append = false});
+        }},
+        {"uring_writer", [](const std::string& path) {
+            return std::make_unique<writers::uring_writer>(path.c_str(), writers::uring_writer::options{.append = false});
+        }},
+        {"uring_writer(pwritev)", [](const std::string& path) {
+            return std::make_unique<writers::uring_writer>(path.c_str(),
+                                                           writers::uring_writer::options{.append = false, .force_fallback = true});
+        }},
+    };
+    if (cfg.dsync) {
+        candidates.push_back({"fd_writer+O_DSYNC", [](const std::string& path) {
+            return std::make_unique<writers::fd_writer>(path.c_str(), writers::fd_writer::options{.append = false, .dsync = true});
+        }});
+    }
+
+    std::pair<const char*, workload> workloads[] = {{"records", whole_records}, {"tokens", mixed_tokens}};
+
+    std::printf("%ld records, best of %d rounds, files in %s\n", cfg.records, cfg.rounds, cfg.directory.c_str());
+    std::printf("%-8s %-22s %12s %10s %10s\n", "workload", "writer", "ns/record", "MB/s", "bytes");
+    for (const auto& [workload_name, work] : workloads) {
+        for (const auto& c : candidates) {
+            auto [seconds, size] = run(c, work, cfg);
+            std::printf("%-8s %-22s %12.1f %10.1f %10ld\n", workload_name, c.name,
+                        seconds * 1e9 / static_cast<double>(cfg.records),
+                        static_cast<double>(size) / seconds / 1e6, size);
+        }
+    }
+
+    if (cfg.threads) {
+        std::printf("\n%-8s %-22s %12s %10s\n", "threads", "writer", "records/s", "speedup");
+        double base[2]{};
+        for (unsigned threads = 1;; threads = std::min(threads * 2, cfg.threads)) {
+            for (bool sharded : {false, true}) {
+                auto rate = static_cast<double>(cfg.records / threads * threads) / run_threads(sharded, threads, cfg);
+                if (threads == 1) {
+                    base[sharded] = rate;
+                }
+                std::printf("%-8u %-22s %12.0f %10.2f\n", threads, sharded ? "sharded_file_writer" : "multi_writer+fd_writer",
+                            rate, rate / base[sharded]);
+            }
+            if (threads == cfg.threads) {
+                break;
+            }
+        }
+    }
+
+    if (cfg.sinks) {
+        std::printf("\n%-8s %-22s %12s %14s\n", "sinks", "records", "ns/record", "copied/record");
+        for (unsigned sinks = 1;; sinks = std::min(sinks * 2, cfg.sinks)) {
+            for (bool shared : {true, false}) {
+                auto [seconds, copied] = run_fan_out(shared, sinks, cfg);
+                std::printf("%-8u %-22s %12.1f %14.1f\n", sinks, shared ? "shared" : "copy per sink",
+                            seconds * 1e9 / static_cast<double>(cfg.records), copied);
+            }
+            if (sinks == cfg.sinks) {
+                break;
+            }
+        }
+    }
+    return EXIT_SUCCESS;
+}
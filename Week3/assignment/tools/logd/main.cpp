@@ -0,0 +1,264 @@
+//
+// logd - collects newline-terminated records sent by writers::socket_writer (or pushed into a
+// shared-memory ring by writers::shm_ring_writer) from many processes and merges them into
+// a single set of rolling files written by lg_logger.
+//
+
+#include <ctime>
+#include "clib/logger.h"
+#include "shm/shm_ring.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <string_view>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+    volatile std::sig_atomic_t g_running = 1;
+
+    void on_signal(int) {
+        g_running = 0;
+    }
+
+    struct config {
+        const char* socket_path = nullptr;
+        const char* ring_name = nullptr;
+        const char* directory = nullptr;
+        bool datagram = false;
+        time_t interval_s = 3600;
+        std::size_t slots = shm::ring::default_capacity;
+        std::size_t slot_size = shm::ring::default_slot_size;
+    };
+
+    void usage(const char* self) {
+        std::fprintf(stderr,
+                     "usage: %s [--stream|--datagram] [--interval SECONDS] [--dir DIRECTORY] SOCKET_PATH\n"
+                     "       %s --shm RING_NAME [--slots N] [--slot-size BYTES] [--interval SECONDS] [--dir DIRECTORY]\n",
+                     self, self);
+    }
+
+    bool parse_args(int argc, char** argv, config& cfg) {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg{argv[i]};
+            if (arg == "--stream") {
+                cfg.datagram = false;
+            } else if (arg == "--datagram") {
+                cfg.datagram = true;
+            } else if (arg == "--interval" && i + 1 < argc) {
+                cfg.interval_s = std::strtol(argv[++i], nullptr, 10);
+            } else if (arg == "--dir" && i + 1 < argc) {
+                cfg.directory = argv[++i];
+            } else if (arg == "--shm" && i + 1 < argc) {
+                cfg.ring_name = argv[++i];
+            } else if (arg == "--slots" && i + 1 < argc) {
+                cfg.slots = std::strtoul(argv[++i], nullptr, 10);
+            } else if (arg == "--slot-size" && i + 1 < argc) {
+                cfg.slot_size = std::strtoul(argv[++i], nullptr, 10);
+            } else if (!arg.empty() && arg[0] != '-' && !cfg.socket_path) {
+                cfg.socket_path = argv[i];
+            } else {
+                return false;
+            }
+        }
+        return (!cfg.socket_path != !cfg.ring_name) && cfg.interval_s > 0;
+    }
+
+    // writes every complete line of pending to the log and keeps the incomplete tail
+    void drain_lines(lg_logger_t* log, std::string& pending) {
+        std::size_t start = 0;
+        std::size_t end;
+        while ((end = pending.find('\n', start)) != std::string::npos) {
+            pending[end] = '\0';
+            lg_log(log, &pending[start]);
+            start = end + 1;
+        }
+        pending.erase(0, start);
+    }
+
+    void flush_tail(lg_logger_t* log, std::string& pending) {
+        if (!pending.empty() && pending.back() != '\n') {
+            pending.push_back('\n');
+        }
+        drain_lines(log, pending);
+    }
+
+    void serve_ring(const config& cfg, lg_logger_t* log) {
+        shm::ring ring{cfg.ring_name, cfg.slots, cfg.slot_size};
+        std::string record;
+        record.reserve(ring.max_record_size() + 1);
+
+        auto write_record = [&](std::string_view view) {
+            record.assign(view);
+            lg_log(log, record.c_str());
+        };
+
+        while (g_running) {
+            if (ring.drain(write_record) == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+        }
+        ring.drain(write_record);
+
+        auto stats = ring.stats();
+        std::fprintf(stderr, "logd: ring %s dropped=%llu truncated=%llu abandoned=%llu\n", cfg.ring_name,
+                     static_cast<unsigned long long>(stats.dropped),
+                     static_cast<unsigned long long>(stats.truncated),
+                     static_cast<unsigned long long>(stats.abandoned));
+    }
+
+    int open_socket(const config& cfg) {
+        sockaddr_un addr{};
+        if (std::strlen(cfg.socket_path) >= sizeof(addr.sun_path)) {
+            std::fprintf(stderr, "logd: socket path is too long\n");
+            return -1;
+        }
+        addr.sun_family = AF_UNIX;
+        std::strcpy(&addr.sun_path[0], cfg.socket_path);
+
+        int fd = ::socket(AF_UNIX, (cfg.datagram ? SOCK_DGRAM : SOCK_STREAM) | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            std::perror("logd: socket");
+            return -1;
+        }
+
+        ::unlink(cfg.socket_path);
+        if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0
+            || (!cfg.datagram && ::listen(fd, SOMAXCONN) != 0)) {
+            std::perror("logd: bind");
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    void serve_datagrams(int fd, lg_logger_t* log) {
+        std::vector<char> buffer(256 * 1024);
+        std::string pending;
+
+        while (g_running) {
+            pollfd pfd{fd, POLLIN, 0};
+            if (::poll(&pfd, 1, 500) <= 0) {
+                continue;
+            }
+            auto n = ::recv(fd, buffer.data(), buffer.size(), 0);
+            if (n <= 0) {
+                continue;
+            }
+            // every datagram carries whole records, a missing final newline is restored
+            pending.assign(buffer.data(), static_cast<std::size_t>(n));
+            flush_tail(log, pending);
+        }
+    }
+
+    void serve_streams(int listener, lg_logger_t* log) {
+        std::vector<pollfd> fds{{listener, POLLIN, 0}};
+        // pending[i] holds the incomplete last line received on fds[i]
+        std::vector<std::string> pending(1);
+        std::vector<char> buffer(64 * 1024);
+
+        while (g_running) {
+            if (::poll(fds.data(), fds.size(), 500) <= 0) {
+                continue;
+            }
+
+            for (std::size_t i = 1; i < fds.size(); ++i) {
+                if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                    continue;
+                }
+                auto n = ::recv(fds[i].fd, buffer.data(), buffer.size(), 0);
+                if (n > 0) {
+                    pending[i].append(buffer.data(), static_cast<std::size_t>(n));
+                    drain_lines(log, pending[i]);
+                } else if (n == 0 || (errno != EINTR && errno != EAGAIN)) {
+                    flush_tail(log, pending[i]);
+                    ::close(fds[i].fd);
+                    fds[i].fd = -1;
+                }
+            }
+
+            // forget the closed connections
+            for (std::size_t i = fds.size(); i-- > 1;) {
+                if (fds[i].fd < 0) {
+                    fds.erase(fds.begin() + static_cast<long>(i));
+                    pending.erase(pending.begin() + static_cast<long>(i));
+                }
+            }
+
+            if (fds[0].revents & POLLIN) {
+                int client = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+                if (client >= 0) {
+                    fds.push_back({client, POLLIN, 0});
+                    pending.emplace_back();
+                }
+            }
+        }
+
+        for (std::size_t i = 1; i < fds.size(); ++i) {
+            flush_tail(log, pending[i]);
+            ::close(fds[i].fd);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    config cfg{};
+    if (!parse_args(argc, argv, cfg)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (cfg.directory && ::chdir(cfg.directory) != 0) {
+        std::perror("logd: chdir");
+        return EXIT_FAILURE;
+    }
+
+    struct sigaction sa{};
+    sa.sa_handler = on_signal;
+    ::sigaction(SIGINT, &sa, nullptr);
+    ::sigaction(SIGTERM, &sa, nullptr);
+
+    lg_logger_t* log{nullptr};
+    if (lg_create(&log, cfg.interval_s) != lgr_ok) {
+        std::fprintf(stderr, "logd: cannot create the rolling log\n");
+        return EXIT_FAILURE;
+    }
+
+    if (cfg.ring_name) {
+        int status = EXIT_SUCCESS;
+        try {
+            serve_ring(cfg, log);
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "logd: %s\n", e.what());
+            status = EXIT_FAILURE;
+        }
+        lg_destroy(&log);
+        return status;
+    }
+
+    int fd = open_socket(cfg);
+    if (fd < 0) {
+        lg_destroy(&log);
+        return EXIT_FAILURE;
+    }
+
+    if (cfg.datagram) {
+        serve_datagrams(fd, log);
+    } else {
+        serve_streams(fd, log);
+    }
+
+    lg_destroy(&log);
+    ::close(fd);
+    ::unlink(cfg.socket_path);
+    return EXIT_SUCCESS;
+}
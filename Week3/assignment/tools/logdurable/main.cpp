@@ -0,0 +1,183 @@
+//
+// logdurable - measures the durable group commit of lib::durable_logger for several batch windows.
+// THREADS threads each log RECORDS records and wait for every one of them to be synced before they log
+// the next; then COROUTINES coroutines on a single thread do the same with co_await. For every window
+// the throughput, the number of fdatasync calls and the commit latency percentiles are printed.
+// Run it in a directory on the disk of interest, on tmpfs fdatasync costs nothing.
+//
+
+#include "durable_logger.h"
+#include "metrics/latency_histogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+    using clock_type = std::chrono::steady_clock;
+
+    struct config {
+        unsigned threads = 8;
+        unsigned coroutines = 256;
+        long records = 500;
+        std::string directory = ".";
+        std::vector<long> windows_us{0, 200, 1000, 5000};
+    };
+
+    struct result {
+        double seconds = 0;
+        long records = 0;
+        std::uint64_t batches = 0;
+        metrics::histogram_snapshot latency;
+    };
+
+    // starts running right away and frees itself when done
+    struct detached_task {
+        struct promise_type {
+            detached_task get_return_object() noexcept { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept { std::terminate(); }
+        };
+    };
+
+    detached_task durable_client(const lib::durable_logger& logger, unsigned id, long records,
+                                 metrics::latency_histogram& latency, std::atomic<long>& running) {
+        std::string record;
+        for (long i = 0; i < records; ++i) {
+            record = "audit client " + std::to_string(id) + " action " + std::to_string(i);
+            auto t0 = clock_type::now();
+            co_await logger.log_durable(record);
+            latency.record(clock_type::now() - t0);
+        }
+        if (running.fetch_sub(1) == 1) {
+            running.notify_all();
+        }
+    }
+
+    result run_threads(const std::string& path, writers::group_commit_writer::options opts, const config& cfg) {
+        metrics::latency_histogram latency;
+        result r{};
+        auto t0 = clock_type::now();
+        {
+            lib::durable_logger logger{path.c_str(), opts};
+            {
+                std::vector<std::jthread> threads;
+                for (unsigned t = 0; t < cfg.threads; ++t) {
+                    threads.emplace_back([&, t] {
+                        std::string record;
+                        for (long i = 0; i < cfg.records; ++i) {
+                            record = "audit thread " + std::to_string(t) + " action " + std::to_string(i);
+                            auto start = clock_type::now();
+                            logger.log_durable(record).wait();
+                            latency.record(clock_type::now() - start);
+                        }
+                    });
+                }
+            }
+            r.seconds = std::chrono::duration<double>(clock_type::now() - t0).count();
+            r.records = static_cast<long>(logger.writer().records());
+            r.batches = logger.writer().batches();
+        }
+        r.latency = latency.snapshot();
+        return r;
+    }
+
+    result run_coroutines(const std::string& path, writers::group_commit_writer::options opts, const config& cfg) {
+        metrics::latency_histogram latency;
+        result r{};
+        auto t0 = clock_type::now();
+        {
+            lib::durable_logger logger{path.c_str(), opts};
+            std::atomic<long> running{static_cast<long>(cfg.coroutines)};
+            for (unsigned c = 0; c < cfg.coroutines; ++c) {
+                durable_client(logger, c, cfg.records, latency, running);
+            }
+            for (auto left = running.load(); left > 0; left = running.load()) {
+                running.wait(left);
+            }
+            r.seconds = std::chrono::duration<double>(clock_type::now() - t0).count();
+            r.records = static_cast<long>(logger.writer().records());
+            r.batches = logger.writer().batches();
+        }
+        r.latency = latency.snapshot();
+        return r;
+    }
+
+    void print(const char* mode, long window_us, const result& r) {
+        std::printf("%-10s %9ld %12.0f %9llu %10.1f %10.1f %10.1f\n", mode, window_us,
+                    static_cast<double>(r.records) / r.seconds,
+                    static_cast<unsigned long long>(r.batches),
+                    r.batches ? static_cast<double>(r.records) / static_cast<double>(r.batches) : 0.0,
+                    static_cast<double>(r.latency.percentile(50)) / 1e3,
+                    static_cast<double>(r.latency.percentile(99)) / 1e3);
+    }
+
+    bool parse_args(int argc, char** argv, config& cfg) {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg{argv[i]};
+            if (arg == "-t" && i + 1 < argc) {
+                cfg.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            } else if (arg == "-c" && i + 1 < argc) {
+                cfg.coroutines = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            } else if (arg == "-n" && i + 1 < argc) {
+                cfg.records = std::strtol(argv[++i], nullptr, 10);
+            } else if (arg == "-d" && i + 1 < argc) {
+                cfg.directory = argv[++i];
+            } else if (arg == "-w" && i + 1 < argc) {
+                cfg.windows_us.clear();
+                for (char* next = argv[++i]; *next;) {
+                    cfg.windows_us.push_back(std::strtol(next, &next, 10));
+                    if (*next == ',') {
+                        ++next;
+                    } else if (*next) {
+                        return false;
+                    }
+                }
+            } else {
+                return false;
+            }
+        }
+        return cfg.records > 0 && !cfg.windows_us.empty();
+    }
+}
+
+int main(int argc, char** argv) {
+    config cfg{};
+    if (!parse_args(argc, argv, cfg)) {
+        std::fprintf(stderr, "usage: %s [-t THREADS] [-c COROUTINES] [-n RECORDS_EACH] [-d DIRECTORY] [-w US,US,...]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    auto path = cfg.directory + "/logdurable." + std::to_string(::getpid());
+    std::printf("%u threads and %u coroutines, %ld records each, file %s\n",
+                cfg.threads, cfg.coroutines, cfg.records, path.c_str());
+    std::printf("%-10s %9s %12s %9s %10s %10s %10s\n",
+                "mode", "window_us", "records/s", "syncs", "rec/sync", "p50_us", "p99_us");
+
+    for (auto window : cfg.windows_us) {
+        writers::group_commit_writer::options opts{};
+        opts.window = std::chrono::microseconds{window};
+
+        if (cfg.threads) {
+            print("threads", window, run_threads(path, opts, cfg));
+            ::unlink(path.c_str());
+        }
+        if (cfg.coroutines) {
+            print("coroutines", window, run_coroutines(path, opts, cfg));
+            ::unlink(path.c_str());
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,46 @@
+#!/usr/bin/env bash
+#
+# Compares loggrep with grep -F on generated log data.
+# usage: bench.sh LOGGREP_BINARY [MEGABYTES] [WORK_DIRECTORY]
+#
+set -euo pipefail
+
+loggrep=${1:?usage: bench.sh LOGGREP_BINARY [MEGABYTES] [WORK_DIRECTORY]}
+megabytes=${2:-1024}
+workdir=${3:-$(mktemp -d)}
+
+mkdir -p "$workdir"
+data="$workdir/240101_000000.0"
+
+if [[ ! -f "$data" ]]; then
+    echo "generating ${megabytes} MB of log lines in $data"
+    awk -v limit=$((megabytes * 1024 * 1024)) 'BEGIN {
+        srand(42)
+        split("Starting Running Quitting Connected Timeout Retrying Flushed", words, " ")
+        bytes = 0
+        for (i = 0; bytes < limit; ++i) {
+            line = sprintf("[%d.%09d] worker-%02d %s: request %d took %d us", i / 1000, (i % 1000) * 1000000,
+                           i % 16, words[1 + int(rand() * 7)], i, int(rand() * 100000))
+            if (i % 100003 == 0) line = line " needle-in-the-haystack"
+            print line
+            bytes += length(line) + 1
+        }
+    }' > "$data"
+fi
+
+# warm the page cache so both tools read from memory
+cat "$data" > /dev/null
+# grep stops at the first match when its output is /dev/null, so both tools write to a file
+out="$workdir/matches"
+
+for pattern in needle-in-the-haystack Timeout; do
+    echo "pattern: $pattern"
+    printf '  grep -F  : '
+    { time -p grep -F "$pattern" "$data" > "$out"; } 2>&1 | awk '/real/ { print $2 " s" }'
+    printf '  loggrep : '
+    { time -p "$loggrep" "$pattern" "$data" > "$out"; } 2>&1 | awk '/real/ { print $2 " s" }'
+    if [[ "$(grep -F -c "$pattern" "$data")" != "$("$loggrep" -c "$pattern" "$data")" ]]; then
+        echo "  MISMATCH between grep and loggrep" >&2
+        exit 1
+    fi
+done
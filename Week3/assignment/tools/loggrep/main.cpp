@@ -0,0 +1,214 @@
+//
+// loggrep - prints the lines of log files that contain a fixed string.
+// The files are mapped, split into chunks at line boundaries and searched on all cores,
+// the matches are printed in file order. With --from/--to only the byte ranges selected by the
+// sidecar time indexes of rolled files are searched.
+//
+
+#include "log_index.h"
+#include "substring_finder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    constexpr std::size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+    struct config {
+        std::string pattern;
+        std::vector<std::string> files;
+        std::string directory = ".";
+        std::time_t from = 0;
+        std::time_t to = 0;
+        bool has_from = false;
+        bool has_to = false;
+        bool count_only = false;
+        bool verbose = false;
+        unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    };
+
+    struct chunk {
+        std::string_view text;
+        std::vector<std::string_view> lines;
+        std::size_t count = 0;
+        std::atomic<bool> done{false};
+    };
+
+    void usage(const char* self) {
+        std::fprintf(stderr,
+                     "usage: %s [-c] [-v] [-j THREADS] [--from TIME --to TIME] [--dir DIRECTORY] PATTERN [FILE...]\n"
+                     "  without FILEs all files rolled by lg_logger in DIRECTORY (default .) are searched\n"
+                     "  TIME is HH:MM[:SS] (today), yymmdd_HHMMSS, \"YYYY-MM-DD HH:MM[:SS]\" or @EPOCH_SECONDS\n",
+                     self);
+    }
+
+    bool parse_time_arg(const char* text, std::time_t& time, bool& has_time) {
+        auto parsed = logtools::parse_time(text);
+        if (!parsed) {
+            std::fprintf(stderr, "loggrep: cannot parse time '%s'\n", text);
+            return false;
+        }
+        time = *parsed;
+        has_time = true;
+        return true;
+    }
+
+    bool parse_args(int argc, char** argv, config& cfg) {
+        bool has_pattern = false;
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg{argv[i]};
+            if (arg == "-c") {
+                cfg.count_only = true;
+            } else if (arg == "-v") {
+                cfg.verbose = true;
+            } else if (arg == "-j" && i + 1 < argc) {
+                cfg.threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+            } else if (arg == "--from" && i + 1 < argc) {
+                if (!parse_time_arg(argv[++i], cfg.from, cfg.has_from)) return false;
+            } else if (arg == "--to" && i + 1 < argc) {
+                if (!parse_time_arg(argv[++i], cfg.to, cfg.has_to)) return false;
+            } else if (arg == "--dir" && i + 1 < argc) {
+                cfg.directory = argv[++i];
+            } else if (arg == "--") {
+                if (i + 1 < argc && !has_pattern) {
+                    cfg.pattern = argv[++i];
+                    has_pattern = true;
+                }
+            } else if (!arg.empty() && arg[0] == '-') {
+                return false;
+            } else if (!has_pattern) {
+                cfg.pattern = arg;
+                has_pattern = true;
+            } else {
+                cfg.files.emplace_back(arg);
+            }
+        }
+        return has_pattern && !cfg.pattern.empty() && (cfg.has_from == cfg.has_to);
+    }
+
+    // splits text into pieces of about CHUNK_SIZE bytes that end at a newline
+    void split_chunks(std::string_view text, std::vector<std::string_view>& pieces) {
+        while (!text.empty()) {
+            auto end = text.size();
+            if (end > CHUNK_SIZE) {
+                auto newline = text.find('\n', CHUNK_SIZE);
+                end = (newline == std::string_view::npos) ? text.size() : newline + 1;
+            }
+            pieces.push_back(text.substr(0, end));
+            text.remove_prefix(end);
+        }
+    }
+
+    void search_chunk(const logtools::substring_finder& finder, chunk& c, bool count_only) {
+        auto text = c.text;
+        std::size_t pos = 0;
+
+        while (pos < text.size()) {
+            auto found = finder.find(text.substr(pos));
+            if (found == logtools::substring_finder::npos) {
+                break;
+            }
+            found += pos;
+
+            auto line_begin = text.rfind('\n', found);
+            line_begin = (line_begin == std::string_view::npos) ? 0 : line_begin + 1;
+            auto line_end = text.find('\n', found);
+            line_end = (line_end == std::string_view::npos) ? text.size() : line_end + 1;
+
+            ++c.count;
+            if (!count_only) {
+                c.lines.push_back(text.substr(line_begin, line_end - line_begin));
+            }
+            // one line is reported once, no matter how many matches it has
+            pos = line_end;
+        }
+
+        c.done.store(true, std::memory_order_release);
+        c.done.notify_one();
+    }
+}
+
+int main(int argc, char** argv) {
+    config cfg{};
+    if (!parse_args(argc, argv, cfg)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<logtools::rolled_file> files;
+    if (cfg.files.empty()) {
+        files = logtools::find_rolled_files(cfg.directory);
+    } else {
+        for (const auto& path : cfg.files) {
+            files.push_back({path, {}, 0, {}});
+        }
+    }
+
+    std::vector<logtools::mapped_range> mappings;
+    std::vector<std::string_view> pieces;
+    for (const auto& file : files) {
+        auto size = logtools::file_size(file.path);
+        if (!size) {
+            std::fprintf(stderr, "loggrep: cannot read %s\n", file.path.c_str());
+            continue;
+        }
+
+        logtools::byte_range range{0, *size};
+        if (cfg.has_from) {
+            range = logtools::time_range(file.path, *size, cfg.from, cfg.to);
+        }
+
+        mappings.emplace_back(file.path, range);
+        split_chunks(mappings.back().view(), pieces);
+    }
+
+    logtools::substring_finder finder{cfg.pattern};
+    if (cfg.verbose) {
+        std::fprintf(stderr, "loggrep: %zu files, %zu chunks, %u threads, %s search\n",
+                     mappings.size(), pieces.size(), cfg.threads, finder.implementation());
+    }
+
+    std::vector<chunk> chunks(pieces.size());
+    for (std::size_t i = 0; i < pieces.size(); ++i) {
+        chunks[i].text = pieces[i];
+    }
+
+    std::atomic<std::size_t> next{0};
+    std::vector<std::jthread> workers;
+    auto n_workers = std::min<std::size_t>(cfg.threads, chunks.size());
+    for (std::size_t t = 0; t < n_workers; ++t) {
+        workers.emplace_back([&] {
+            std::size_t i;
+            while ((i = next.fetch_add(1, std::memory_order_relaxed)) < chunks.size()) {
+                search_chunk(finder, chunks[i], cfg.count_only);
+            }
+        });
+    }
+
+    // chunks are handed out in order, so the output streams while the workers are still busy
+    std::size_t total = 0;
+    for (auto& c : chunks) {
+        c.done.wait(false, std::memory_order_acquire);
+        total += c.count;
+        for (auto line : c.lines) {
+            std::fwrite(line.data(), 1, line.size(), stdout);
+            if (line.back() != '\n') {
+                std::fputc('\n', stdout);
+            }
+        }
+        c.lines = {};
+    }
+
+    if (cfg.count_only) {
+        std::printf("%zu\n", total);
+    }
+
+    return total ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,272 @@
+//
+// logmerge - combines the shards written by sharded_file_writer (or any logs whose records start with a
+// 16 digit hexadecimal time stamp and a space) into one file in time order. Every shard is mapped and
+// read sequentially, a heap always picks the oldest record among the heads of the shards; the records of
+// one shard keep their order. A shard is all files of one lg_logger, read in roll order.
+//
+
+#include "log_index.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+    constexpr std::size_t STAMP_DIGITS = 16;
+    constexpr std::size_t OUTPUT_BUFFER = 1024 * 1024;
+
+    struct config {
+        std::vector<std::string> files;
+        std::string directory = ".";
+        std::string output;
+        bool strip = false;
+        bool verbose = false;
+    };
+
+    // the files of one shard, read record by record
+    class shard_reader {
+    public:
+        explicit shard_reader(std::vector<std::string> paths) : m_paths{std::move(paths)} {
+            next_file();
+        }
+
+        std::uint64_t stamp() const noexcept { return m_stamp; }
+        // the current record with its newline
+        std::string_view record() const noexcept { return m_record; }
+
+        void advance() {
+            m_record = {};
+            while (m_current.empty() && m_next_path < m_paths.size()) {
+                next_file();
+            }
+            if (m_current.empty()) {
+                return;
+            }
+
+            auto newline = m_current.find('\n');
+            auto end = newline == std::string_view::npos ? m_current.size() : newline + 1;
+            m_record = m_current.substr(0, end);
+            m_current.remove_prefix(end);
+
+            // records without a stamp (e.g. continuation lines) stay behind the previous one
+            std::uint64_t stamp;
+            if (m_record.size() > STAMP_DIGITS && m_record[STAMP_DIGITS] == ' ') {
+                auto [ptr, ec] = std::from_chars(m_record.data(), m_record.data() + STAMP_DIGITS, stamp, 16);
+                if (ec == std::errc{} && ptr == m_record.data() + STAMP_DIGITS) {
+                    m_stamp = stamp;
+                }
+            }
+        }
+
+    private:
+        void next_file() {
+            const auto& path = m_paths[m_next_path++];
+            auto size = logtools::file_size(path);
+            if (!size) {
+                std::fprintf(stderr, "logmerge: cannot read %s\n", path.c_str());
+                return;
+            }
+            m_mapping.emplace_back(path, logtools::byte_range{0, *size});
+            m_current = m_mapping.back().view();
+        }
+
+        std::vector<std::string> m_paths;
+        std::size_t m_next_path = 0;
+        // all mappings are kept until the end, the output buffer may still point into them
+        std::vector<logtools::mapped_range> m_mapping;
+        std::string_view m_current;
+        std::string_view m_record;
+        std::uint64_t m_stamp = 0;
+    };
+
+    struct heap_entry {
+        std::uint64_t stamp;
+        std::size_t shard;
+
+        // the heap functions keep the largest element first, the merge needs the oldest record
+        bool operator<(const heap_entry& other) const noexcept {
+            return stamp != other.stamp ? stamp > other.stamp : shard > other.shard;
+        }
+    };
+
+    class output {
+    public:
+        explicit output(int fd) : m_fd{fd} {
+            m_buffer.reserve(OUTPUT_BUFFER);
+        }
+
+        ~output() {
+            flush();
+        }
+
+        void write(std::string_view data) {
+            if (m_buffer.size() + data.size() > OUTPUT_BUFFER) {
+                flush();
+            }
+            m_buffer.append(data);
+            m_bytes += data.size();
+        }
+
+        void flush() {
+            std::size_t done = 0;
+            while (done < m_buffer.size()) {
+                auto written = ::write(m_fd, m_buffer.data() + done, m_buffer.size() - done);
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    std::fprintf(stderr, "logmerge: write failed: %s\n", std::strerror(errno));
+                    std::exit(EXIT_FAILURE);
+                }
+                done += static_cast<std::size_t>(written);
+            }
+            m_buffer.clear();
+        }
+
+        std::size_t bytes() const noexcept { return m_bytes; }
+
+    private:
+        int m_fd;
+        std::string m_buffer;
+        std::size_t m_bytes = 0;
+    };
+
+    void usage(const char* self) {
+        std::fprintf(stderr,
+                     "usage: %s [-o OUTPUT] [--strip] [-v] [--dir DIRECTORY] [FILE...]\n"
+                     "  without FILEs the sharded files rolled by lg_logger in DIRECTORY (default .) are merged,\n"
+                     "  every FILE is a shard of its own\n"
+                     "  --strip leaves the time stamps out of the output\n",
+                     self);
+    }
+
+    bool parse_args(int argc, char** argv, config& cfg) {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg{argv[i]};
+            if (arg == "-o" && i + 1 < argc) {
+                cfg.output = argv[++i];
+            } else if (arg == "--strip") {
+                cfg.strip = true;
+            } else if (arg == "-v") {
+                cfg.verbose = true;
+            } else if (arg == "--dir" && i + 1 < argc) {
+                cfg.directory = argv[++i];
+            } else if (!arg.empty() && arg[0] != '-') {
+                cfg.files.emplace_back(arg);
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<std::vector<std::string>> find_shards(const config& cfg) {
+        std::vector<std::vector<std::string>> shards;
+        if (!cfg.files.empty()) {
+            for (const auto& path : cfg.files) {
+                shards.push_back({path});
+            }
+            return shards;
+        }
+
+        auto files = logtools::find_rolled_files(cfg.directory);
+        for (std::size_t i = 0; i < files.size(); ++i) {
+            if (files[i].shard.empty()) {
+                continue;
+            }
+            if (i == 0 || !logtools::same_logger(files[i - 1], files[i])) {
+                shards.emplace_back();
+            }
+            shards.back().push_back(files[i].path);
+        }
+        return shards;
+    }
+}
+
+int main(int argc, char** argv) {
+    config cfg{};
+    if (!parse_args(argc, argv, cfg)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<shard_reader> readers;
+    for (auto& paths : find_shards(cfg)) {
+        readers.emplace_back(std::move(paths));
+    }
+    if (readers.empty()) {
+        std::fprintf(stderr, "logmerge: no shards found\n");
+        return EXIT_FAILURE;
+    }
+
+    int fd = STDOUT_FILENO;
+    if (!cfg.output.empty()) {
+        fd = ::open(cfg.output.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            std::fprintf(stderr, "logmerge: cannot open %s: %s\n", cfg.output.c_str(), std::strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::size_t records = 0;
+    std::size_t bytes = 0;
+    {
+        output out{fd};
+        std::vector<heap_entry> heap;
+        for (std::size_t i = 0; i < readers.size(); ++i) {
+            readers[i].advance();
+            if (!readers[i].record().empty()) {
+                heap.push_back({readers[i].stamp(), i});
+            }
+        }
+        std::make_heap(heap.begin(), heap.end());
+
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end());
+            auto& reader = readers[heap.back().shard];
+
+            auto record = reader.record();
+            if (cfg.strip && record.size() > STAMP_DIGITS && record[STAMP_DIGITS] == ' ') {
+                record.remove_prefix(STAMP_DIGITS + 1);
+            }
+            out.write(record);
+            if (record.back() != '\n') {
+                out.write("\n");
+            }
+            ++records;
+
+            reader.advance();
+            if (reader.record().empty()) {
+                heap.pop_back();
+            } else {
+                heap.back().stamp = reader.stamp();
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+        bytes = out.bytes();
+    }
+
+    if (fd != STDOUT_FILENO) {
+        ::close(fd);
+    }
+
+    if (cfg.verbose) {
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::fprintf(stderr, "logmerge: %zu shards, %zu records, %zu bytes in %.3f s (%.1f MB/s)\n",
+                     readers.size(), records, bytes, seconds, static_cast<double>(bytes) / seconds / 1e6);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+//
+// logquery - prints the records logged between two points in time from the files rolled by lg_logger.
+// Only the byte ranges selected by the sidecar time indexes are mapped and read, the output is exact up
+// to the index granularity (records at most one index interval outside of the range may be printed).
+//
+
+#include "log_index.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+    struct config {
+        std::time_t from = 0;
+        std::time_t to = 0;
+        bool has_from = false;
+        bool has_to = false;
+        std::string directory = ".";
+        std::vector<std::string> files;
+        bool list_only = false;
+    };
+
+    void usage(const char* self) {
+        std::fprintf(stderr,
+                     "usage: %s --from TIME --to TIME [--dir DIRECTORY] [--ranges] [FILE...]\n"
+                     "  TIME is HH:MM[:SS] (today), yymmdd_HHMMSS, \"YYYY-MM-DD HH:MM[:SS]\" or @EPOCH_SECONDS\n"
+                     "  --ranges prints the selected byte ranges instead of the records\n",
+                     self);
+    }
+
+    bool parse_args(int argc, char** argv, config& cfg) {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg{argv[i]};
+            if ((arg == "--from" || arg == "--to") && i + 1 < argc) {
+                auto time = logtools::parse_time(argv[++i]);
+                if (!time) {
+                    std::fprintf(stderr, "logquery: cannot parse time '%s'\n", argv[i]);
+                    return false;
+                }
+                if (arg == "--from") {
+                    cfg.from = *time;
+                    cfg.has_from = true;
+                } else {
+                    cfg.to = *time;
+                    cfg.has_to = true;
+                }
+            } else if (arg == "--dir" && i + 1 < argc) {
+                cfg.directory = argv[++i];
+            } else if (arg == "--ranges") {
+                cfg.list_only = true;
+            } else if (!arg.empty() && arg[0] != '-') {
+                cfg.files.emplace_back(arg);
+            } else {
+                return false;
+            }
+        }
+        return cfg.has_from && cfg.has_to && cfg.from <= cfg.to;
+    }
+
+    std::vector<logtools::rolled_file> selected_files(const config& cfg) {
+        if (cfg.files.empty()) {
+            return logtools::find_rolled_files(cfg.directory);
+        }
+
+        std::vector<logtools::rolled_file> files;
+        for (const auto& path : cfg.files) {
+            files.push_back({path, {}, 0, {}});
+        }
+        return files;
+    }
+}
+
+int main(int argc, char** argv) {
+    config cfg{};
+    if (!parse_args(argc, argv, cfg)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto files = selected_files(cfg);
+
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        const auto& file = files[i];
+
+        // a file is complete once the next one of the same logger has been started
+        if (i + 1 < files.size() && logtools::same_logger(file, files[i + 1])) {
+            auto next_start = logtools::first_indexed_time(files[i + 1].path);
+            if (next_start && *next_start < cfg.from) {
+                continue;
+            }
+        }
+
+        auto size = logtools::file_size(file.path);
+        if (!size) {
+            std::fprintf(stderr, "logquery: cannot read %s\n", file.path.c_str());
+            continue;
+        }
+
+        auto range = logtools::time_range(file.path, *size, cfg.from, cfg.to);
+        if (range.begin == range.end) {
+            continue;
+        }
+
+        if (cfg.list_only) {
+            std::printf("%s %zu %zu\n", file.path.c_str(), range.begin, range.end);
+            continue;
+        }
+
+        logtools::mapped_range mapped{file.path, range};
+        auto records = mapped.view();
+        std::fwrite(records.data(), 1, records.size(), stdout);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,442 @@
+//
+// logreplay - replays the records of existing logs through a logger put together with logger_builder,
+// so sinks and decorators can be judged on the real message mix instead of synthetic records.
+// The records keep their original spacing, scaled by --speed, or go out as fast as possible with
+// --speed 0. The time of a record is taken from its prefix (the 16 hexadecimal digits of
+// sharded_file_writer and ordered_writer, "[seconds.nanoseconds] " of the running time decorator or
+// "[HH:MM:SS] " of the time stamp decorator) or else from the sidecar index of a rolled file; records
+// that share a time are spread evenly up to the next one. The prefix is not replayed.
+// Shards of one log are best merged with logmerge first, files are replayed one after the other.
+//
+
+#include "log_index.h"
+
+#include "builders/logger_builder.h"
+#include "fd_writer.h"
+#include "metrics/latency_histogram.h"
+#include "metrics/stats.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr std::int64_t NO_TIME = INT64_MIN;
+    constexpr std::int64_t NS_PER_SECOND = 1'000'000'000;
+    constexpr std::string_view STATS_NAME = "logreplay";
+
+    using pipeline_step = std::function<void(builders::ilogger_builder&)>;
+
+    struct config {
+        std::vector<std::string> files;
+        std::string directory;
+        // 1 keeps the original timing, 2 replays twice as fast, 0 as fast as possible
+        double speed = 1.0;
+        unsigned threads = 1;
+        long limit = 0;
+        bool keep_prefix = false;
+        // applied to the builder in the order given, like the builder calls they stand for
+        std::vector<pipeline_step> pipeline;
+        bool has_sink = false;
+    };
+
+    struct record {
+        std::int64_t time;
+        std::string_view text;
+    };
+
+    // counts what it is given and throws it away, measures the pipeline in front of the sinks
+    class null_writer : public io::itext_writer {
+    public:
+        using io::itext_writer::operator<<;
+
+        virtual itext_writer& operator<<(std::string_view) override { return *this; }
+        virtual itext_writer& operator<<(const char*) override { return *this; }
+        virtual itext_writer& operator<<(char) override { return *this; }
+        virtual itext_writer& operator<<(int) override { return *this; }
+        virtual itext_writer& operator<<(io::flush_t) override { return *this; }
+    };
+
+    template<typename T>
+    bool parse_number(std::string_view text, T& value) {
+        auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return ec == std::errc{} && ptr == text.data() + text.size();
+    }
+
+    // the time in a record's prefix and the record without it
+    struct prefix_parser {
+        // [HH:MM:SS] only knows the time of day
+        std::int64_t day = 0;
+        std::int64_t last_second_of_day = -1;
+
+        std::int64_t parse(std::string_view& line) {
+            // 16 hexadecimal digits of nanoseconds and a space
+            if (line.size() > 16 && line[16] == ' ') {
+                std::uint64_t stamp;
+                auto [ptr, ec] = std::from_chars(line.data(), line.data() + 16, stamp, 16);
+                if (ec == std::errc{} && ptr == line.data() + 16) {
+                    line.remove_prefix(17);
+                    return static_cast<std::int64_t>(stamp);
+                }
+            }
+            if (line.empty() || line[0] != '[') {
+                return NO_TIME;
+            }
+            auto close = line.find("] ");
+            if (close == std::string_view::npos) {
+                return NO_TIME;
+            }
+            auto inside = line.substr(1, close - 1);
+
+            // [seconds.nanoseconds]
+            if (auto dot = inside.find('.'); dot != std::string_view::npos && inside.size() - dot - 1 == 9) {
+                std::int64_t seconds, nanoseconds;
+                if (parse_number(inside.substr(0, dot), seconds) && parse_number(inside.substr(dot + 1), nanoseconds)) {
+                    line.remove_prefix(close + 2);
+                    return seconds * NS_PER_SECOND + nanoseconds;
+                }
+                return NO_TIME;
+            }
+
+            // [HH:MM:SS]
+            int hours, minutes, seconds;
+            if (inside.size() == 8 && inside[2] == ':' && inside[5] == ':' &&
+                parse_number(inside.substr(0, 2), hours) && parse_number(inside.substr(3, 2), minutes) &&
+                parse_number(inside.substr(6, 2), seconds)) {
+                std::int64_t second_of_day = hours * 3600 + minutes * 60 + seconds;
+                if (second_of_day < last_second_of_day) {
+                    ++day;
+                }
+                last_second_of_day = second_of_day;
+                line.remove_prefix(close + 2);
+                return (day * 86400 + second_of_day) * NS_PER_SECOND;
+            }
+            return NO_TIME;
+        }
+    };
+
+    void load(const std::string& path, const config& cfg, std::vector<logtools::mapped_range>& mappings,
+              std::vector<record>& records) {
+        auto size = logtools::file_size(path);
+        if (!size) {
+            std::fprintf(stderr, "logreplay: cannot read %s\n", path.c_str());
+            return;
+        }
+        mappings.emplace_back(path, logtools::byte_range{0, *size});
+        auto text = mappings.back().view();
+
+        auto index = logtools::read_index(path);
+        std::size_t next_entry = 0;
+        std::int64_t indexed_time = NO_TIME;
+        prefix_parser prefixes;
+
+        std::size_t offset = 0;
+        while (offset < text.size() && (cfg.limit == 0 || records.size() < static_cast<std::size_t>(cfg.limit))) {
+            auto newline = text.find('\n', offset);
+            auto end = newline == std::string_view::npos ? text.size() : newline;
+            auto line = text.substr(offset, end - offset);
+
+            while (next_entry < index.size() && index[next_entry].offset <= offset) {
+                indexed_time = static_cast<std::int64_t>(index[next_entry++].time) * NS_PER_SECOND;
+            }
+            auto stripped = line;
+            auto time = prefixes.parse(stripped);
+            records.push_back({time != NO_TIME ? time : indexed_time, cfg.keep_prefix ? line : stripped});
+
+            offset = end + 1;
+        }
+    }
+
+    // replay times relative to the first record, never going back; false when no record has a time
+    bool schedule(std::vector<record>& records) {
+        auto first = std::find_if(records.begin(), records.end(), [](const record& r) { return r.time != NO_TIME; });
+        if (first == records.end()) {
+            return false;
+        }
+
+        auto base = first->time;
+        std::int64_t previous = 0;
+        for (auto& r : records) {
+            r.time = r.time == NO_TIME ? previous : std::max(r.time - base, previous);
+            previous = r.time;
+        }
+
+        // records that share a time (e.g. the seconds of an index) are spread up to the next one
+        for (std::size_t i = 0; i < records.size();) {
+            auto j = i + 1;
+            while (j < records.size() && records[j].time == records[i].time) {
+                ++j;
+            }
+            auto span = j < records.size() ? std::min(records[j].time - records[i].time, NS_PER_SECOND) : 0;
+            auto run = static_cast<std::int64_t>(j - i);
+            for (auto k = i; k < j; ++k) {
+                records[k].time += span * static_cast<std::int64_t>(k - i) / run;
+            }
+            i = j;
+        }
+        return true;
+    }
+
+    bool parse_sink_type(std::string_view name, builders::ilogger_builder::file_output_type& type) {
+        using file_output_type = builders::ilogger_builder::file_output_type;
+        if (name == "stream") {
+            type = file_output_type::stream;
+        } else if (name == "fd") {
+            type = file_output_type::fd;
+        } else if (name == "fd_dsync") {
+            type = file_output_type::fd_dsync;
+        } else if (name == "uring") {
+            type = file_output_type::uring;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool parse_args(int argc, char** argv, config& cfg) {
+        using builders::ilogger_builder;
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg{argv[i]};
+            bool has_value = i + 1 < argc;
+            if (arg == "--speed" && has_value) {
+                cfg.speed = std::strtod(argv[++i], nullptr);
+            } else if (arg == "-t" && has_value) {
+                cfg.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            } else if (arg == "-n" && has_value) {
+                cfg.limit = std::strtol(argv[++i], nullptr, 10);
+            } else if (arg == "--dir" && has_value) {
+                cfg.directory = argv[++i];
+            } else if (arg == "--keep-prefix") {
+                cfg.keep_prefix = true;
+            } else if (arg == "--null") {
+                cfg.has_sink = true;
+                cfg.pipeline.emplace_back([](ilogger_builder& b) { b.with_writer(std::make_unique<null_writer>()); });
+            } else if (arg == "--console") {
+                cfg.has_sink = true;
+                cfg.pipeline.emplace_back([](ilogger_builder& b) { b.with_console_output(); });
+            } else if (arg == "--file" && has_value) {
+                // NAME or NAME,TYPE
+                std::string name{argv[++i]};
+                auto type = ilogger_builder::file_output_type::stream;
+                if (auto comma = name.find(','); comma != std::string::npos) {
+                    if (!parse_sink_type(std::string_view{name}.substr(comma + 1), type)) {
+                        return false;
+                    }
+                    name.resize(comma);
+                }
+                cfg.has_sink = true;
+                cfg.pipeline.emplace_back([name, type](ilogger_builder& b) { b.with_file_output(name, type); });
+            } else if (arg == "--rolling" && has_value) {
+                std::chrono::seconds interval{std::strtol(argv[++i], nullptr, 10)};
+                cfg.has_sink = true;
+                cfg.pipeline.emplace_back([interval](ilogger_builder& b) { b.with_rolling_log_with_interval(interval); });
+            } else if (arg == "--socket" && has_value) {
+                std::string path{argv[++i]};
+                cfg.has_sink = true;
+                cfg.pipeline.emplace_back([path](ilogger_builder& b) { b.with_socket_output(path); });
+            } else if (arg == "--shm" && has_value) {
+                std::string name{argv[++i]};
+                cfg.has_sink = true;
+                cfg.pipeline.emplace_back([name](ilogger_builder& b) { b.with_shm_ring_output(name); });
+            } else if (arg == "--timestamp" && has_value) {
+                std::string_view type{argv[++i]};
+                auto stamp = type == "running" ? ilogger_builder::timestamp_type::running_time
+                                               : ilogger_builder::timestamp_type::current_time;
+                if (type != "running" && type != "current") {
+                    return false;
+                }
+                cfg.pipeline.emplace_back([stamp](ilogger_builder& b) { b.with_timestamp(stamp); });
+            } else if (arg == "--clock" && has_value) {
+                std::string_view type{argv[++i]};
+                auto clock = type == "coarse" ? global::clock_type::coarse
+                           : type == "ticker" ? global::clock_type::ticker : global::clock_type::precise;
+                if (type != "coarse" && type != "ticker" && type != "precise") {
+                    return false;
+                }
+                cfg.pipeline.emplace_back([clock](ilogger_builder& b) { b.with_clock(clock); });
+            } else if (arg == "--backtrace" && has_value) {
+                auto records = static_cast<std::size_t>(std::strtoul(argv[++i], nullptr, 10));
+                cfg.pipeline.emplace_back([records](ilogger_builder& b) { b.with_backtrace(records); });
+            } else if (arg == "--buffering" && has_value) {
+                // BYTES,RECORDS,MILLISECONDS
+                char* next = argv[++i];
+                auto bytes = static_cast<std::size_t>(std::strtoul(next, &next, 10));
+                auto count = static_cast<std::size_t>(*next == ',' ? std::strtoul(next + 1, &next, 10) : 0);
+                std::chrono::milliseconds delay{*next == ',' ? std::strtol(next + 1, &next, 10) : 0};
+                if (*next) {
+                    return false;
+                }
+                cfg.pipeline.emplace_back([=](ilogger_builder& b) { b.with_buffering(bytes, count, delay); });
+            } else if (arg == "--async" && has_value) {
+                // block, drop or spill, optionally followed by ,MAX_QUEUED_BYTES
+                std::string_view value{argv[++i]};
+                writers::async_writer::options queueing{};
+                auto comma = value.find(',');
+                auto mode = value.substr(0, comma);
+                if (mode == "block") {
+                    queueing.on_full = writers::async_writer::overflow::block;
+                } else if (mode == "drop") {
+                    queueing.on_full = writers::async_writer::overflow::drop;
+                } else if (mode == "spill") {
+                    queueing.on_full = writers::async_writer::overflow::spill;
+                } else {
+                    return false;
+                }
+                if (comma != std::string_view::npos && !parse_number(value.substr(comma + 1), queueing.max_queued_bytes)) {
+                    return false;
+                }
+                cfg.pipeline.emplace_back([queueing](ilogger_builder& b) { b.with_async(queueing); });
+            } else if (!arg.empty() && arg[0] != '-') {
+                cfg.files.emplace_back(arg);
+            } else {
+                return false;
+            }
+        }
+        return cfg.threads > 0 && cfg.speed >= 0 && (!cfg.files.empty() || !cfg.directory.empty());
+    }
+
+    void usage(const char* self) {
+        std::fprintf(stderr,
+                     "usage: %s [--speed FACTOR] [-t THREADS] [-n MAX_RECORDS] [--keep-prefix] [--dir DIRECTORY] [FILE...]\n"
+                     "          [PIPELINE...]\n"
+                     "  --speed 1 keeps the original timing (default), 2 replays twice as fast, 0 as fast as possible\n"
+                     "  --dir replays the files rolled by lg_logger in DIRECTORY in roll order\n"
+                     "  -t spreads the records round robin over THREADS logging threads\n"
+                     "pipeline, applied in order like the logger_builder calls (the default is --null):\n"
+                     "  sinks:      --null  --console  --file NAME[,stream|fd|fd_dsync|uring]  --rolling SECONDS\n"
+                     "              --socket PATH  --shm NAME\n"
+                     "  decorators: --timestamp current|running  --backtrace RECORDS  --clock precise|coarse|ticker\n"
+                     "  for the sinks that follow: --buffering BYTES,RECORDS,MS  --async block|drop|spill[,BYTES]\n",
+                     self);
+    }
+
+    double us(std::uint64_t ns) {
+        return static_cast<double>(ns) / 1e3;
+    }
+}
+
+int main(int argc, char** argv) {
+    config cfg{};
+    if (!parse_args(argc, argv, cfg)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (!cfg.directory.empty()) {
+        for (const auto& file : logtools::find_rolled_files(cfg.directory)) {
+            cfg.files.push_back(file.path);
+        }
+    }
+
+    std::vector<logtools::mapped_range> mappings;
+    std::vector<record> records;
+    for (const auto& path : cfg.files) {
+        load(path, cfg, mappings, records);
+    }
+    if (records.empty()) {
+        std::fprintf(stderr, "logreplay: no records found\n");
+        return EXIT_FAILURE;
+    }
+    if (cfg.speed > 0 && !schedule(records)) {
+        std::fprintf(stderr, "logreplay: the records carry no time, replaying as fast as possible\n");
+        cfg.speed = 0;
+    }
+
+    std::size_t bytes = 0;
+    for (const auto& r : records) {
+        bytes += r.text.size() + 1;
+    }
+
+    auto builder = builders::default_builder();
+    builder.with_stats(STATS_NAME);
+    for (const auto& step : cfg.pipeline) {
+        step(builder);
+    }
+    if (!cfg.has_sink) {
+        builder.with_writer(std::make_unique<null_writer>());
+    }
+    auto logger = builder.get();
+
+    metrics::latency_histogram latency;
+    metrics::latency_histogram lag;
+    auto start = clock_type::now() + std::chrono::milliseconds{10};
+    {
+        std::vector<std::jthread> threads;
+        for (unsigned t = 0; t < cfg.threads; ++t) {
+            threads.emplace_back([&, t] {
+                for (auto i = static_cast<std::size_t>(t); i < records.size(); i += cfg.threads) {
+                    const auto& r = records[i];
+                    if (cfg.speed > 0) {
+                        auto due = start + std::chrono::nanoseconds{
+                            static_cast<std::int64_t>(static_cast<double>(r.time) / cfg.speed)};
+                        auto now = clock_type::now();
+                        if (now < due) {
+                            std::this_thread::sleep_until(due);
+                            now = clock_type::now();
+                        }
+                        lag.record(now - due);
+                    } else {
+                        std::this_thread::sleep_until(start);
+                    }
+
+                    auto t0 = clock_type::now();
+                    logger->log(loggers::level::info, r.text);
+                    latency.record(clock_type::now() - t0);
+                }
+            });
+        }
+    }
+    auto submitted = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    // the sinks' counters, taken before the logger is gone
+    metrics::logger_stats stats{};
+    for (auto& s : metrics::registry::get_instance().snapshot()) {
+        if (s.name == STATS_NAME) {
+            stats = std::move(s);
+        }
+    }
+    logger.reset();
+    auto drained = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    auto calls = latency.snapshot();
+    std::printf("replayed %zu records (%zu bytes) from %zu files with %u threads, ",
+                records.size(), bytes, cfg.files.size(), cfg.threads);
+    if (cfg.speed > 0) {
+        std::printf("speed x%g\n", cfg.speed);
+    } else {
+        std::printf("full speed\n");
+    }
+    std::printf("submitted in %.3f s: %.0f records/s, %.1f MB/s; drained after %.3f s\n",
+                submitted, static_cast<double>(records.size()) / submitted,
+                static_cast<double>(bytes) / submitted / 1e6, drained);
+    std::printf("log() latency us: p50 %.2f  p90 %.2f  p99 %.2f  p99.9 %.2f  max %.2f\n",
+                us(calls.percentile(50)), us(calls.percentile(90)), us(calls.percentile(99)),
+                us(calls.percentile(99.9)), us(calls.max()));
+    if (cfg.speed > 0) {
+        auto late = lag.snapshot();
+        std::printf("behind schedule us: p50 %.2f  p99 %.2f  max %.2f\n",
+                    us(late.percentile(50)), us(late.percentile(99)), us(late.max()));
+    }
+
+    std::printf("%-24s %12s %10s %10s %14s\n", "sink", "records", "drops", "errors", "write_p99_us");
+    for (const auto& sink : stats.sinks) {
+        std::printf("%-24s %12llu %10llu %10llu %14.2f\n", sink.name.c_str(),
+                    static_cast<unsigned long long>(sink.records), static_cast<unsigned long long>(sink.drops),
+                    static_cast<unsigned long long>(sink.errors), us(sink.write_latency.percentile(99)));
+    }
+    std::printf("%-24s %12llu %10llu %10llu\n", "total", static_cast<unsigned long long>(stats.records),
+                static_cast<unsigned long long>(stats.drops), static_cast<unsigned long long>(stats.errors));
+    return EXIT_SUCCESS;
+}
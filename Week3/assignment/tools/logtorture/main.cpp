@@ -0,0 +1,210 @@
+//
+// logtorture - adds and removes sinks of a multi_writer while many threads log through it.
+// Every sink checks that it only receives whole records and that the records of each thread arrive in
+// order; the sink that stays for the whole run has to receive every record exactly once. Run it with the
+// address sanitizer to catch sinks that are used after they were reclaimed.
+//
+
+#include "logger.h"
+#include "multi_writer.h"
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    constexpr std::uint32_t ALIVE = 0x5a5a5a5a;
+
+    std::atomic<long> live_sinks{0};
+    std::atomic<long> failures{0};
+
+    void fail(const char* what, std::string_view detail) {
+        if (failures.fetch_add(1) < 10) {
+            std::fprintf(stderr, "logtorture: %s: '%.*s'\n", what, static_cast<int>(detail.size()), detail.data());
+        }
+    }
+
+    class checking_writer : public io::itext_writer {
+    public:
+        explicit checking_writer(unsigned threads) : m_last(threads, -1) {
+            live_sinks.fetch_add(1);
+        }
+
+        ~checking_writer() override {
+            m_alive = 0;
+            live_sinks.fetch_sub(1);
+        }
+
+        using io::itext_writer::operator<<;
+
+        itext_writer& operator<<(std::string_view view) override {
+            check(view);
+            return *this;
+        }
+
+        itext_writer& operator<<(const char* string) override {
+            check(string);
+            return *this;
+        }
+
+        itext_writer& operator<<(char c) override {
+            check({&c, 1});
+            return *this;
+        }
+
+        itext_writer& operator<<(int) override {
+            fail("unexpected int token", "<int>");
+            return *this;
+        }
+
+        itext_writer& operator<<(io::flush_t) override {
+            return *this;
+        }
+
+        long records() const noexcept { return m_records; }
+
+    private:
+        // records look like "T<thread> <sequence>\n"
+        void check(std::string_view record) {
+            if (m_alive != ALIVE) {
+                fail("write to a destroyed sink", record);
+                return;
+            }
+            if (m_writing.exchange(true)) {
+                fail("concurrent writes to one sink", record);
+            }
+
+            unsigned thread = 0;
+            long sequence = 0;
+            auto end = record.data() + record.size();
+            // the shape is checked first, so the numbers are only parsed within the record
+            bool torn = record.size() < 5 || record.front() != 'T' || record.back() != '\n';
+            if (!torn) {
+                auto parsed_thread = std::from_chars(record.data() + 1, end, thread);
+                torn = parsed_thread.ec != std::errc{} || parsed_thread.ptr == end || *parsed_thread.ptr != ' ';
+                if (!torn) {
+                    auto parsed_sequence = std::from_chars(parsed_thread.ptr + 1, end, sequence);
+                    torn = parsed_sequence.ec != std::errc{} || parsed_sequence.ptr + 1 != end
+                           || thread >= m_last.size();
+                }
+            }
+            if (torn) {
+                fail("torn record", record);
+            } else if (sequence <= m_last[thread]) {
+                fail("record out of order", record);
+            } else {
+                m_last[thread] = sequence;
+            }
+
+            ++m_records;
+            m_writing.store(false);
+        }
+
+        std::uint32_t m_alive = ALIVE;
+        std::atomic<bool> m_writing{false};
+        std::vector<long> m_last;
+        long m_records = 0;
+    };
+
+    struct config {
+        unsigned threads = 16;
+        long records = 100000;
+    };
+
+    bool parse_args(int argc, char** argv, config& cfg) {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg{argv[i]};
+            if (arg == "-t" && i + 1 < argc) {
+                cfg.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            } else if (arg == "-n" && i + 1 < argc) {
+                cfg.records = std::strtol(argv[++i], nullptr, 10);
+            } else {
+                return false;
+            }
+        }
+        return cfg.threads > 0 && cfg.records > 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    config cfg{};
+    if (!parse_args(argc, argv, cfg)) {
+        std::fprintf(stderr, "usage: %s [-t THREADS] [-n RECORDS_PER_THREAD]\n", argv[0]);
+        return 2;
+    }
+
+    auto base = std::make_unique<checking_writer>(cfg.threads);
+    auto base_sink = base.get();
+
+    auto multi = std::make_unique<writers::multi_writer>();
+    auto sinks = multi.get();
+    sinks->add_writer("base", std::move(base));
+
+    long reconfigurations = 0;
+    {
+        lib::logger logger{std::move(multi)};
+        std::atomic<unsigned> running{cfg.threads};
+
+        std::vector<std::jthread> threads;
+        for (unsigned t = 0; t < cfg.threads; ++t) {
+            threads.emplace_back([&, t] {
+                char record[32];
+                record[0] = 'T';
+                for (long i = 0; i < cfg.records; ++i) {
+                    auto end = std::to_chars(record + 1, record + sizeof(record), t).ptr;
+                    *end++ = ' ';
+                    end = std::to_chars(end, record + sizeof(record), i).ptr;
+                    logger.log(std::string_view{record, static_cast<std::size_t>(end - record)});
+                }
+                running.fetch_sub(1);
+            });
+        }
+
+        // keep a few extra sinks around and replace them as fast as possible
+        auto t0 = std::chrono::steady_clock::now();
+        for (long i = 0; running.load() > 0; ++i) {
+            sinks->add_writer("extra" + std::to_string(i), std::make_unique<checking_writer>(cfg.threads));
+            if (i >= 4) {
+                sinks->remove_writer("extra" + std::to_string(i - 4));
+            }
+            if (i == 100) {
+                sinks->enable_metrics();
+            }
+            if (i % 64 == 0) {
+                sinks->stats();
+            }
+            ++reconfigurations;
+        }
+
+        threads.clear();
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::printf("%u threads, %ld records, %ld sink set changes in %.2f s\n",
+                    cfg.threads, cfg.threads * cfg.records, reconfigurations, elapsed);
+
+        auto expected = static_cast<long>(cfg.threads) * cfg.records;
+        if (base_sink->records() != expected) {
+            std::fprintf(stderr, "logtorture: base sink got %ld of %ld records\n", base_sink->records(), expected);
+            failures.fetch_add(1);
+        }
+    }
+
+    if (live_sinks.load() != 0) {
+        std::fprintf(stderr, "logtorture: %ld sinks were never destroyed\n", live_sinks.load());
+        failures.fetch_add(1);
+    }
+
+    if (failures.load()) {
+        std::fprintf(stderr, "logtorture: FAILED (%ld problems)\n", failures.load());
+        return EXIT_FAILURE;
+    }
+    std::printf("logtorture: OK\n");
+    return EXIT_SUCCESS;
+}